@@ -0,0 +1,200 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// An index of the files in SPIFFS, built once at startup, so that static
+// requests are answered without SPIFFS.exists() probes (each one a walk of
+// the object lookup pages) and with an ETag.
+//
+// Each entry has the path the browser asks for, the file that is served
+// for it (path.gz if there is one), its size and a hash of its contents.
+// The ETag is the hash, so a browser reloading the page sends it back in
+// If-None-Match and gets a 304 instead of bootstrap and jQuery all over
+// again.
+//
+// If there is an ASSET_BUNDLE_PATH, made by tools/mkbundle.py, its
+// directory is read first: the web app packed into one file, entries
+// gzipped where that helps, with their hashes worked out by the tool.  An entry is served
+// straight from its offset in the bundle.  Files in SPIFFS under the same
+// path replace bundle entries, so one file can still be changed with the
+// /edit page.
+//
+// The index is rebuilt when a file is uploaded, created or deleted
+// through /edit.
+
+#define ASSET_INDEX_SIZE 40
+#define ASSET_PATH_SIZE 32 // SPIFFS_OBJ_NAME_LEN
+#define ASSET_BUNDLE_PATH "/assets.bin"
+#define ASSET_BUNDLE_MAGIC "AST1"
+#define ASSET_BUNDLE_ENTRY_SIZE (ASSET_PATH_SIZE + 16)
+#define ASSET_BUNDLE_GZIP 0x01
+
+struct Asset {
+  char path[ASSET_PATH_SIZE];
+  uint32_t offset; // in the bundle
+  uint32_t size;
+  uint32_t hash;
+  bool gzip; // served from path.gz, or gzipped in the bundle
+  bool bundled;
+};
+
+Asset assets[ASSET_INDEX_SIZE];
+uint8_t assetCount = 0;
+uint32_t assetBytes = 0;
+
+uint32_t assetRequests = 0;
+uint32_t assetNotModified = 0;
+
+// FNV-1a, over the whole file
+uint32_t hashAssetFile(File& file)
+{
+  uint32_t hash = 2166136261UL;
+  uint8_t buffer[256];
+  size_t length;
+  while ((length = file.read(buffer, sizeof(buffer))) > 0) {
+    for (size_t i = 0; i < length; i++)
+      hash = (hash ^ buffer[i]) * 16777619UL;
+  }
+  return hash;
+}
+
+Asset* findAsset(const char* path)
+{
+  for (uint8_t i = 0; i < assetCount; i++) {
+    if (strcmp(assets[i].path, path) == 0)
+      return &assets[i];
+  }
+  return NULL;
+}
+
+uint32_t readAssetBundleWord(const uint8_t* bytes)
+{
+  return bytes[0] | (bytes[1] << 8) | ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+}
+
+// Add the bundle's directory to the index.  Only the directory is read.
+void loadAssetBundle()
+{
+  File file = SPIFFS.open(ASSET_BUNDLE_PATH, "r");
+  if (!file)
+    return;
+
+  uint8_t header[8];
+  if (file.read(header, sizeof(header)) != sizeof(header) || memcmp(header, ASSET_BUNDLE_MAGIC, 4) != 0) {
+    Serial.printf("Assets: %s is not a bundle\n", ASSET_BUNDLE_PATH);
+    file.close();
+    return;
+  }
+
+  uint16_t count = header[4] | (header[5] << 8);
+  uint16_t entrySize = header[6] | (header[7] << 8);
+  uint32_t size = file.size();
+
+  for (uint16_t i = 0; i < count && assetCount < ASSET_INDEX_SIZE; i++) {
+    uint8_t entry[ASSET_BUNDLE_ENTRY_SIZE];
+    if (entrySize < sizeof(entry) || !file.seek(sizeof(header) + i * entrySize, SeekSet) ||
+        file.read(entry, sizeof(entry)) != sizeof(entry))
+      break;
+
+    Asset& asset = assets[assetCount];
+    memcpy(asset.path, entry, ASSET_PATH_SIZE);
+    asset.path[ASSET_PATH_SIZE - 1] = 0;
+    asset.offset = readAssetBundleWord(entry + ASSET_PATH_SIZE);
+    asset.size = readAssetBundleWord(entry + ASSET_PATH_SIZE + 4);
+    asset.hash = readAssetBundleWord(entry + ASSET_PATH_SIZE + 8);
+    asset.gzip = entry[ASSET_PATH_SIZE + 12] & ASSET_BUNDLE_GZIP;
+    asset.bundled = true;
+
+    if (asset.offset > size || asset.size > size - asset.offset)
+      continue; // cut short by an upload that didn't finish
+
+    assetCount++;
+    assetBytes += asset.size;
+  }
+
+  file.close();
+}
+
+void buildAssetIndex()
+{
+  uint32_t start = millis();
+  assetCount = 0;
+  assetBytes = 0;
+
+  loadAssetBundle();
+  uint8_t bundled = assetCount;
+
+  Dir dir = SPIFFS.openDir("/");
+  while (dir.next()) {
+    String name = dir.fileName();
+    if (name == ASSET_BUNDLE_PATH)
+      continue;
+    bool gzip = name.endsWith(".gz");
+    String path = gzip ? name.substring(0, name.length() - 3) : name;
+    if (path.length() >= ASSET_PATH_SIZE)
+      continue;
+
+    Asset* asset = findAsset(path.c_str());
+    if (asset && !asset->bundled && !gzip)
+      continue; // path.gz is served instead
+
+    if (!asset) {
+      if (assetCount == ASSET_INDEX_SIZE) {
+        Serial.printf("Assets: index full, %s left out\n", path.c_str());
+        continue;
+      }
+      asset = &assets[assetCount++];
+      strcpy(asset->path, path.c_str());
+    }
+    else {
+      assetBytes -= asset->size;
+    }
+
+    File file = dir.openFile("r");
+    asset->offset = 0;
+    asset->size = file.size();
+    asset->hash = hashAssetFile(file);
+    asset->gzip = gzip;
+    asset->bundled = false;
+    file.close();
+    assetBytes += asset->size;
+  }
+
+  Serial.printf("Assets: %u files (%u from %s), %u bytes, indexed in %u ms\n",
+                assetCount, bundled, ASSET_BUNDLE_PATH, assetBytes, (unsigned) (millis() - start));
+}
+
+// Open the file asset is served from, at the start of its contents.
+File openAsset(const Asset& asset)
+{
+  if (asset.bundled) {
+    File file = SPIFFS.open(ASSET_BUNDLE_PATH, "r");
+    if (file)
+      file.seek(asset.offset, SeekSet);
+    return file;
+  }
+
+  String path = asset.path;
+  if (asset.gzip)
+    path += ".gz";
+  return SPIFFS.open(path, "r");
+}
+
+// "0123abcd", quotes included
+void formatAssetEtag(char* text, size_t size, const Asset& asset)
+{
+  snprintf(text, size, "\"%08x\"", asset.hash);
+}
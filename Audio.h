@@ -39,6 +39,12 @@
 #define GAINUPPERLIMIT 15.0
 #define GAINLOWERLIMIT 0.1
 
+// NOISEFLOOR and AGCSMOOTH are only the defaults, both can be tuned at run
+// time through the noiseFloor and agcSmooth fields
+uint8_t noiseFloor = NOISEFLOOR;
+uint8_t agcSmoothThousandths = AGCSMOOTH * 1000;
+float agcSmooth = AGCSMOOTH;
+
 #define NUM_LAYERS 3
 byte CentreX =  (kMatrixWidth / 2) - 1;
 byte CentreY = (kMatrixHeight / 2) - 1;
@@ -50,7 +56,7 @@ uint8_t bandOffset = 3;
 uint8_t levelsPerVerticalPixel =  1024 / kMatrixHeight;
 uint8_t levelsPerHue = 1024 / 256;
 const uint8_t bandCount = 7;
-bool drawPeaks = true;
+uint8_t drawPeaks = 1;
 unsigned int spectrumValue[7];  // holds raw adc values
 float spectrumDecay[7] = {0};   // holds time-averaged values
 float spectrumPeaks[7] = {0};   // holds peak values
@@ -96,10 +102,10 @@ void readAudio() {
     digitalWrite(MSGEQ7_STROBE_PIN, HIGH);
 
     // noise floor filter
-    if (spectrumValue[i] < NOISEFLOOR) {
+    if (spectrumValue[i] < noiseFloor) {
       spectrumValue[i] = 0;
     } else {
-      spectrumValue[i] -= NOISEFLOOR;
+      spectrumValue[i] -= noiseFloor;
     }
 
     // apply correction factor per frequency bin
@@ -122,7 +128,7 @@ void readAudio() {
   }
 
   // Calculate audio levels for automatic gain
-  audioAvg = (1.0 - AGCSMOOTH) * audioAvg + AGCSMOOTH * (analogsum / 7.0);
+  audioAvg = (1.0 - agcSmooth) * audioAvg + agcSmooth * (analogsum / 7.0);
 
   spectrumAvg = (analogsum / 7.0) / 4;
 
@@ -132,9 +138,10 @@ void readAudio() {
   if (gainAGC < GAINLOWERLIMIT) gainAGC = GAINLOWERLIMIT;
 }
 
-// Attempt at beat detection
+// Attempt at beat detection, run once per audio read from loop()
 byte beatTriggered = 0;
-#define beatLevel 20.0
+bool audioBeat = false;
+uint8_t beatLevel = 20; // see PatternParams.h
 #define beatDeadzone 30.0
 #define beatDelay 50
 float lastBeatVal = 0;
@@ -142,7 +149,7 @@ byte beatDetect() {
   static float beatAvg = 0;
   static unsigned long lastBeatMillis;
   float specCombo = (spectrumDecay[0] + spectrumDecay[1]) / 2.0;
-  beatAvg = (1.0 - AGCSMOOTH) * beatAvg + AGCSMOOTH * specCombo;
+  beatAvg = (1.0 - agcSmooth) * beatAvg + agcSmooth * specCombo;
 
   if (lastBeatVal < beatAvg) lastBeatVal = beatAvg;
   if ((specCombo - beatAvg) > beatLevel && beatTriggered == 0 && currentMillis - lastBeatMillis > beatDelay) {
@@ -341,7 +348,7 @@ void beatWaves()
 {
   fade_down(2);
 
-  if (beatDetect()) {
+  if (audioBeat) {
     leds[CENTER_LED] = CRGB::Red;
   }
 
@@ -356,7 +363,7 @@ void beatWaves()
 }
 
 
-#define VUFadeFactor 5
+uint8_t VUFadeFactor = 5; // see PatternParams.h
 #define VUScaleFactor 2.0
 #define VUPaletteFactor 1.5
 void drawVU() {
@@ -447,57 +454,35 @@ void DrawOneFrame( byte startHue8, int8_t yHueDelta8, int8_t xHueDelta8)
   }
 }
 
-void radiate() {
-  
-  //HALF_POS = beatsin8(40, 30 + SPEED, 80 + SPEED);
-  int MILLISECONDS  = 0;
-  //  EVERY_N_MILLISECONDS(50) {
-  //    hue++;
-  //    if ( hue > 255) hue = 0;
-  //  }
-uint8_t zero_l, three_l, six_l, zero_r, three_r, six_r;
-
-  zero_l  = spectrumByte[0];
-  three_l = spectrumByte[3];
-  six_l   = spectrumByte[6];
-
-  zero_r  = spectrumByte[0];
-  three_r = spectrumByte[3];
-  six_r   = spectrumByte[6];
-
-  leds[CENTER_LED] = CRGB(zero_l, three_l, six_l);
-  leds[CENTER_LED + 1] = CRGB(zero_r, three_r, six_r);
-  //leds[HALF_POS].fadeToBlackBy(30);
+// radiate() keeps its state in rings rather than in leds[]: ring 0 is the
+// centre, each channel moves outward at its own rate, and every LED shows the
+// ring at its precomputed radius, so it works for any layout.
+#define RADIATE_RINGS (NUM_LEDS / 2)
+CRGB radiateRings[RADIATE_RINGS];
 
+void radiate() {
+  radiateRings[0] = CRGB(spectrumByte[0], spectrumByte[3], spectrumByte[6]);
 
   EVERY_N_MILLISECONDS(11) {
-    for (int i = NUM_LEDS - 1; i > CENTER_LED + 1; i--) {
-      leds[i].blue = leds[i - 1].blue;
-    }
-    for (int i = 0; i < CENTER_LED; i++) {
-      leds[i].blue = leds[i + 1].blue;
+    for (int i = RADIATE_RINGS - 1; i > 0; i--) {
+      radiateRings[i].blue = radiateRings[i - 1].blue;
     }
   }
   EVERY_N_MILLISECONDS(27) {
-    for (int i = NUM_LEDS - 1; i > CENTER_LED + 1; i--) {
-      leds[i].green = leds[i - 1].green;
-    }
-    for (int i = 0; i < CENTER_LED; i++) {
-      leds[i].green = leds[i + 1].green;
+    for (int i = RADIATE_RINGS - 1; i > 0; i--) {
+      radiateRings[i].green = radiateRings[i - 1].green;
     }
   }
   EVERY_N_MILLISECONDS(52) {
-    for (int i = NUM_LEDS - 1; i > CENTER_LED + 1; i--) {
-      leds[i].red = leds[i - 1].red;
-    }
-    for (int i = 0; i < CENTER_LED; i++) {
-      leds[i].red = leds[i + 1].red;
+    for (int i = RADIATE_RINGS - 1; i > 0; i--) {
+      radiateRings[i].red = radiateRings[i - 1].red;
     }
   }
 
-  EVERY_N_MILLISECONDS(2) {
-    //blur1d(leds, NUM_LEDS, 1);
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    leds[i] = radiateRings[scale8(layoutRadius[i], RADIATE_RINGS - 1)];
   }
+  layoutClearRest(leds, MATRIX);
 }
 
 void flex_mono() {
@@ -559,7 +544,7 @@ float fhue;
 }
 
 void rain() {
-  uint8_t hue;
+  static uint8_t hue = 0;
 
   // increase raindrop hue value - there are other ways to color the rain, though
   EVERY_N_MILLISECONDS(200){ hue++; }
@@ -813,186 +798,6 @@ void audioFire() {
 
 }
 
-void rainbowAudioNoise() {
-  static int lastPeak0 = 0;
-
-  noisespeedx = 0;
-
-
-    noisespeedx =  spectrumByte[0] ;
-    // noisespeedy =  spectrumByte[6] ;
-
-
-
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 30;
-  colorLoop = 1;
-  drawNoise(RainbowColors_p);
-}
-
-void rainbowStripeAudioNoise() {
-
-
-  noisespeedy = 0;
-
-
-    noisespeedx =  spectrumByte[0];
-  
-
-
-
-  //noisespeedx = 0;
-  noisespeedz = 0;
-  noisescale = 20;
-  colorLoop = 1;
-  drawNoise(RainbowStripeColors_p);
-}
-
-void partyAudioNoise() {
-
-  noisespeedx = 0;
-
-
-    noisespeedx =  spectrumByte[0];
-
-
-
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 30;
-  colorLoop = 1;
-  drawNoise(PartyColors_p);
-}
-
-void forestAudioNoise() {
-
-
-  noisespeedx = 0;
-
-    noisespeedx =  spectrumByte[0];
-  
-
-
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 120;
-  colorLoop = 1;
-  drawNoise(ForestColors_p);
-}
-
-void cloudAudioNoise() {
-
-  noisespeedx = 0;
-
-    noisespeedx =  spectrumByte[0] ;
-
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 30;
-  colorLoop = 1;
-  drawNoise(CloudColors_p);
-}
-
-void fireAudioNoise() {
-
-
-  noisespeedx = 0;
-  noisespeedz = 0;
-
-
-    noisespeedx =  spectrumByte[0] ;
-  
-
-
-    noisespeedz =  spectrumByte[6] ;
-  
-
-
-
-  noisespeedy = 0;
-  noisescale = 50;
-  colorLoop = 1;
-
-  drawNoise(HeatColors_p, 60);
-}
-
-void lavaAudioNoise() {
-
-
-  noisespeedy = 0;
-  noisespeedz = 0;
-
- 
-    noisespeedy = spectrumByte[0] ;
-  
-
-    noisespeedz = spectrumByte[6] ;
-  
-
-
-
-  noisespeedx = 0;
-  noisescale = 50;
-  colorLoop = 1;
-  drawNoise(LavaColors_p);
-}
-
-void oceanAudioNoise() {
-
-
-  noisespeedy = 0;
-
-
-    noisespeedy =  spectrumByte[0] ;
-  
-
-
-
-  noisespeedx = 0;
-  noisespeedz = 0;
-  noisescale = 90;
-  colorLoop = 1;
-  drawNoise(OceanColors_p);
-}
-
-void blackAndWhiteAudioNoise() {
-  SetupBlackAndWhiteStripedPalette();
-
-
-  noisespeedy = 0;
-
-
-    noisespeedy =  spectrumByte[0]/2 ;
-  
-
-
-
-  noisespeedx = 0;
-  noisespeedz = 0;
-  noisescale = 15;
-  colorLoop = 0;
-   drawNoise(blackAndWhiteStripedPalette);
-}
-
-void blackAndBlueAudioNoise() {
-  SetupBlackAndBlueStripedPalette();
-
-
-  noisespeedx = 0;
-
-
-    noisespeedx =  spectrumByte[0] ;
-  
-
-
-
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 45;
-  colorLoop = 1;
-  drawNoise(blackAndBlueStripedPalette);
-}
 void adjust_gamma()
 {
   for (uint16_t i = 0; i < NUM_LEDS; i++)
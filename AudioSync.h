@@ -0,0 +1,364 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Share one MSGEQ7 between several nodes.  The node with the board is set to
+// master: after every readAudio() it multicasts what the audio patterns use
+// to AUDIO_SYNC_GROUP.  Nodes set to slave skip readAudio() and take their
+// spectrum from those packets instead.
+//
+// Packet, AUDIO_SYNC_PACKET_SIZE bytes, 16 bit values little endian:
+//
+//   'A' 'S' version  magic, then AUDIO_SYNC_VERSION
+//   beats            count of beats detected, so a lost packet can't lose one
+//   sequence         16 bits
+//   time             32 bits, the master's millis() when it was read
+//   value[7]         spectrumValue
+//   decay[7]         spectrumDecay
+//   peaks[7]         spectrumPeaks
+//   audioAvg
+//   gainAGC          fixed point, 256 = 1.0
+//   spectrumAvg      8 bits
+//
+// Slaves hold packets in a small jitter buffer and play each one out
+// AUDIO_SYNC_PLAYOUT_DELAY ms after the quickest it has been seen to arrive,
+// so the spectrum moves as smoothly as on the master even when WiFi bunches
+// packets up.  Packets that turn up after a newer one has been played are
+// dropped.  When nothing is due for a couple of master frames, the last
+// spectrum is faded out a frame at a time rather than frozen; after
+// AUDIO_SYNC_TIMEOUT ms with no packets at all it is silence.
+
+#define AUDIO_SYNC_PORT 7012
+#define AUDIO_SYNC_VERSION 1
+#define AUDIO_SYNC_PACKET_SIZE 57
+
+// at most one packet every AUDIO_SYNC_INTERVAL ms from the master
+#define AUDIO_SYNC_INTERVAL 10
+#define AUDIO_SYNC_FRAMES 8 // jitter buffer, a power of two
+#define AUDIO_SYNC_PLAYOUT_DELAY 30
+#define AUDIO_SYNC_TIMEOUT 1000
+// transit time is the smallest seen over this many packets, so it can follow
+// the two clocks drifting apart
+#define AUDIO_SYNC_TRANSIT_WINDOW 256
+// each concealed frame keeps this much of the last one, out of 256
+#define AUDIO_SYNC_CONCEAL_FADE 200
+
+enum AudioSyncMode {
+  AudioSyncOff,
+  AudioSyncMaster,
+  AudioSyncSlave,
+  AudioSyncModeCount
+};
+
+const char* audioSyncModeNames[AudioSyncModeCount] = { "Off", "Master", "Slave" };
+
+IPAddress audioSyncGroup(239, 255, 70, 12);
+WiFiUDP audioSyncUdp;
+
+uint8_t audioSyncMode = AudioSyncOff;
+uint8_t audioSyncStarted = AudioSyncOff; // the mode the socket was opened for
+
+struct AudioSyncFrame {
+  bool ready;
+  uint8_t beats;
+  uint16_t sequence;
+  uint32_t time;
+  uint16_t value[7];
+  uint16_t decay[7];
+  uint16_t peaks[7];
+  uint16_t audioAvg;
+  uint16_t gain;
+  uint8_t spectrumAvg;
+};
+
+// master
+uint16_t audioSyncSequence = 0;
+uint8_t audioSyncBeats = 0;
+uint32_t audioSyncLastSent = 0;
+
+// slave
+AudioSyncFrame audioSyncFrames[AUDIO_SYNC_FRAMES];
+bool audioSyncPlaying = false;
+uint16_t audioSyncPlayed = 0;      // sequence of the last frame played
+uint8_t audioSyncPlayedBeats = 0;
+uint32_t audioSyncLastPlayed = 0;  // local millis() it was played
+uint32_t audioSyncLastReceived = 0;
+uint32_t audioSyncNextConceal = 0;
+uint16_t audioSyncInterval = AUDIO_SYNC_INTERVAL; // between master frames, ms
+
+int32_t audioSyncTransit = 0;      // local arrival time - master time, smallest seen
+int32_t audioSyncWindowTransit = 0;
+uint16_t audioSyncWindowCount = 0;
+
+// for /metrics, see Metrics.h
+uint32_t audioSyncSent = 0;
+uint32_t audioSyncReceived = 0;
+uint32_t audioSyncLate = 0;
+uint32_t audioSyncLost = 0;
+uint32_t audioSyncConcealed = 0;
+
+uint8_t* writeAudioSync16(uint8_t* out, float value)
+{
+  uint16_t v = value <= 0 ? 0 : value >= 65535 ? 65535 : (uint16_t) value;
+  *out++ = v & 0xFF;
+  *out++ = v >> 8;
+  return out;
+}
+
+const uint8_t* readAudioSync16(const uint8_t* in, uint16_t& value)
+{
+  value = in[0] | (in[1] << 8);
+  return in + 2;
+}
+
+// (Re)open the socket when the mode has changed, once there is a network
+// to open it on, or close it for Off.  Called by setAudioSync() and every
+// frame by the master and slave.  Returns true when it is open for the
+// current mode.
+bool startAudioSync()
+{
+  if (audioSyncStarted == audioSyncMode)
+    return audioSyncMode != AudioSyncOff;
+
+  if (audioSyncStarted != AudioSyncOff) {
+    audioSyncUdp.stop();
+    audioSyncStarted = AudioSyncOff;
+  }
+
+  if (audioSyncMode == AudioSyncOff)
+    return false;
+
+  if (!apMode && WiFi.status() != WL_CONNECTED)
+    return false;
+
+  IPAddress localIP = apMode ? WiFi.softAPIP() : WiFi.localIP();
+
+  if (audioSyncMode == AudioSyncMaster) {
+    // nothing to bind, beginPacketMulticast() makes the socket
+    Serial.printf("Audio sync master, sending to %s:%u\n", audioSyncGroup.toString().c_str(), AUDIO_SYNC_PORT);
+  }
+  else {
+    audioSyncUdp.beginMulticast(localIP, audioSyncGroup, AUDIO_SYNC_PORT);
+    audioSyncReceived = 0;
+    Serial.printf("Audio sync slave, listening on %s:%u\n", audioSyncGroup.toString().c_str(), AUDIO_SYNC_PORT);
+  }
+
+  audioSyncStarted = audioSyncMode;
+  return true;
+}
+
+// Master: called after every readAudio() and beatDetect().
+void sendAudioSync()
+{
+  audioSyncBeats += audioBeat;
+
+  if (!startAudioSync())
+    return;
+
+  uint32_t now = millis();
+  if (now - audioSyncLastSent < AUDIO_SYNC_INTERVAL)
+    return;
+  audioSyncLastSent = now;
+
+  uint8_t packet[AUDIO_SYNC_PACKET_SIZE];
+  uint8_t* out = packet;
+
+  *out++ = 'A';
+  *out++ = 'S';
+  *out++ = AUDIO_SYNC_VERSION;
+  *out++ = audioSyncBeats;
+  out = writeAudioSync16(out, ++audioSyncSequence);
+  *out++ = now & 0xFF;
+  *out++ = (now >> 8) & 0xFF;
+  *out++ = (now >> 16) & 0xFF;
+  *out++ = now >> 24;
+  for (uint8_t i = 0; i < 7; i++)
+    out = writeAudioSync16(out, spectrumValue[i]);
+  for (uint8_t i = 0; i < 7; i++)
+    out = writeAudioSync16(out, spectrumDecay[i]);
+  for (uint8_t i = 0; i < 7; i++)
+    out = writeAudioSync16(out, spectrumPeaks[i]);
+  out = writeAudioSync16(out, audioAvg);
+  out = writeAudioSync16(out, gainAGC * 256);
+  *out++ = spectrumAvg;
+
+  IPAddress localIP = apMode ? WiFi.softAPIP() : WiFi.localIP();
+  audioSyncUdp.beginPacketMulticast(audioSyncGroup, AUDIO_SYNC_PORT, localIP);
+  audioSyncUdp.write(packet, sizeof(packet));
+  if (audioSyncUdp.endPacket())
+    audioSyncSent++;
+}
+
+void receiveAudioSyncPacket(uint32_t now)
+{
+  uint8_t packet[AUDIO_SYNC_PACKET_SIZE];
+  if (audioSyncUdp.read(packet, sizeof(packet)) != AUDIO_SYNC_PACKET_SIZE)
+    return;
+  if (packet[0] != 'A' || packet[1] != 'S' || packet[2] != AUDIO_SYNC_VERSION)
+    return;
+
+  const uint8_t* in = packet + 3;
+  uint8_t beats = *in++;
+  uint16_t sequence;
+  in = readAudioSync16(in, sequence);
+
+  // first packet, or the master has been away (and may have restarted, with
+  // its sequence and clock starting over): start afresh
+  bool lostMaster = audioSyncReceived == 0 || now - audioSyncLastReceived > AUDIO_SYNC_TIMEOUT;
+  if (lostMaster) {
+    audioSyncPlaying = false;
+    for (uint8_t i = 0; i < AUDIO_SYNC_FRAMES; i++)
+      audioSyncFrames[i].ready = false;
+    Serial.printf("Audio sync from %s\n", audioSyncUdp.remoteIP().toString().c_str());
+  }
+
+  if (audioSyncPlaying && (int16_t) (sequence - audioSyncPlayed) <= 0) {
+    audioSyncLate++;
+    return;
+  }
+
+  AudioSyncFrame& frame = audioSyncFrames[sequence & (AUDIO_SYNC_FRAMES - 1)];
+  frame.beats = beats;
+  frame.sequence = sequence;
+  frame.time = in[0] | (in[1] << 8) | ((uint32_t) in[2] << 16) | ((uint32_t) in[3] << 24);
+  in += 4;
+  for (uint8_t i = 0; i < 7; i++)
+    in = readAudioSync16(in, frame.value[i]);
+  for (uint8_t i = 0; i < 7; i++)
+    in = readAudioSync16(in, frame.decay[i]);
+  for (uint8_t i = 0; i < 7; i++)
+    in = readAudioSync16(in, frame.peaks[i]);
+  in = readAudioSync16(in, frame.audioAvg);
+  in = readAudioSync16(in, frame.gain);
+  frame.spectrumAvg = *in;
+  frame.ready = true;
+
+  audioSyncReceived++;
+
+  // the smallest transit time seen is the one with no queueing in it;
+  // frames are played out a fixed delay after that
+  int32_t transit = now - frame.time;
+  if (lostMaster || transit < audioSyncWindowTransit || audioSyncWindowCount == 0)
+    audioSyncWindowTransit = transit;
+  if (lostMaster || transit < audioSyncTransit)
+    audioSyncTransit = transit;
+  if (++audioSyncWindowCount == AUDIO_SYNC_TRANSIT_WINDOW) {
+    audioSyncTransit = audioSyncWindowTransit;
+    audioSyncWindowCount = 0;
+  }
+
+  audioSyncLastReceived = now;
+}
+
+// Play the newest frame that is due.  Returns false if none is.
+bool playAudioSyncFrame(uint32_t now)
+{
+  AudioSyncFrame* due = NULL;
+
+  for (uint8_t i = 0; i < AUDIO_SYNC_FRAMES; i++) {
+    AudioSyncFrame& frame = audioSyncFrames[i];
+    if (!frame.ready)
+      continue;
+
+    if (audioSyncPlaying && (int16_t) (frame.sequence - audioSyncPlayed) <= 0) {
+      frame.ready = false;
+      continue;
+    }
+
+    uint32_t playAt = frame.time + audioSyncTransit + AUDIO_SYNC_PLAYOUT_DELAY;
+    if ((int32_t) (now - playAt) < 0)
+      continue;
+
+    if (!due || (int16_t) (frame.sequence - due->sequence) > 0)
+      due = &frame;
+  }
+
+  if (!due)
+    return false;
+
+  for (uint8_t i = 0; i < 7; i++) {
+    spectrumValue[i] = due->value[i];
+    spectrumDecay[i] = due->decay[i];
+    spectrumPeaks[i] = due->peaks[i];
+    spectrumByte[i] = spectrumValue[i] / 4;
+  }
+  audioAvg = due->audioAvg;
+  gainAGC = due->gain / 256.0;
+  spectrumAvg = due->spectrumAvg;
+
+  if (audioSyncPlaying) {
+    uint16_t skipped = due->sequence - audioSyncPlayed;
+    // frames skipped over were either lost or overtaken by this one
+    audioSyncLost += skipped - 1;
+    if (skipped > 0 && now > audioSyncLastPlayed) {
+      uint16_t interval = (now - audioSyncLastPlayed) / skipped;
+      audioSyncInterval = constrain(interval, AUDIO_SYNC_INTERVAL, 100);
+    }
+    audioBeat = due->beats != audioSyncPlayedBeats;
+  }
+  else {
+    audioBeat = false;
+  }
+
+  audioSyncPlaying = true;
+  audioSyncPlayed = due->sequence;
+  audioSyncPlayedBeats = due->beats;
+  audioSyncLastPlayed = now;
+  audioSyncNextConceal = now + 2 * audioSyncInterval;
+  due->ready = false;
+  return true;
+}
+
+// No frame for a while: fade what we have, one master frame at a time,
+// through the same smoothing readAudio() would apply.
+void concealAudioSyncFrame(uint32_t now)
+{
+  if ((int32_t) (now - audioSyncNextConceal) < 0)
+    return;
+  audioSyncNextConceal = now + audioSyncInterval;
+
+  bool silent = now - audioSyncLastReceived > AUDIO_SYNC_TIMEOUT;
+
+  for (uint8_t i = 0; i < 7; i++) {
+    spectrumValue[i] = silent ? 0 : (spectrumValue[i] * AUDIO_SYNC_CONCEAL_FADE) >> 8;
+    spectrumDecay[i] = (1.0 - SPECTRUMSMOOTH) * spectrumDecay[i] + SPECTRUMSMOOTH * spectrumValue[i];
+    if (spectrumPeaks[i] < spectrumDecay[i]) spectrumPeaks[i] = spectrumDecay[i];
+    spectrumPeaks[i] = spectrumPeaks[i] * (1.0 - PEAKDECAY);
+    spectrumByte[i] = spectrumValue[i] / 4;
+  }
+  spectrumAvg = silent ? 0 : (spectrumAvg * AUDIO_SYNC_CONCEAL_FADE) >> 8;
+
+  if (!silent)
+    audioSyncConcealed++;
+}
+
+// Slave: called instead of readAudio() and beatDetect().
+void receiveAudioSync()
+{
+  audioBeat = false;
+
+  if (!startAudioSync())
+    return;
+
+  uint32_t now = millis();
+
+  while (audioSyncUdp.parsePacket() > 0)
+    receiveAudioSyncPacket(now);
+
+  // nothing to conceal while the first frames wait out the playout delay
+  if (!playAudioSyncFrame(now) && audioSyncPlaying)
+    concealAudioSyncFrame(now);
+}
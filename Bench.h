@@ -0,0 +1,103 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// What each pattern costs on the device itself.  Not in the UI:
+//
+//   GET /bench                each pattern, BENCH_FRAMES frames
+//   GET /bench?frames=500     more frames
+//   GET /bench?pattern=12     just the one
+//
+// Each pattern function is called frames times in a row, on whatever audio
+// and palette there are at the time, and the cycles the calls took are
+// added up; nothing is shown.  The LEDs stop for the length of the run
+// (about a second a pattern for the noise patterns), and then the current
+// pattern carries on.
+//
+// The reply is JSON:
+//
+//   {"frames":100,"cpuMHz":160,"leds":304,"patterns":[
+//     {"index":0,"name":"Pride","cycles":12345678,"cyclesPerFrame":123456},...]}
+//
+// tools/bench.py does the same on the host, for all the patterns of all the
+// sketches.
+
+#define BENCH_FRAMES 100
+#define BENCH_FRAMES_MAX 500 // the cycle count wraps after 26 s at 160 MHz
+
+void handleBench()
+{
+  uint16_t frames = BENCH_FRAMES;
+  if (webServer.hasArg("frames"))
+    frames = constrain(webServer.arg("frames").toInt(), 1, BENCH_FRAMES_MAX);
+
+  uint8_t first = 0;
+  uint8_t last = patternCount - 1;
+  if (webServer.hasArg("pattern")) {
+    first = last = webServer.arg("pattern").toInt();
+    if (first >= patternCount) {
+      webServer.send(404, "text/plain", "No such pattern");
+      return;
+    }
+  }
+
+  uint8_t previous = currentPatternIndex;
+
+  JsonWriter json(webServer);
+  json.begin("application/json");
+  json.print("{\"frames\":");
+  json.print((unsigned int) frames);
+  json.print(",\"cpuMHz\":");
+  json.print((unsigned int) ESP.getCpuFreqMHz());
+  json.print(",\"leds\":");
+  // what FastLED drives, which for a matrix can be more than NUM_LEDS
+  json.print((unsigned int) FastLED.size());
+  json.print(",\"patterns\":[");
+
+  for (uint8_t i = first; i <= last; i++) {
+    // some patterns look at which one is current
+    currentPatternIndex = i;
+
+    uint32_t cycles = 0;
+    for (uint16_t frame = 0; frame < frames; frame++) {
+      uint32_t start = ESP.getCycleCount();
+      patterns[i].pattern();
+      cycles += ESP.getCycleCount() - start;
+
+      // for the watchdog and WiFi
+      if (frame % 10 == 9)
+        yield();
+    }
+
+    if (i != first)
+      json.print(',');
+    json.print("{\"index\":");
+    json.print((unsigned int) i);
+    json.print(",\"name\":");
+    json.printString(patterns[i].name);
+    json.print(",\"cycles\":");
+    json.print((unsigned int) cycles);
+    json.print(",\"cyclesPerFrame\":");
+    json.print((unsigned int) (cycles / frames));
+    json.print('}');
+  }
+
+  json.print("]}");
+  json.end();
+
+  currentPatternIndex = previous;
+  FastLED.clear();
+}
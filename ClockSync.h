@@ -0,0 +1,306 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// A shared millisecond clock for the nodes on a network, so that strips
+// running the same pattern stay in step.  The sketch defines
+// USE_GET_MILLISECOND_TIMER before including FastLED, which makes
+// beatsin8() and friends, EVERY_N_MILLISECONDS and EVERY_N_SECONDS use
+// get_millisecond_timer(), below, instead of millis().
+//
+// Every node multicasts an announce to CLOCK_SYNC_GROUP once a second.  One
+// of them is master, and the others set their clocks to its clock:
+//
+//   - a node that hears a master with a lower chip id than the one it
+//     follows (or than its own, if it is master) follows that one instead
+//   - a node that has heard no master for CLOCK_SYNC_MASTER_TIMEOUT ms, and
+//     no other node with a lower chip id, becomes master, keeping its
+//     clock as it is so nobody else's jumps
+//
+// Followers ask the master for the time, NTP style: the request carries the
+// follower's millis() t1, the response the master's clock t2, and it comes
+// back at t3.  Assuming the two directions take as long as each other, the
+// master's clock read t2 at t1 + rtt / 2.  Of the last CLOCK_SYNC_SAMPLES,
+// the one with the shortest round trip is used, since it has the least
+// queueing in it.
+//
+// The clock is stepped to a new offset only when it is out by more than
+// CLOCK_SYNC_STEP ms, at first sync.  Smaller errors are slewed out 1 ms
+// every CLOCK_SYNC_SLEW_INTERVAL ms, so it never runs backwards and
+// EVERY_N_* timers don't all fire at once.
+//
+// Packet, CLOCK_SYNC_PACKET_SIZE bytes, little endian:
+//
+//   'C' 'K' version type
+//   from      chip id of the sender
+//   to        chip id it is for, 0 for everyone
+//   flags     bit 0: sender is master
+//   time1     request: follower's millis(), response: echoed
+//   time2     announce, response: sender's clock
+
+#define CLOCK_SYNC_PORT 7013
+#define CLOCK_SYNC_VERSION 1
+#define CLOCK_SYNC_PACKET_SIZE 21
+
+#define CLOCK_SYNC_ANNOUNCE 1
+#define CLOCK_SYNC_REQUEST  2
+#define CLOCK_SYNC_RESPONSE 3
+
+#define CLOCK_SYNC_FLAG_MASTER 0x01
+
+#define CLOCK_SYNC_ANNOUNCE_INTERVAL 1000
+#define CLOCK_SYNC_MASTER_TIMEOUT 3500
+// requests come quicker until there are enough samples to pick from
+#define CLOCK_SYNC_REQUEST_INTERVAL 2000
+#define CLOCK_SYNC_FAST_REQUEST_INTERVAL 250
+#define CLOCK_SYNC_SAMPLES 8
+// round trips longer than this say more about the network than the clock
+#define CLOCK_SYNC_MAX_RTT 200
+#define CLOCK_SYNC_STEP 250
+#define CLOCK_SYNC_SLEW_INTERVAL 20
+
+IPAddress clockSyncGroup(239, 255, 70, 13);
+WiFiUDP clockSyncUdp;
+
+bool clockSyncStarted = false;
+uint32_t clockSyncStartMillis = 0;
+uint32_t clockSyncNodeId = 0;
+
+int32_t clockOffset = 0;      // shared clock - millis()
+int32_t clockSyncTarget = 0;  // the offset being slewed towards
+bool clockSynced = false;
+
+bool clockSyncMaster = false;
+uint32_t clockSyncMasterId = 0; // the master followed, 0 for none
+uint32_t clockSyncMasterHeard = 0;
+uint32_t clockSyncLowestPeer = 0; // lowest chip id of the other non-masters
+uint32_t clockSyncLowestPeerHeard = 0;
+
+uint32_t clockSyncLastAnnounce = 0;
+uint32_t clockSyncLastRequest = 0;
+uint32_t clockSyncLastSlew = 0;
+
+int32_t clockSyncSampleOffset[CLOCK_SYNC_SAMPLES];
+uint16_t clockSyncSampleRtt[CLOCK_SYNC_SAMPLES];
+uint8_t clockSyncSampleCount = 0;
+uint8_t clockSyncSampleNext = 0;
+
+uint32_t clockSyncSteps = 0;
+uint16_t clockSyncRtt = 0; // of the sample in use
+
+// The shared clock, in place of millis() wherever nodes should agree.
+uint32_t clockMillis()
+{
+  return millis() + clockOffset;
+}
+
+uint32_t get_millisecond_timer()
+{
+  return clockMillis();
+}
+
+uint8_t* writeClockSync32(uint8_t* out, uint32_t value)
+{
+  *out++ = value & 0xFF;
+  *out++ = (value >> 8) & 0xFF;
+  *out++ = (value >> 16) & 0xFF;
+  *out++ = value >> 24;
+  return out;
+}
+
+uint32_t readClockSync32(const uint8_t* in)
+{
+  return in[0] | (in[1] << 8) | ((uint32_t) in[2] << 16) | ((uint32_t) in[3] << 24);
+}
+
+void sendClockSync(uint8_t type, uint32_t to, uint32_t time1, uint32_t time2)
+{
+  uint8_t packet[CLOCK_SYNC_PACKET_SIZE];
+  uint8_t* out = packet;
+
+  *out++ = 'C';
+  *out++ = 'K';
+  *out++ = CLOCK_SYNC_VERSION;
+  *out++ = type;
+  out = writeClockSync32(out, clockSyncNodeId);
+  out = writeClockSync32(out, to);
+  *out++ = clockSyncMaster ? CLOCK_SYNC_FLAG_MASTER : 0;
+  out = writeClockSync32(out, time1);
+  out = writeClockSync32(out, time2);
+
+  IPAddress localIP = apMode ? WiFi.softAPIP() : WiFi.localIP();
+  clockSyncUdp.beginPacketMulticast(clockSyncGroup, CLOCK_SYNC_PORT, localIP);
+  clockSyncUdp.write(packet, sizeof(packet));
+  clockSyncUdp.endPacket();
+}
+
+void followClockMaster(uint32_t id)
+{
+  if (clockSyncMaster)
+    Serial.printf("Clock sync: %08x is master now\n", id);
+  else
+    Serial.printf("Clock sync: following %08x\n", id);
+
+  clockSyncMaster = false;
+  clockSyncMasterId = id;
+  clockSyncSampleCount = 0;
+  clockSyncSampleNext = 0;
+  clockSyncLastRequest = millis() - CLOCK_SYNC_REQUEST_INTERVAL;
+}
+
+void addClockSample(uint32_t t1, uint32_t t2)
+{
+  uint32_t t3 = millis();
+  uint32_t rtt = t3 - t1;
+  if (rtt > CLOCK_SYNC_MAX_RTT)
+    return;
+
+  clockSyncSampleOffset[clockSyncSampleNext] = (int32_t) (t2 + rtt / 2 - t3);
+  clockSyncSampleRtt[clockSyncSampleNext] = rtt;
+  clockSyncSampleNext = (clockSyncSampleNext + 1) % CLOCK_SYNC_SAMPLES;
+  if (clockSyncSampleCount < CLOCK_SYNC_SAMPLES)
+    clockSyncSampleCount++;
+
+  uint8_t best = 0;
+  for (uint8_t i = 1; i < clockSyncSampleCount; i++) {
+    if (clockSyncSampleRtt[i] < clockSyncSampleRtt[best])
+      best = i;
+  }
+  clockSyncTarget = clockSyncSampleOffset[best];
+  clockSyncRtt = clockSyncSampleRtt[best];
+
+  int32_t error = clockSyncTarget - clockOffset;
+  if (!clockSynced || error > CLOCK_SYNC_STEP || error < -CLOCK_SYNC_STEP) {
+    clockOffset = clockSyncTarget;
+    clockSynced = true;
+    clockSyncSteps++;
+    Serial.printf("Clock sync: stepped %d ms, rtt %u ms\n", error, clockSyncRtt);
+  }
+}
+
+void receiveClockSyncPacket(uint32_t now)
+{
+  uint8_t packet[CLOCK_SYNC_PACKET_SIZE];
+  if (clockSyncUdp.read(packet, sizeof(packet)) != CLOCK_SYNC_PACKET_SIZE)
+    return;
+  if (packet[0] != 'C' || packet[1] != 'K' || packet[2] != CLOCK_SYNC_VERSION)
+    return;
+
+  uint8_t type = packet[3];
+  uint32_t from = readClockSync32(packet + 4);
+  uint32_t to = readClockSync32(packet + 8);
+  bool fromMaster = packet[12] & CLOCK_SYNC_FLAG_MASTER;
+  uint32_t time1 = readClockSync32(packet + 13);
+  uint32_t time2 = readClockSync32(packet + 17);
+
+  // our own, looped back
+  if (from == clockSyncNodeId)
+    return;
+  if (to != 0 && to != clockSyncNodeId)
+    return;
+
+  switch (type) {
+    case CLOCK_SYNC_ANNOUNCE:
+      if (!fromMaster) {
+        if (clockSyncLowestPeer == 0 || from <= clockSyncLowestPeer || now - clockSyncLowestPeerHeard > CLOCK_SYNC_MASTER_TIMEOUT) {
+          clockSyncLowestPeer = from;
+          clockSyncLowestPeerHeard = now;
+        }
+        break;
+      }
+
+      if (clockSyncMaster) {
+        if (from < clockSyncNodeId)
+          followClockMaster(from);
+      }
+      else if (from != clockSyncMasterId) {
+        if (clockSyncMasterId == 0 || from < clockSyncMasterId || now - clockSyncMasterHeard > CLOCK_SYNC_MASTER_TIMEOUT)
+          followClockMaster(from);
+      }
+
+      if (from == clockSyncMasterId)
+        clockSyncMasterHeard = now;
+      break;
+
+    case CLOCK_SYNC_REQUEST:
+      if (clockSyncMaster)
+        sendClockSync(CLOCK_SYNC_RESPONSE, from, time1, clockMillis());
+      break;
+
+    case CLOCK_SYNC_RESPONSE:
+      if (!clockSyncMaster && from == clockSyncMasterId)
+        addClockSample(time1, time2);
+      break;
+  }
+}
+
+// Called once a loop(), before the pattern.
+void handleClockSync()
+{
+  uint32_t now = millis();
+
+  if (!clockSyncStarted) {
+    if (!apMode && WiFi.status() != WL_CONNECTED)
+      return;
+
+    IPAddress localIP = apMode ? WiFi.softAPIP() : WiFi.localIP();
+    clockSyncUdp.beginMulticast(localIP, clockSyncGroup, CLOCK_SYNC_PORT);
+    clockSyncNodeId = ESP.getChipId();
+    clockSyncStartMillis = now;
+    clockSyncStarted = true;
+    Serial.printf("Clock sync: node %08x on %s:%u\n", clockSyncNodeId, clockSyncGroup.toString().c_str(), CLOCK_SYNC_PORT);
+  }
+
+  while (clockSyncUdp.parsePacket() > 0)
+    receiveClockSyncPacket(now);
+
+  // election: listen for a while before taking over, so a node that has
+  // just started follows an existing master instead of competing with it
+  if (!clockSyncMaster && now - clockSyncMasterHeard > CLOCK_SYNC_MASTER_TIMEOUT &&
+      now - clockSyncStartMillis > CLOCK_SYNC_MASTER_TIMEOUT) {
+    bool lowerPeer = clockSyncLowestPeer != 0 && clockSyncLowestPeer < clockSyncNodeId &&
+                     now - clockSyncLowestPeerHeard <= CLOCK_SYNC_MASTER_TIMEOUT;
+    if (!lowerPeer) {
+      clockSyncMaster = true;
+      clockSyncMasterId = 0;
+      clockSyncTarget = clockOffset;
+      Serial.printf("Clock sync: master\n");
+    }
+  }
+
+  if (now - clockSyncLastAnnounce >= CLOCK_SYNC_ANNOUNCE_INTERVAL) {
+    clockSyncLastAnnounce = now;
+    sendClockSync(CLOCK_SYNC_ANNOUNCE, 0, 0, clockMillis());
+  }
+
+  if (!clockSyncMaster && clockSyncMasterId != 0) {
+    uint16_t interval = clockSyncSampleCount < CLOCK_SYNC_SAMPLES / 2 ? CLOCK_SYNC_FAST_REQUEST_INTERVAL : CLOCK_SYNC_REQUEST_INTERVAL;
+    if (now - clockSyncLastRequest >= interval) {
+      clockSyncLastRequest = now;
+      sendClockSync(CLOCK_SYNC_REQUEST, clockSyncMasterId, millis(), 0);
+    }
+  }
+
+  // slew towards the target 1 ms at a time, a 1 ms step at most never
+  // takes the clock backwards
+  if (now - clockSyncLastSlew >= CLOCK_SYNC_SLEW_INTERVAL) {
+    clockSyncLastSlew = now;
+    if (clockOffset < clockSyncTarget)
+      clockOffset++;
+    else if (clockOffset > clockSyncTarget)
+      clockOffset--;
+  }
+}
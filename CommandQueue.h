@@ -0,0 +1,117 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Field changes from HTTP POSTs and the WebSocket protocol are posted here
+// instead of being applied inside webServer.handleClient() or
+// webSocketsServer.loop(), and applyCommands() applies them at the start of
+// the next frame.  A slider dragged across the UI can post a value every
+// few ms; only the last one for each field is applied, so each frame runs
+// a field's setter at most once however fast the commands come in, and
+// sendBroadcasts() tells clients about all of them in one message.
+//
+// The queue is a single producer, single consumer ring: postCommand() only
+// writes commandQueue[commandHead] and then moves commandHead, and
+// applyCommands() only touches entries between commandTail and the
+// commandHead it read, then moves commandTail.  Both run in loop() at the
+// moment, but nothing stops posting from moving to a callback.
+//
+// Commands are applied oldest first, so that when two different fields are
+// set (a color, which switches to the Solid Color pattern, then a pattern)
+// the later one still wins.  A pattern param (see PatternParams.h) is for
+// the pattern that was current when it was posted; if an earlier command
+// has switched patterns by the time it is applied, it is dropped rather
+// than set on, and saved for, the new pattern's param in that slot.
+
+#define COMMAND_QUEUE_SIZE 32 // a power of two
+#define COMMAND_QUEUE_MASK (COMMAND_QUEUE_SIZE - 1)
+#define COMMAND_SUPERSEDED 0xFF
+#define COMMAND_MAX_VALUE_SIZE 3 // r, g, b
+
+struct Command {
+  uint8_t id;
+  uint8_t pattern; // currentPatternIndex when it was posted
+  uint8_t value[COMMAND_MAX_VALUE_SIZE];
+};
+
+Command commandQueue[COMMAND_QUEUE_SIZE];
+volatile uint8_t commandHead = 0; // next free entry, moved by postCommand()
+volatile uint8_t commandTail = 0; // next to apply, moved by applyCommands()
+
+uint32_t commandsPosted = 0;
+uint32_t commandsApplied = 0;
+uint32_t commandsCoalesced = 0;
+uint32_t commandsDropped = 0;
+
+// Queue a new value for field id, to be applied next frame.  Returns false
+// if the queue is full.
+bool postCommand(uint8_t id, const uint8_t* value)
+{
+  uint8_t head = commandHead;
+  uint8_t next = (head + 1) & COMMAND_QUEUE_MASK;
+  if (next == commandTail) {
+    commandsDropped++;
+    return false;
+  }
+
+  Command& command = commandQueue[head];
+  command.id = id;
+  command.pattern = currentPatternIndex;
+  memcpy(command.value, value, getFieldValueSize(fields[id]));
+
+  commandHead = next;
+  commandsPosted++;
+  return true;
+}
+
+// Called once a frame, before the pattern is drawn.
+void applyCommands()
+{
+  uint8_t head = commandHead;
+  uint8_t tail = commandTail;
+  if (head == tail)
+    return;
+
+  // newest first, so the first command seen for a field is its last one
+  uint32_t seen = 0;
+  for (uint8_t i = head; i != tail; ) {
+    i = (i - 1) & COMMAND_QUEUE_MASK;
+    uint32_t bit = 1UL << commandQueue[i].id;
+    if (seen & bit) {
+      commandQueue[i].id = COMMAND_SUPERSEDED;
+      commandsCoalesced++;
+    }
+    else {
+      seen |= bit;
+    }
+  }
+
+  for (uint8_t i = tail; i != head; i = (i + 1) & COMMAND_QUEUE_MASK) {
+    const Command& command = commandQueue[i];
+    if (command.id == COMMAND_SUPERSEDED)
+      continue;
+
+    if (command.id >= Param0Field && command.id <= Param3Field && command.pattern != currentPatternIndex) {
+      commandsDropped++;
+      continue;
+    }
+
+    setFieldValue(fields[command.id], command.value);
+    commandsApplied++;
+  }
+
+  commandTail = head;
+}
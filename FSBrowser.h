@@ -31,20 +31,32 @@ String getContentType(String filename){
   return "text/plain";
 }
 
-bool handleFileRead(String path){
+// Answered from the asset index (see Assets.h), without SPIFFS.exists().
+// The body is sent a piece at a time by handleNetwork(), see Network.h.
+bool handleFileRead(String path, const char* cacheControl = NULL){
   Serial.println("handleFileRead: " + path);
   if(path.endsWith("/")) path += "index.htm";
-  String contentType = getContentType(path);
-  String pathWithGz = path + ".gz";
-  if(SPIFFS.exists(pathWithGz) || SPIFFS.exists(path)){
-    if(SPIFFS.exists(pathWithGz))
-      path += ".gz";
-    File file = SPIFFS.open(path, "r");
-    size_t sent = webServer.streamFile(file, contentType);
-    file.close();
+  Asset* asset = findAsset(path.c_str());
+  if(!asset) return false;
+  assetRequests++;
+
+  char etag[11];
+  formatAssetEtag(etag, sizeof(etag), *asset);
+  webServer.sendHeader("ETag", etag);
+  if(webServer.header("If-None-Match") == etag){
+    assetNotModified++;
+    if(cacheControl) webServer.sendHeader("Cache-Control", cacheControl);
+    webServer.send(304);
     return true;
   }
-  return false;
+
+  File file = openAsset(*asset);
+  if(!file) return false;
+  if(!startFileTransfer(file, asset->size, getContentType(path), asset->gzip, cacheControl)){
+    file.close();
+    webServer.send(503, "text/plain", "Busy");
+  }
+  return true;
 }
 
 void handleFileUpload(){
@@ -64,6 +76,7 @@ void handleFileUpload(){
     if(fsUploadFile)
       fsUploadFile.close();
     Serial.print("handleFileUpload Size: "); Serial.println(upload.totalSize);
+    buildAssetIndex();
   }
 }
 
@@ -76,6 +89,7 @@ void handleFileDelete(){
   if(!SPIFFS.exists(path))
     return webServer.send(404, "text/plain", "FileNotFound");
   SPIFFS.remove(path);
+  buildAssetIndex();
   webServer.send(200, "text/plain", "");
   path = String();
 }
@@ -94,6 +108,7 @@ void handleFileCreate(){
     file.close();
   else
     return webServer.send(500, "text/plain", "CREATE FAILED");
+  buildAssetIndex();
   webServer.send(200, "text/plain", "");
   path = String();
 }
@@ -106,20 +121,8 @@ void handleFileList() {
   Dir dir = SPIFFS.openDir(path);
   path = String();
 
-  String output = "[";
-  while(dir.next()){
-    File entry = dir.openFile("r");
-    if (output != "[") output += ',';
-    bool isDir = false;
-    output += "{\"type\":\"";
-    output += (isDir)?"dir":"file";
-    output += "\",\"name\":\"";
-    output += String(entry.name()).substring(1);
-    output += "\"}";
-    entry.close();
-  }
-  
-  output += "]";
-  webServer.send(200, "text/json", output);
+  // the entries are sent a few at a time by handleNetwork(), see Network.h
+  if(!startListTransfer(dir))
+    webServer.send(503, "text/plain", "Busy");
 }
 
@@ -16,14 +16,20 @@
    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-typedef String (*FieldSetter)(String);
 typedef String (*FieldGetter)();
+typedef void (*FieldOptionsWriter)(JsonWriter& json);
+
+// Binary access for the WebSocket protocol in Protocol.h: value points at the
+// variable behind the field (one byte, or r, g, b for a Color), and set applies
+// a new value of that size, with the same side effects as the named setters.
+typedef void (*FieldValueSetter)(const uint8_t* value);
 
 const String NumberFieldType = "Number";
 const String BooleanFieldType = "Boolean";
 const String SelectFieldType = "Select";
 const String ColorFieldType = "Color";
 const String SectionFieldType = "Section";
+const String HiddenFieldType = "Hidden"; // a param slot the pattern doesn't use, see PatternParams.h
 
 typedef struct Field {
   String name;
@@ -32,75 +38,134 @@ typedef struct Field {
   uint8_t min;
   uint8_t max;
   FieldGetter getValue;
-  FieldGetter getOptions;
-  FieldSetter setValue;
+  FieldOptionsWriter writeOptions;
+  uint8_t* value;
+  FieldValueSetter set;
 };
 
 typedef Field FieldList[];
 
-Field getField(String name, FieldList fields, uint8_t count) {
+// Ids of the fields that have a value, sorted by name, so they can be found
+// with a binary search.  Sections are left out since they share their
+// field's name.  Returns how many ids were written.
+uint8_t indexFieldNames(FieldList fields, uint8_t count, uint8_t* index) {
+  uint8_t indexCount = 0;
+
   for (uint8_t i = 0; i < count; i++) {
-    Field field = fields[i];
-    if (field.name == name) {
-      return field;
+    if (!fields[i].value)
+      continue;
+
+    // insertion sort, there are only a handful
+    uint8_t j = indexCount++;
+    while (j > 0 && strcmp(fields[index[j - 1]].name.c_str(), fields[i].name.c_str()) > 0) {
+      index[j] = index[j - 1];
+      j--;
     }
+    index[j] = i;
   }
-  return Field();
+
+  return indexCount;
 }
 
-String getFieldValue(String name, FieldList fields, uint8_t count) {
-  Field field = getField(name, fields, count);
-  if (field.getValue) {
-    return field.getValue();
+// Id of the field called name, or count if there is none.
+uint8_t getFieldIndex(const char* name, FieldList fields, uint8_t count, const uint8_t* index, uint8_t indexCount) {
+  uint8_t low = 0;
+  uint8_t high = indexCount;
+
+  while (low < high) {
+    uint8_t middle = (low + high) / 2;
+    int order = strcmp(fields[index[middle]].name.c_str(), name);
+    if (order == 0)
+      return index[middle];
+    if (order < 0)
+      low = middle + 1;
+    else
+      high = middle;
   }
-  return String();
+
+  return count;
 }
 
-String setFieldValue(String name, String value, FieldList fields, uint8_t count) {
-  Field field = getField(name, fields, count);
-  if (field.setValue) {
-    return field.setValue(value);
-  }
-  return String();
+uint8_t getFieldValueSize(const Field& field) {
+  return field.type == ColorFieldType ? 3 : 1;
 }
 
-String getFieldsJson(FieldList fields, uint8_t count) {
-  String json = "[";
+// A value for the field as text: a number, or r,g,b for a Color.
+void formatFieldValue(char* text, size_t size, const Field& field, const uint8_t* value) {
+  if (field.type == ColorFieldType)
+    snprintf(text, size, "%u,%u,%u", value[0], value[1], value[2]);
+  else
+    snprintf(text, size, "%u", value[0]);
+}
 
-  for (uint8_t i = 0; i < count; i++) {
-    Field field = fields[i];
+// The field's value as text.
+void formatFieldValue(char* text, size_t size, const Field& field) {
+  formatFieldValue(text, size, field, field.value);
+}
 
-    json += "{\"name\":\"" + field.name + "\",\"label\":\"" + field.label + "\",\"type\":\"" + field.type + "\"";
+// Keep a number in the field's range.
+void clampFieldValue(const Field& field, uint8_t* value) {
+  if (field.type == NumberFieldType)
+    value[0] = constrain(value[0], field.min, field.max);
+}
 
-    if(field.getValue) {
-      if (field.type == ColorFieldType || field.type == "String") {
-        json += ",\"value\":\"" + field.getValue() + "\"";
-      }
-      else {
-        json += ",\"value\":" + field.getValue();
-      }
+// Apply a new value through the field's setter, keeping numbers in range.
+void setFieldValue(const Field& field, const uint8_t* value) {
+  uint8_t clamped[3];
+  memcpy(clamped, value, getFieldValueSize(field));
+  clampFieldValue(field, clamped);
+
+  field.set(clamped);
+}
+
+// Stream the /all array through json, see JsonWriter.h.
+void writeFieldsJson(JsonWriter& json, FieldList fields, uint8_t count) {
+  json.print('[');
+
+  for (uint8_t i = 0; i < count; i++) {
+    const Field& field = fields[i];
+
+    json.print("{\"name\":");
+    json.printString(field.name);
+    json.print(",\"label\":");
+    json.printString(field.label);
+    json.print(",\"type\":");
+    json.printString(field.type);
+
+    if (field.value) {
+      char value[12];
+      formatFieldValue(value, sizeof(value), field);
+      json.print(",\"value\":");
+      if (field.type == ColorFieldType)
+        json.printString(value);
+      else
+        json.print(value);
+    }
+    else if (field.getValue) {
+      json.print(",\"value\":");
+      json.print(field.getValue());
     }
 
     if (field.type == NumberFieldType) {
-      json += ",\"min\":" + String(field.min);
-      json += ",\"max\":" + String(field.max);
+      json.print(",\"min\":");
+      json.print((unsigned int) field.min);
+      json.print(",\"max\":");
+      json.print((unsigned int) field.max);
     }
 
-    if (field.getOptions) {
-      json += ",\"options\":[";
-      json += field.getOptions();
-      json += "]";
+    if (field.writeOptions) {
+      json.print(",\"options\":[");
+      field.writeOptions(json);
+      json.print(']');
     }
 
-    json += "}";
+    json.print('}');
 
     if (i < count - 1)
-      json += ",";
+      json.print(',');
   }
 
-  json += "]";
-
-  return json;
+  json.print(']');
 }
 
 /*
@@ -45,32 +45,24 @@ String getPattern() {
   return String(currentPatternIndex);
 }
 
-String getPatterns() {
-  String json = "";
-
+void writePatterns(JsonWriter& json) {
   for (uint8_t i = 0; i < patternCount; i++) {
-    json += "\"" + patterns[i].name + "\"";
+    json.printString(patterns[i].name);
     if (i < patternCount - 1)
-      json += ",";
+      json.print(',');
   }
-
-  return json;
 }
 
 String getPalette() {
   return String(currentPaletteIndex);
 }
 
-String getPalettes() {
-  String json = "";
-
+void writePalettes(JsonWriter& json) {
   for (uint8_t i = 0; i < paletteCount; i++) {
-    json += "\"" + paletteNames[i] + "\"";
+    json.printString(paletteNames[i]);
     if (i < paletteCount - 1)
-      json += ",";
+      json.print(',');
   }
-
-  return json;
 }
 
 String getAutoplay() {
@@ -114,26 +106,121 @@ String getTwinkleDensity() {
   return String(twinkleDensity);
 }
 
+String getNoiseFloor() {
+  return String(noiseFloor);
+}
+
+String getAgcSmooth() {
+  return String(agcSmoothThousandths);
+}
+
+String getAudioSync() {
+  return String(audioSyncMode);
+}
+
+void writeAudioSyncModes(JsonWriter& json) {
+  for (uint8_t i = 0; i < AudioSyncModeCount; i++) {
+    json.printString(audioSyncModeNames[i]);
+    if (i < AudioSyncModeCount - 1)
+      json.print(',');
+  }
+}
+
+// binary setters for the WebSocket protocol, see Field.h
+void setPowerValue(const uint8_t* value) { setPower(value[0]); }
+void setBrightnessValue(const uint8_t* value) { setBrightness(value[0]); }
+void setPatternValue(const uint8_t* value) { setPattern(value[0]); }
+void setPaletteValue(const uint8_t* value) { setPalette(value[0]); }
+void setSpeedValue(const uint8_t* value) { setSpeed(value[0]); }
+void setAutoplayValue(const uint8_t* value) { setAutoplay(value[0]); }
+void setAutoplayDurationValue(const uint8_t* value) { setAutoplayDuration(value[0]); }
+void setSolidColorValue(const uint8_t* value) { setSolidColor(value[0], value[1], value[2]); }
+void setCoolingValue(const uint8_t* value) { setCooling(value[0]); }
+void setSparkingValue(const uint8_t* value) { setSparking(value[0]); }
+void setTwinkleSpeedValue(const uint8_t* value) { setTwinkleSpeed(value[0]); }
+void setTwinkleDensityValue(const uint8_t* value) { setTwinkleDensity(value[0]); }
+void setNoiseFloorValue(const uint8_t* value) { setNoiseFloor(value[0]); }
+void setAgcSmoothValue(const uint8_t* value) { setAgcSmooth(value[0]); }
+void setAudioSyncValue(const uint8_t* value) { setAudioSync(value[0]); }
+void setParam0Value(const uint8_t* value) { setPatternParam(0, value[0]); }
+void setParam1Value(const uint8_t* value) { setPatternParam(1, value[0]); }
+void setParam2Value(const uint8_t* value) { setPatternParam(2, value[0]); }
+void setParam3Value(const uint8_t* value) { setPatternParam(3, value[0]); }
+
+// Ids for the entries in fields[], in the same order.  The id is what the
+// WebSocket protocol sends, so append new fields rather than reordering.
+enum FieldId {
+  PowerField,
+  BrightnessField,
+  PatternField,
+  PaletteField,
+  SpeedField,
+  AutoplaySection,
+  AutoplayField,
+  AutoplayDurationField,
+  SolidColorSection,
+  SolidColorField,
+  FireSection,
+  CoolingField,
+  SparkingField,
+  TwinklesSection,
+  TwinkleSpeedField,
+  TwinkleDensityField,
+  AudioSection,
+  NoiseFloorField,
+  AgcSmoothField,
+  AudioSyncField,
+  ParamsSection,
+  Param0Field,
+  Param1Field,
+  Param2Field,
+  Param3Field,
+  FieldIdCount
+};
+
+// behind the param slots the current pattern doesn't use, see PatternParams.h
+uint8_t hiddenParamValue = 0;
+
 FieldList fields = {
-  { "power", "Power", BooleanFieldType, 0, 1, getPower },
-  { "brightness", "Brightness", NumberFieldType, 1, 255, getBrightness },
-  { "pattern", "Pattern", SelectFieldType, 0, patternCount, getPattern, getPatterns },
-  { "palette", "Palette", SelectFieldType, 0, paletteCount, getPalette, getPalettes },
-  { "speed", "Speed", NumberFieldType, 1, 255, getSpeed },
+  { "power", "Power", BooleanFieldType, 0, 1, getPower, NULL, &power, setPowerValue },
+  { "brightness", "Brightness", NumberFieldType, 1, 255, getBrightness, NULL, &brightness, setBrightnessValue },
+  { "pattern", "Pattern", SelectFieldType, 0, patternCount, getPattern, writePatterns, &currentPatternIndex, setPatternValue },
+  { "palette", "Palette", SelectFieldType, 0, paletteCount, getPalette, writePalettes, &currentPaletteIndex, setPaletteValue },
+  { "speed", "Speed", NumberFieldType, 1, 255, getSpeed, NULL, &speed, setSpeedValue },
 //  { "speedx", "Speedx", NumberFieldType, 1, 255, getSpeedx},
 //  { "speedy", "Speedx", NumberFieldType, 1, 255, getSpeedy},
 //  { "speedz", "Speedx", NumberFieldType, 1, 255, getSpeedz},
   { "autoplay", "Autoplay", SectionFieldType },
-  { "autoplay", "Autoplay", BooleanFieldType, 0, 1, getAutoplay },
-  { "autoplayDuration", "Autoplay Duration", NumberFieldType, 0, 255, getAutoplayDuration },
+  { "autoplay", "Autoplay", BooleanFieldType, 0, 1, getAutoplay, NULL, &autoplay, setAutoplayValue },
+  { "autoplayDuration", "Autoplay Duration", NumberFieldType, 1, 255, getAutoplayDuration, NULL, &autoplayDuration, setAutoplayDurationValue },
   { "solidColor", "Solid Color", SectionFieldType },
-  { "solidColor", "Color", ColorFieldType, 0, 255, getSolidColor },
+  { "solidColor", "Color", ColorFieldType, 0, 255, getSolidColor, NULL, solidColor.raw, setSolidColorValue },
   { "fire", "Fire & Water", SectionFieldType },
-  { "cooling", "Cooling", NumberFieldType, 0, 255, getCooling },
-  { "sparking", "Sparking", NumberFieldType, 0, 255, getSparking },
+  { "cooling", "Cooling", NumberFieldType, 0, 255, getCooling, NULL, &cooling, setCoolingValue },
+  { "sparking", "Sparking", NumberFieldType, 0, 255, getSparking, NULL, &sparking, setSparkingValue },
   { "twinkles", "Twinkles", SectionFieldType },
-  { "twinkleSpeed", "Twinkle Speed", NumberFieldType, 0, 8, getTwinkleSpeed },
-  { "twinkleDensity", "Twinkle Density", NumberFieldType, 0, 8, getTwinkleDensity },
+  { "twinkleSpeed", "Twinkle Speed", NumberFieldType, 0, 8, getTwinkleSpeed, NULL, &twinkleSpeed, setTwinkleSpeedValue },
+  { "twinkleDensity", "Twinkle Density", NumberFieldType, 0, 8, getTwinkleDensity, NULL, &twinkleDensity, setTwinkleDensityValue },
+  { "audio", "Audio", SectionFieldType },
+  { "noiseFloor", "Noise Floor", NumberFieldType, 0, 255, getNoiseFloor, NULL, &noiseFloor, setNoiseFloorValue },
+  { "agcSmooth", "AGC Smoothing (/1000)", NumberFieldType, 1, 255, getAgcSmooth, NULL, &agcSmoothThousandths, setAgcSmoothValue },
+  { "audioSync", "Audio Sync", SelectFieldType, 0, AudioSyncModeCount, getAudioSync, writeAudioSyncModes, &audioSyncMode, setAudioSyncValue },
+  // the current pattern's params: PatternParams.h fills these in
+  { "params", "Pattern Settings", SectionFieldType },
+  { "param0", "", HiddenFieldType, 0, 0, NULL, NULL, &hiddenParamValue, setParam0Value },
+  { "param1", "", HiddenFieldType, 0, 0, NULL, NULL, &hiddenParamValue, setParam1Value },
+  { "param2", "", HiddenFieldType, 0, 0, NULL, NULL, &hiddenParamValue, setParam2Value },
+  { "param3", "", HiddenFieldType, 0, 0, NULL, NULL, &hiddenParamValue, setParam3Value },
 };
 
-uint8_t fieldCount = ARRAY_SIZE(fields);
+uint8_t fieldCount = ARRAY_SIZE(fields);
+
+static_assert(ARRAY_SIZE(fields) == FieldIdCount, "FieldId is out of step with fields[]");
+
+uint8_t fieldNameIndex[FieldIdCount];
+uint8_t fieldNameCount = indexFieldNames(fields, fieldCount, fieldNameIndex);
+
+// Id of the field called name, or fieldCount if there is none.
+uint8_t findField(const char* name) {
+  return getFieldIndex(name, fields, fieldCount, fieldNameIndex, fieldNameCount);
+}
@@ -0,0 +1,166 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 2D audio-driven fire for the matrix, based on FastLED example Fire2012WithPalette:
+// https://github.com/FastLED/FastLED/blob/master/examples/Fire2012WithPalette/Fire2012WithPalette.ino
+//
+// The heat field is stored row-major with row 0 at the top, so every step
+// below walks one contiguous row at a time.  Cooling and diffusion are plain
+// 8/16-bit integer math on byte arrays with the edge columns split out of the
+// inner loops, which lets the compiler unroll and vectorise them.
+
+// per-frame cycle budget for the whole simulation + palette mapping
+// 2ms worth of cycles leaves plenty of the ~8ms frame for show() and the network
+#define FIRE2D_CYCLE_BUDGET (F_CPU / 500)
+
+// Array of temperature readings at each simulation cell
+static uint8_t fireHeat[kMatrixHeight][kMatrixWidth];
+
+// cooling amount for each column, doubled so a row can start at any offset
+static uint8_t fireCooling[kMatrixWidth * 2];
+
+// which MSGEQ7 band drives the sparks in each column
+static uint8_t fireBands[kMatrixWidth];
+
+// heat -> color lookup table, built once from the palette
+CRGB fireLUT[256];
+
+// reported by /metrics
+uint32_t fire2DCycles = 0;     // cycles used by the last frame
+uint32_t fire2DMaxCycles = 0;  // worst frame since boot
+uint32_t fire2DOverBudget = 0; // frames over FIRE2D_CYCLE_BUDGET since boot
+
+// Fill a 256 entry lookup table from a palette, so per-pixel mapping is a
+// single load instead of a ColorFromPalette blend.  The heat value is scaled
+// to 0-240 like heatMap() does, for best results with color palettes.
+void buildPaletteLUT(CRGB* lut, const CRGBPalette16& palette, uint8_t scale)
+{
+  for (uint16_t i = 0; i < 256; i++) {
+    lut[i] = ColorFromPalette(palette, scale8(i, scale));
+  }
+}
+
+void initializeFire2D(const CRGBPalette16& palette)
+{
+  buildPaletteLUT(fireLUT, palette, 240);
+
+  for (uint8_t x = 0; x < kMatrixWidth; x++) {
+    fireBands[x] = (x * bandCount) / kMatrixWidth;
+  }
+}
+
+// Step 1.  Cool down every cell a little
+void coolFire2D()
+{
+  // cooling goes up to 255, which would wrap a uint8_t here
+  uint16_t coolingLimit = (cooling * 10) / kMatrixHeight + 2;
+  uint8_t maxCooling = min(coolingLimit, (uint16_t) 255);
+
+  for (uint8_t x = 0; x < kMatrixWidth; x++) {
+    fireCooling[x] = random8(0, maxCooling);
+    fireCooling[x + kMatrixWidth] = fireCooling[x];
+  }
+
+  for (uint8_t y = 0; y < kMatrixHeight; y++) {
+    // each row reuses the per-column values at a different rotation
+    const uint8_t* cool = fireCooling + random8(kMatrixWidth);
+    uint8_t* row = fireHeat[y];
+
+    for (uint8_t x = 0; x < kMatrixWidth; x++) {
+      row[x] = qsub8(row[x], cool[x]);
+    }
+  }
+}
+
+// Step 2.  Heat from each cell drifts 'up' and diffuses a little.
+// Weights are 2/4 from directly below, 1/4 from two below and 1/4 from
+// the average of the diagonal neighbours, so the sum is a shift, not a divide.
+void diffuseFire2D()
+{
+  const uint8_t last = kMatrixWidth - 1;
+
+  for (uint8_t y = 0; y < kMatrixHeight - 2; y++) {
+    uint8_t* row = fireHeat[y];
+    const uint8_t* below = fireHeat[y + 1];
+    const uint8_t* below2 = fireHeat[y + 2];
+
+    row[0] = (below[0] * 3 + below2[0]) >> 2;
+
+    for (uint8_t x = 1; x < last; x++) {
+      uint16_t sum = (below[x] << 1) + below2[x] + ((below[x - 1] + below[x + 1]) >> 1);
+      row[x] = sum >> 2;
+    }
+
+    row[last] = (below[last] * 3 + below2[last]) >> 2;
+  }
+
+  // the second to last row only has one row beneath it
+  uint8_t* row = fireHeat[kMatrixHeight - 2];
+  const uint8_t* below = fireHeat[kMatrixHeight - 1];
+  for (uint8_t x = 0; x < kMatrixWidth; x++) {
+    row[x] = (row[x] + (below[x] * 3)) >> 2;
+  }
+}
+
+// Step 3.  Randomly ignite new 'sparks' of heat along the bottom,
+// with each band's level setting the chance and heat for its columns
+void sparkFire2D()
+{
+  uint8_t* bottom = fireHeat[kMatrixHeight - 1];
+
+  for (uint8_t x = 0; x < kMatrixWidth; x++) {
+    uint8_t level = spectrumByte[fireBands[x]];
+
+    if (level <= 8) continue;
+
+    if (random8() < scale8(level, sparking)) {
+      bottom[x] = qadd8(bottom[x], random8(level >> 1, level));
+    }
+  }
+}
+
+// Step 4.  Map from heat cells to LED colors
+void mapFire2D()
+{
+  for (uint8_t y = 0; y < kMatrixHeight; y++) {
+    const uint8_t* row = fireHeat[y];
+    for (uint8_t x = 0; x < kMatrixWidth; x++) {
+      leds[XY(x, y)] = fireLUT[row[x]];
+    }
+  }
+}
+
+void audioFire2D()
+{
+  static bool initialized = false;
+
+  if (!initialized) {
+    initialized = true;
+    initializeFire2D(HeatColors_p);
+  }
+
+  uint32_t start = ESP.getCycleCount();
+
+  coolFire2D();
+  diffuseFire2D();
+  sparkFire2D();
+  mapFire2D();
+
+  fire2DCycles = ESP.getCycleCount() - start;
+  if (fire2DCycles > fire2DMaxCycles) fire2DMaxCycles = fire2DCycles;
+  if (fire2DCycles > FIRE2D_CYCLE_BUDGET) fire2DOverBudget++;
+}
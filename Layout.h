@@ -0,0 +1,168 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Physical layout of the LEDs, loaded from SPIFFS at boot so the same
+// firmware can drive a matrix, a strip or a bloom.  Patterns that care where
+// an LED physically is index these arrays instead of working it out from the
+// LED number every frame.
+//
+// Layout files are made by tools/mklayout.py, which also precomputes the
+// polar coordinates, so nothing here needs trig per frame.  The format is
+// little endian:
+//
+//   offset  size
+//        0     4  magic "LAY1"
+//        4     2  LED count
+//        6     1  width:  grid columns, x is 0 to width - 1
+//        7     1  height: grid rows, y is 0 to height - 1
+//                 (both 0 when x and y are free coordinates, not cells)
+//        8     4  reserved, 0
+//       12   6*n  one record per LED, in wiring order:
+//                 x, y, z, angle, radius, group
+//
+// angle is 0-255 for a full turn about the centre of the x/y bounding box,
+// radius is the distance from that centre scaled so the farthest LED is 255,
+// and group is free for the layout to use (a matrix row, a bloom level...).
+//
+// The sketch defines LAYOUT_MAX_LEDS before including this file.
+
+#define LAYOUT_MAGIC "LAY1"
+#define LAYOUT_HEADER_SIZE 12
+#define LAYOUT_RECORD_SIZE 6
+
+uint16_t layoutCount = 0;
+uint8_t layoutWidth = 0;
+uint8_t layoutHeight = 0;
+
+uint8_t layoutX[LAYOUT_MAX_LEDS];
+uint8_t layoutY[LAYOUT_MAX_LEDS];
+uint8_t layoutZ[LAYOUT_MAX_LEDS];
+uint8_t layoutAngle[LAYOUT_MAX_LEDS];
+uint8_t layoutRadius[LAYOUT_MAX_LEDS];
+uint8_t layoutGroup[LAYOUT_MAX_LEDS];
+
+bool loadLayout(const char* path)
+{
+  File file = SPIFFS.open(path, "r");
+  if (!file)
+    return false;
+
+  uint8_t header[LAYOUT_HEADER_SIZE];
+  if (file.read(header, LAYOUT_HEADER_SIZE) != LAYOUT_HEADER_SIZE || memcmp(header, LAYOUT_MAGIC, 4) != 0) {
+    Serial.printf("Layout: %s is not a layout file\n", path);
+    return false;
+  }
+
+  uint16_t count = header[4] | (header[5] << 8);
+  if (count == 0 || count > LAYOUT_MAX_LEDS) {
+    Serial.printf("Layout: %s has %u LEDs, this firmware supports 1 to %u\n", path, count, LAYOUT_MAX_LEDS);
+    return false;
+  }
+  if (file.size() != LAYOUT_HEADER_SIZE + (size_t) count * LAYOUT_RECORD_SIZE) {
+    Serial.printf("Layout: %s is truncated\n", path);
+    return false;
+  }
+
+  // read a few records at a time straight into the arrays
+  uint8_t records[LAYOUT_RECORD_SIZE * 16];
+  uint16_t i = 0;
+  while (i < count) {
+    uint16_t n = min(count - i, 16);
+    if (file.read(records, n * LAYOUT_RECORD_SIZE) != n * LAYOUT_RECORD_SIZE) {
+      Serial.printf("Layout: error reading %s\n", path);
+      return false;
+    }
+    for (uint8_t *record = records; n > 0; n--, i++, record += LAYOUT_RECORD_SIZE) {
+      layoutX[i] = record[0];
+      layoutY[i] = record[1];
+      layoutZ[i] = record[2];
+      layoutAngle[i] = record[3];
+      layoutRadius[i] = record[4];
+      layoutGroup[i] = record[5];
+    }
+  }
+
+  layoutCount = count;
+  layoutWidth = header[6];
+  layoutHeight = header[7];
+
+  Serial.printf("Layout: %u LEDs, %ux%u from %s\n", layoutCount, layoutWidth, layoutHeight, path);
+  return true;
+}
+
+// Work out angle and radius from x and y, the same way tools/mklayout.py
+// does.  Only used at boot for the built-in layouts.
+void layoutComputePolar()
+{
+  if (layoutCount == 0)
+    return;
+
+  uint8_t minX = 255, maxX = 0, minY = 255, maxY = 0;
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    minX = min(minX, layoutX[i]);
+    maxX = max(maxX, layoutX[i]);
+    minY = min(minY, layoutY[i]);
+    maxY = max(maxY, layoutY[i]);
+  }
+
+  float centerX = (minX + maxX) / 2.0f;
+  float centerY = (minY + maxY) / 2.0f;
+
+  float maxDistance = 0;
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    maxDistance = max(maxDistance, hypotf(layoutX[i] - centerX, layoutY[i] - centerY));
+  }
+
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    float dx = layoutX[i] - centerX;
+    float dy = layoutY[i] - centerY;
+    layoutAngle[i] = (int) floorf(atan2f(dy, dx) * 128.0f / PI + 0.5f) & 0xFF;
+    layoutRadius[i] = maxDistance > 0 ? (uint8_t) floorf(hypotf(dx, dy) * 255.0f / maxDistance + 0.5f) : 0;
+  }
+}
+
+// Built-in layout for a width x height matrix, wired row by row starting at
+// the top left, optionally reversing every other row.
+void layoutFromGrid(uint8_t width, uint8_t height, bool serpentine)
+{
+  layoutWidth = width;
+  layoutHeight = height;
+  layoutCount = min(width * height, LAYOUT_MAX_LEDS);
+
+  for (uint8_t y = 0; y < height; y++) {
+    for (uint8_t x = 0; x < width; x++) {
+      uint16_t i = (y * width) + (serpentine && (y & 0x01) ? (width - 1) - x : x);
+      if (i >= layoutCount)
+        continue;
+      layoutX[i] = x;
+      layoutY[i] = y;
+      layoutZ[i] = 0;
+      layoutGroup[i] = y;
+    }
+  }
+
+  layoutComputePolar();
+}
+
+// Black out the LEDs past the layout's, for a pattern that draws only the
+// LEDs in the layout on a strip of count, so they don't keep whatever the
+// last pattern left on them.
+void layoutClearRest(CRGB* leds, uint16_t count)
+{
+  if (layoutCount < count)
+    fill_solid(leds + layoutCount, count - layoutCount, CRGB::Black);
+}
@@ -829,7 +829,7 @@ void juggle()
   byte dothue = 0;
   for ( int i = 0; i < 8; i++)
   {
-    leds[beatsin16(i + 7, 0, NUM_LEDS)] |= CHSV(dothue, 200, 255);
+    leds[beatsin16(i + 7, 0, NUM_LEDS - 1)] |= CHSV(dothue, 200, 255);
     dothue += 32;
   }
 }
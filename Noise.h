@@ -185,95 +185,3 @@ void drawNoise(CRGBPalette16 palette,uint8_t hueReduce = 0) {
   mapNoiseToLEDsUsingPalette(palette, hueReduce);
 
 }
-
-void  rainbowNoise() {
-  noisespeedx = 9;
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 30;
-  colorLoop = 0;
-   drawNoise(RainbowColors_p);
-}
-
-void rainbowStripeNoise() {
-  noisespeedx = 9;
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 20;
-  colorLoop = 0;
-  drawNoise(RainbowStripeColors_p);
-}
-
-void partyNoise() {
-  noisespeedx = 9;
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 30;
-  colorLoop = 0;
-  drawNoise(PartyColors_p);
-}
-
-void forestNoise() {
-  noisespeedx = 9;
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 120;
-  colorLoop = 0;
-   drawNoise(ForestColors_p);
-}
-
-void cloudNoise() {
-  noisespeedx = 9;
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 30;
-  colorLoop = 0;
-  drawNoise(CloudColors_p);
-}
-
-void fireNoise() {
-  noisespeedx = 8; // 24;
-  noisespeedy = 0;
-  noisespeedz = 8;
-  noisescale = 50;
-  colorLoop = 0;
-  drawNoise(HeatColors_p, 60);
-}
-
-void lavaNoise() {
-  noisespeedx = 32;
-  noisespeedy = 0;
-  noisespeedz = 16;
-  noisescale = 50;
-  colorLoop = 0;
-  drawNoise(LavaColors_p);
-}
-
-void oceanNoise() {
-  noisespeedx = 9;
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 90;
-  colorLoop = 0;
-  drawNoise(OceanColors_p);
-}
-
-void blackAndWhiteNoise() {
-  SetupBlackAndWhiteStripedPalette();
-  noisespeedx = 9;
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 30;
-  colorLoop = 0;
- drawNoise(blackAndWhiteStripedPalette);
-}
-
-void blackAndBlueNoise() {
-  SetupBlackAndBlueStripedPalette();
-  noisespeedx = 9;
-  noisespeedy = 0;
-  noisespeedz = 0;
-  noisescale = 30;
-  colorLoop = 0;
-   drawNoise(blackAndBlueStripedPalette);
-}
@@ -0,0 +1,246 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The noise patterns, as rows of a table in flash rather than a function
+// each.  A variant is eight bytes:
+//
+//   palette     a NoisePalette
+//   speedX/Y/Z  how far the noise moves each frame along x, y and z: a
+//               number up to 127, or NOISE_BAND(band, shift), the band's
+//               spectrumByte[] shifted right by shift
+//   scale       noisescale, how zoomed out the noise is, unless noiseZoom
+//               (a param, see PatternParams.h) replaces it
+//   scaleBand   added to scale, the same way as a speed; 0 for nothing
+//   hueReduce   palette indexes below it are 0 (the fire's black)
+//   flags       NOISE_COLOR_LOOP to rotate the palette over time
+//
+// drawNoiseVariant() sets the globals drawNoise() in Noise.h works from and
+// calls it.
+//
+// Variants can be changed without a new firmware: /noise.bin, made by
+// tools/mknoise.py, replaces the variants it names at boot, little endian:
+//
+//   offset  size
+//        0     4  magic "NSE1"
+//        4     1  count
+//        5     3  reserved, 0
+//        8   9*n  the variant id, then its eight bytes
+//
+// Only replaced variants take RAM; at most NOISE_OVERRIDES of them.
+
+#define NOISE_BAND(band, shift) (0x80 | ((shift) << 4) | (band))
+#define NOISE_FROM_BAND 0x80
+#define NOISE_COLOR_LOOP 0x01
+
+#define NOISE_OVERRIDES 8
+#define NOISE_FILE_MAGIC "NSE1"
+#define NOISE_FILE_HEADER_SIZE 8
+
+enum NoisePalette {
+  NoiseRainbow,
+  NoiseRainbowStripe,
+  NoiseParty,
+  NoiseForest,
+  NoiseCloud,
+  NoiseHeat,
+  NoiseLava,
+  NoiseOcean,
+  NoiseBlackAndWhite,
+  NoiseBlackAndBlue,
+  NoisePaletteCount
+};
+
+struct NoiseVariant {
+  uint8_t palette;
+  uint8_t speedX;
+  uint8_t speedY;
+  uint8_t speedZ;
+  uint8_t scale;
+  uint8_t scaleBand;
+  uint8_t hueReduce;
+  uint8_t flags;
+};
+
+// Ids for the entries in noiseVariants[], in the same order.  /noise.bin
+// refers to them by number, so append rather than reordering.
+enum NoiseVariantId {
+  RainbowAudioNoise,
+  RainbowStripeAudioNoise,
+  PartyAudioNoise,
+  ForestAudioNoise,
+  CloudAudioNoise,
+  FireAudioNoise,
+  LavaAudioNoise,
+  OceanAudioNoise,
+  BlackAndWhiteAudioNoise,
+  BlackAndBlueAudioNoise,
+  RainbowNoise,
+  RainbowStripeNoise,
+  PartyNoise,
+  ForestNoise,
+  CloudNoise,
+  FireNoise,
+  LavaNoise,
+  OceanNoise,
+  BlackAndWhiteNoise,
+  BlackAndBlueNoise,
+  NoiseVariantCount
+};
+
+const NoiseVariant noiseVariants[NoiseVariantCount] PROGMEM = {
+  // palette             speedX              speedY              speedZ              scale  scaleBand hueReduce flags
+  { NoiseRainbow,        NOISE_BAND(0, 0),   0,                  0,                   30,   0,         0,       NOISE_COLOR_LOOP },
+  { NoiseRainbowStripe,  NOISE_BAND(0, 0),   0,                  0,                   20,   0,         0,       NOISE_COLOR_LOOP },
+  { NoiseParty,          NOISE_BAND(0, 0),   0,                  0,                   30,   0,         0,       NOISE_COLOR_LOOP },
+  { NoiseForest,         NOISE_BAND(0, 0),   0,                  0,                  120,   0,         0,       NOISE_COLOR_LOOP },
+  { NoiseCloud,          NOISE_BAND(0, 0),   0,                  0,                   30,   0,         0,       NOISE_COLOR_LOOP },
+  { NoiseHeat,           NOISE_BAND(0, 0),   0,                  NOISE_BAND(6, 0),    50,   0,        60,       NOISE_COLOR_LOOP },
+  { NoiseLava,           0,                  NOISE_BAND(0, 0),   NOISE_BAND(6, 0),    50,   0,         0,       NOISE_COLOR_LOOP },
+  { NoiseOcean,          0,                  NOISE_BAND(0, 0),   0,                   90,   0,         0,       NOISE_COLOR_LOOP },
+  { NoiseBlackAndWhite,  0,                  NOISE_BAND(0, 1),   0,                   15,   0,         0,       0 },
+  { NoiseBlackAndBlue,   NOISE_BAND(0, 0),   0,                  0,                   45,   0,         0,       NOISE_COLOR_LOOP },
+
+  { NoiseRainbow,        9,                  0,                  0,                   30,   0,         0,       0 },
+  { NoiseRainbowStripe,  9,                  0,                  0,                   20,   0,         0,       0 },
+  { NoiseParty,          9,                  0,                  0,                   30,   0,         0,       0 },
+  { NoiseForest,         9,                  0,                  0,                  120,   0,         0,       0 },
+  { NoiseCloud,          9,                  0,                  0,                   30,   0,         0,       0 },
+  { NoiseHeat,           8,                  0,                  8,                   50,   0,        60,       0 },
+  { NoiseLava,           32,                 0,                  16,                  50,   0,         0,       0 },
+  { NoiseOcean,          9,                  0,                  0,                   90,   0,         0,       0 },
+  { NoiseBlackAndWhite,  9,                  0,                  0,                   30,   0,         0,       0 },
+  { NoiseBlackAndBlue,   9,                  0,                  0,                   30,   0,         0,       0 },
+};
+
+struct NoiseOverride {
+  uint8_t id;
+  NoiseVariant variant;
+};
+
+NoiseOverride noiseOverrides[NOISE_OVERRIDES];
+uint8_t noiseOverrideCount = 0;
+
+// replaces the variant's scale when it isn't 0, see PatternParams.h
+uint8_t noiseZoom = 0;
+
+// Read the replacements in path, if there is one.
+void loadNoiseVariants(const char* path)
+{
+  noiseOverrideCount = 0;
+
+  File file = SPIFFS.open(path, "r");
+  if (!file)
+    return;
+
+  uint8_t header[NOISE_FILE_HEADER_SIZE];
+  if (file.read(header, sizeof(header)) != sizeof(header) || memcmp(header, NOISE_FILE_MAGIC, 4) != 0) {
+    Serial.printf("Noise: %s is not a noise variants file\n", path);
+    file.close();
+    return;
+  }
+
+  for (uint8_t i = 0; i < header[4]; i++) {
+    NoiseOverride entry;
+    if (file.read(&entry.id, 1) != 1 || file.read((uint8_t*) &entry.variant, sizeof(NoiseVariant)) != sizeof(NoiseVariant)) {
+      Serial.printf("Noise: %s is truncated\n", path);
+      break;
+    }
+    if (entry.id >= NoiseVariantCount || entry.variant.palette >= NoisePaletteCount) {
+      Serial.printf("Noise: variant %u in %s is out of range\n", entry.id, path);
+      continue;
+    }
+    if (noiseOverrideCount == NOISE_OVERRIDES) {
+      Serial.printf("Noise: more than %u variants in %s\n", NOISE_OVERRIDES, path);
+      break;
+    }
+    noiseOverrides[noiseOverrideCount++] = entry;
+  }
+
+  file.close();
+  Serial.printf("Noise: %u variants replaced from %s\n", noiseOverrideCount, path);
+}
+
+// a speed or scaleBand
+uint8_t noiseAmount(uint8_t amount)
+{
+  if (amount & NOISE_FROM_BAND)
+    return spectrumByte[amount & 0x07] >> ((amount >> 4) & 0x07);
+  return amount;
+}
+
+CRGBPalette16 noisePalette(uint8_t palette)
+{
+  switch (palette) {
+    case NoiseRainbowStripe: return RainbowStripeColors_p;
+    case NoiseParty: return PartyColors_p;
+    case NoiseForest: return ForestColors_p;
+    case NoiseCloud: return CloudColors_p;
+    case NoiseHeat: return HeatColors_p;
+    case NoiseLava: return LavaColors_p;
+    case NoiseOcean: return OceanColors_p;
+    case NoiseBlackAndWhite:
+      SetupBlackAndWhiteStripedPalette();
+      return blackAndWhiteStripedPalette;
+    case NoiseBlackAndBlue:
+      SetupBlackAndBlueStripedPalette();
+      return blackAndBlueStripedPalette;
+    default: return RainbowColors_p;
+  }
+}
+
+void drawNoiseVariant(uint8_t id)
+{
+  NoiseVariant variant;
+  bool replaced = false;
+  for (uint8_t i = 0; i < noiseOverrideCount && !replaced; i++) {
+    if (noiseOverrides[i].id == id) {
+      variant = noiseOverrides[i].variant;
+      replaced = true;
+    }
+  }
+  if (!replaced)
+    memcpy_P(&variant, &noiseVariants[id], sizeof(variant));
+
+  noisespeedx = noiseAmount(variant.speedX);
+  noisespeedy = noiseAmount(variant.speedY);
+  noisespeedz = noiseAmount(variant.speedZ);
+  noisescale = (noiseZoom ? noiseZoom : variant.scale) + noiseAmount(variant.scaleBand);
+  colorLoop = variant.flags & NOISE_COLOR_LOOP;
+  drawNoise(noisePalette(variant.palette), variant.hueReduce);
+}
+
+// the patterns
+void rainbowAudioNoise() { drawNoiseVariant(RainbowAudioNoise); }
+void rainbowStripeAudioNoise() { drawNoiseVariant(RainbowStripeAudioNoise); }
+void partyAudioNoise() { drawNoiseVariant(PartyAudioNoise); }
+void forestAudioNoise() { drawNoiseVariant(ForestAudioNoise); }
+void cloudAudioNoise() { drawNoiseVariant(CloudAudioNoise); }
+void fireAudioNoise() { drawNoiseVariant(FireAudioNoise); }
+void lavaAudioNoise() { drawNoiseVariant(LavaAudioNoise); }
+void oceanAudioNoise() { drawNoiseVariant(OceanAudioNoise); }
+void blackAndWhiteAudioNoise() { drawNoiseVariant(BlackAndWhiteAudioNoise); }
+void blackAndBlueAudioNoise() { drawNoiseVariant(BlackAndBlueAudioNoise); }
+void rainbowNoise() { drawNoiseVariant(RainbowNoise); }
+void rainbowStripeNoise() { drawNoiseVariant(RainbowStripeNoise); }
+void partyNoise() { drawNoiseVariant(PartyNoise); }
+void forestNoise() { drawNoiseVariant(ForestNoise); }
+void cloudNoise() { drawNoiseVariant(CloudNoise); }
+void fireNoise() { drawNoiseVariant(FireNoise); }
+void lavaNoise() { drawNoiseVariant(LavaNoise); }
+void oceanNoise() { drawNoiseVariant(OceanNoise); }
+void blackAndWhiteNoise() { drawNoiseVariant(BlackAndWhiteNoise); }
+void blackAndBlueNoise() { drawNoiseVariant(BlackAndBlueNoise); }
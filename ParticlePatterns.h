@@ -0,0 +1,105 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Audio patterns drawn with the particle pool in Particles.h: an emitter
+// for each MSGEQ7 band, giving off particles as loud as the band is.
+//
+// Each draws only particles, so it erases last frame's and draws this
+// frame's, and what it costs goes with how many particles there are rather
+// than the length of the strip:
+//
+//   startParticles();
+//   eraseParticles1D(leds, NUM_LEDS);
+//   updateParticles(NUM_LEDS, 1);
+//   ...emit...
+//   renderParticles1D(leds, NUM_LEDS, palette);
+
+// The pool is shared, so when the pattern changes it starts from empty,
+// and on a black strip for the erasing to keep clear.
+void startParticles()
+{
+  static uint8_t owner = 255;
+  if (owner != currentPatternIndex) {
+    owner = currentPatternIndex;
+    clearParticles();
+    fill_solid(leds, MATRIX, CRGB::Black);
+  }
+}
+
+// Each band's place along the strip, or across the matrix.
+uint16_t bandParticleX(uint8_t band, uint16_t width)
+{
+  return (((2 * band + 1) * width / 14) << PARTICLE_SHIFT) + PARTICLE_ONE / 2;
+}
+
+// The bands spraying out both ways from their places along the strip.
+void particleFountain()
+{
+  startParticles();
+  particleGravityX = 0;
+  particleGravityY = 0;
+
+  eraseParticles1D(leds, NUM_LEDS);
+  updateParticles(NUM_LEDS, 1);
+
+  for (uint8_t band = 0; band < bandCount; band++) {
+    int16_t vx = random8() & 1 ? 48 : -48;
+    ParticleEmitter emitter = { bandParticleX(band, NUM_LEDS), 0, vx, 0, 24, 0, (uint8_t) (band * 36 + gHue), 6 };
+    emitParticles(emitter, spectrumByte[band]);
+  }
+
+  renderParticles1D(leds, NUM_LEDS, palettes[currentPaletteIndex]);
+}
+
+// Sparks thrown up from the bottom of the matrix, a column for each band,
+// that fall back down.
+void particleSparks()
+{
+  startParticles();
+  particleGravityX = 0;
+  particleGravityY = 3;
+
+  eraseParticles2D(leds, xyMap, kMatrixWidth, kMatrixHeight);
+  updateParticles(kMatrixWidth, kMatrixHeight);
+
+  for (uint8_t band = 0; band < bandCount; band++) {
+    ParticleEmitter emitter = { bandParticleX(band, kMatrixWidth), (kMatrixHeight - 1) << PARTICLE_SHIFT,
+                                0, -64, 32, 16, (uint8_t) (band * 36 + gHue), 5 };
+    emitParticles(emitter, spectrumByte[band]);
+  }
+
+  renderParticles2D(leds, xyMap, kMatrixWidth, kMatrixHeight, palettes[currentPaletteIndex]);
+}
+
+// Confetti that blinks in with the music: a louder band is more likely to
+// add a speckle, anywhere on the strip, in its own colour.
+void particleConfetti()
+{
+  startParticles();
+  particleGravityX = 0;
+  particleGravityY = 0;
+
+  eraseParticles1D(leds, NUM_LEDS);
+  updateParticles(NUM_LEDS, 1);
+
+  for (uint8_t band = 0; band < bandCount; band++) {
+    if (random8() < spectrumByte[band])
+      emitParticle(random16(NUM_LEDS) << PARTICLE_SHIFT, 0, 0, 0, band * 36 + gHue + random8(32), 8);
+  }
+
+  renderParticles1D(leds, NUM_LEDS, palettes[currentPaletteIndex]);
+}
@@ -0,0 +1,217 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// A pool of particles, for patterns that are dots moving and fading out.
+//
+// Drawing those by stamping pixels and fading the whole strip every frame
+// costs the same with one dot as with a hundred, and more the longer the
+// strip.  Here a frame costs a few operations per live particle: each
+// moves, slows or falls, loses some of its life (which is also its
+// brightness), and is drawn anti-aliased over two pixels on a strip, or
+// four on a grid.  A pattern that draws nothing else erases just the pixels
+// the particles were drawn on last frame, rather than clearing the strip.
+//
+// The pool is a fixed set of arrays, one per property, so a pass over the
+// particles walks them in order.  Live particles are kept at the front:
+// one that dies swaps with the last.  Positions and velocities are fixed
+// point, PARTICLE_SHIFT bits of fraction, so up to 1024 pixels across.
+//
+// Emitters turn the audio into particles: each has a place, a direction
+// and a colour, and gives off particles with its band's level.
+//
+// Nothing here knows about the sketch: the LEDs, the grid map and the
+// palette are passed in, so host/particles_bench.cpp can time it alone.
+
+#define PARTICLES_MAX 64
+#define PARTICLE_SHIFT 6
+#define PARTICLE_ONE (1 << PARTICLE_SHIFT)
+#define PARTICLE_LEVEL_STEP 64 // a particle a frame for each step of a band's level
+
+uint16_t particleX[PARTICLES_MAX];
+uint16_t particleY[PARTICLES_MAX];
+int16_t particleVX[PARTICLES_MAX];
+int16_t particleVY[PARTICLES_MAX];
+uint8_t particleLife[PARTICLES_MAX]; // also the brightness
+uint8_t particleDecay[PARTICLES_MAX]; // life lost each frame
+uint8_t particleColor[PARTICLES_MAX]; // palette index
+uint8_t particleCount = 0;
+
+// added to every velocity each frame, in the same fixed point
+int8_t particleGravityX = 0;
+int8_t particleGravityY = 0;
+
+struct ParticleEmitter {
+  uint16_t x; // fixed point
+  uint16_t y;
+  int16_t vx; // at full level, fixed point per frame
+  int16_t vy;
+  uint8_t spreadX; // random velocity added either way
+  uint8_t spreadY;
+  uint8_t color;
+  uint8_t decay;
+};
+
+void clearParticles()
+{
+  particleCount = 0;
+}
+
+// Returns false if the pool is full.
+bool emitParticle(uint16_t x, uint16_t y, int16_t vx, int16_t vy, uint8_t color, uint8_t decay)
+{
+  if (particleCount == PARTICLES_MAX)
+    return false;
+
+  uint8_t i = particleCount++;
+  particleX[i] = x;
+  particleY[i] = y;
+  particleVX[i] = vx;
+  particleVY[i] = vy;
+  particleLife[i] = 255;
+  particleDecay[i] = decay ? decay : 1;
+  particleColor[i] = color;
+  return true;
+}
+
+void removeParticle(uint8_t i)
+{
+  uint8_t last = --particleCount;
+  particleX[i] = particleX[last];
+  particleY[i] = particleY[last];
+  particleVX[i] = particleVX[last];
+  particleVY[i] = particleVY[last];
+  particleLife[i] = particleLife[last];
+  particleDecay[i] = particleDecay[last];
+  particleColor[i] = particleColor[last];
+}
+
+// Particles for one band: more and faster the louder it is.
+void emitParticles(const ParticleEmitter& emitter, uint8_t level)
+{
+  for (uint8_t n = level / PARTICLE_LEVEL_STEP; n > 0; n--) {
+    int16_t vx = ((int32_t) emitter.vx * level) >> 8;
+    int16_t vy = ((int32_t) emitter.vy * level) >> 8;
+    if (emitter.spreadX)
+      vx += (int16_t) random8(emitter.spreadX) - emitter.spreadX / 2;
+    if (emitter.spreadY)
+      vy += (int16_t) random8(emitter.spreadY) - emitter.spreadY / 2;
+    if (!emitParticle(emitter.x, emitter.y, vx, vy, emitter.color + random8(16), emitter.decay))
+      return;
+  }
+}
+
+// Move every particle a frame on, and drop those that have faded or left
+// the width x height pixels.
+void updateParticles(uint16_t width, uint16_t height)
+{
+  // a negative position wraps round to more than any limit
+  uint32_t xLimit = (uint32_t) width << PARTICLE_SHIFT;
+  uint32_t yLimit = (uint32_t) height << PARTICLE_SHIFT;
+
+  uint8_t i = 0;
+  while (i < particleCount) {
+    particleVX[i] += particleGravityX;
+    particleVY[i] += particleGravityY;
+    uint32_t x = (uint32_t) (particleX[i] + particleVX[i]);
+    uint32_t y = (uint32_t) (particleY[i] + particleVY[i]);
+
+    if (x >= xLimit || y >= yLimit || particleLife[i] <= particleDecay[i]) {
+      removeParticle(i);
+      continue;
+    }
+
+    particleX[i] = x;
+    particleY[i] = y;
+    particleLife[i] -= particleDecay[i];
+    i++;
+  }
+}
+
+// Black out the pixels renderParticles1D() drew the particles on, for a
+// pattern that draws nothing else.  Call it before updateParticles() moves
+// them.
+void eraseParticles1D(CRGB* leds, uint16_t count)
+{
+  for (uint8_t i = 0; i < particleCount; i++) {
+    uint16_t pixel = particleX[i] >> PARTICLE_SHIFT;
+    if (pixel < count)
+      leds[pixel] = CRGB::Black;
+    if (pixel + 1 < count)
+      leds[pixel + 1] = CRGB::Black;
+  }
+}
+
+// The same for renderParticles2D().
+void eraseParticles2D(CRGB* leds, const uint16_t* map, uint8_t width, uint8_t height)
+{
+  for (uint8_t i = 0; i < particleCount; i++) {
+    uint8_t x = particleX[i] >> PARTICLE_SHIFT;
+    uint8_t y = particleY[i] >> PARTICLE_SHIFT;
+    uint16_t row = y * width;
+
+    leds[map[row + x]] = CRGB::Black;
+    if (x + 1 < width)
+      leds[map[row + x + 1]] = CRGB::Black;
+    if (y + 1 < height) {
+      leds[map[row + width + x]] = CRGB::Black;
+      if (x + 1 < width)
+        leds[map[row + width + x + 1]] = CRGB::Black;
+    }
+  }
+}
+
+// Draw onto a strip of count LEDs, each particle split between the two
+// pixels it is between.  Adds to what is there.
+void renderParticles1D(CRGB* leds, uint16_t count, const CRGBPalette16& palette)
+{
+  for (uint8_t i = 0; i < particleCount; i++) {
+    uint16_t pixel = particleX[i] >> PARTICLE_SHIFT;
+    uint8_t fraction = (particleX[i] & (PARTICLE_ONE - 1)) << (8 - PARTICLE_SHIFT);
+    CRGB color = ColorFromPalette(palette, particleColor[i], particleLife[i]);
+
+    if (pixel < count)
+      leds[pixel] += CRGB(color).nscale8(255 - fraction);
+    if (fraction && pixel + 1 < count)
+      leds[pixel + 1] += color.nscale8(fraction);
+  }
+}
+
+// Draw onto a width x height grid, through map (row by row, as the
+// sketch's xyMap from the layout), each particle split between the four
+// pixels it is between.  Adds to what is there.
+void renderParticles2D(CRGB* leds, const uint16_t* map, uint8_t width, uint8_t height, const CRGBPalette16& palette)
+{
+  for (uint8_t i = 0; i < particleCount; i++) {
+    uint8_t x = particleX[i] >> PARTICLE_SHIFT;
+    uint8_t y = particleY[i] >> PARTICLE_SHIFT;
+    uint8_t fx = (particleX[i] & (PARTICLE_ONE - 1)) << (8 - PARTICLE_SHIFT);
+    uint8_t fy = (particleY[i] & (PARTICLE_ONE - 1)) << (8 - PARTICLE_SHIFT);
+    CRGB color = ColorFromPalette(palette, particleColor[i], particleLife[i]);
+
+    bool right = fx && x + 1 < width;
+    bool below = fy && y + 1 < height;
+    uint16_t row = y * width;
+
+    leds[map[row + x]] += CRGB(color).nscale8(scale8(255 - fx, 255 - fy));
+    if (right)
+      leds[map[row + x + 1]] += CRGB(color).nscale8(scale8(fx, 255 - fy));
+    if (below)
+      leds[map[row + width + x]] += CRGB(color).nscale8(scale8(255 - fx, fy));
+    if (right && below)
+      leds[map[row + width + x + 1]] += color.nscale8(scale8(fx, fy));
+  }
+}
@@ -0,0 +1,305 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Settings of the current pattern, each pattern with its own.
+//
+// A param is a global that patterns read, listed in paramInfo[] with the
+// value it has when the current pattern doesn't use it.  A pattern that
+// does has a row in patternParams[], in flash: the param, and its range
+// and default for that pattern.  Switching patterns puts every param back
+// to its value in paramInfo[] and then applies the new pattern's, so
+// tuning one pattern can't change another.
+//
+// The current pattern's params are the fields param0 to param3 (see
+// Fields.h).  Switching patterns changes their labels, types, ranges and
+// values; slots the pattern doesn't use are Hidden.  The web app reloads
+// them from /all when the pattern changes.
+//
+// Values that differ from the pattern's default are kept in RAM, and saved
+// to /params.bin PARAMS_WRITE_DELAY ms after the last change, little
+// endian:
+//
+//   offset  size
+//        0     4  magic "PRM1"
+//        4     1  count
+//        5     3  reserved, 0
+//        8   3*n  pattern index, ParamId, value
+//
+// On load, values for a pattern that no longer has that param are dropped.
+
+#define PARAM_SLOTS 4
+#define PARAMS_STORED 48
+#define PARAMS_FILE "/params.bin"
+#define PARAMS_FILE_MAGIC "PRM1"
+#define PARAMS_FILE_HEADER_SIZE 8
+#define PARAMS_WRITE_DELAY 3000
+
+// the analyzers draw the right channel bandCount columns to the right of
+// the left one, which has to stay on the matrix
+#define BAND_OFFSET_MAX (kMatrixWidth - 2 * bandCount)
+
+enum ParamType {
+  ParamNumber,
+  ParamBoolean
+};
+
+// Ids for the entries in paramInfo[], in the same order.  /params.bin
+// refers to them by number, so append rather than reordering.
+enum ParamId {
+  VUFadeParam,
+  BeatLevelParam,
+  BandOffsetParam,
+  DrawPeaksParam,
+  NoiseZoomParam,
+  ParamIdCount
+};
+
+struct ParamInfo {
+  const char* label;
+  uint8_t type;
+  uint8_t defaultValue;
+  uint8_t* value;
+};
+
+ParamInfo paramInfo[ParamIdCount] = {
+  { "VU Fade", ParamNumber, 5, &VUFadeFactor },
+  { "Beat Level", ParamNumber, 20, &beatLevel },
+  { "Band Offset", ParamNumber, 3, &bandOffset },
+  { "Draw Peaks", ParamBoolean, 1, &drawPeaks },
+  { "Noise Zoom (0 = the pattern's own)", ParamNumber, 0, &noiseZoom },
+};
+
+struct PatternParam {
+  Pattern pattern;
+  uint8_t param;
+  uint8_t min;
+  uint8_t max;
+  uint8_t defaultValue;
+};
+
+const PatternParam patternParams[] PROGMEM = {
+  { drawVU,                  VUFadeParam,     1, 20,              5 },
+  { drawVUmatrix,            VUFadeParam,     1, 20,              5 },
+  { beatWaves,               BeatLevelParam,  1, 100,             20 },
+
+  { analyzerColumns1,        BandOffsetParam, 0, BAND_OFFSET_MAX, 3 },
+  { analyzerColumns1,        DrawPeaksParam,  0, 1,               1 },
+  { analyzerColumnsSolid,    BandOffsetParam, 0, BAND_OFFSET_MAX, 3 },
+  { analyzerColumnsSolid,    DrawPeaksParam,  0, 1,               1 },
+  { analyzerPixels,          BandOffsetParam, 0, BAND_OFFSET_MAX, 3 },
+  { analyzerPixels,          DrawPeaksParam,  0, 1,               1 },
+  { fallingSpectrogram,      BandOffsetParam, 0, BAND_OFFSET_MAX, 3 },
+  { fallingSpectrogram,      DrawPeaksParam,  0, 1,               1 },
+  { audioFire,               BandOffsetParam, 0, BAND_OFFSET_MAX, 3 },
+  { audioFire,               DrawPeaksParam,  0, 1,               1 },
+
+  { rainbowAudioNoise,       NoiseZoomParam,  0, 255,             0 },
+  { rainbowStripeAudioNoise, NoiseZoomParam,  0, 255,             0 },
+  { partyAudioNoise,         NoiseZoomParam,  0, 255,             0 },
+  { forestAudioNoise,        NoiseZoomParam,  0, 255,             0 },
+  { cloudAudioNoise,         NoiseZoomParam,  0, 255,             0 },
+  { fireAudioNoise,          NoiseZoomParam,  0, 255,             0 },
+  { lavaAudioNoise,          NoiseZoomParam,  0, 255,             0 },
+  { oceanAudioNoise,         NoiseZoomParam,  0, 255,             0 },
+  { blackAndWhiteAudioNoise, NoiseZoomParam,  0, 255,             0 },
+  { blackAndBlueAudioNoise,  NoiseZoomParam,  0, 255,             0 },
+  { rainbowNoise,            NoiseZoomParam,  0, 255,             0 },
+  { rainbowStripeNoise,      NoiseZoomParam,  0, 255,             0 },
+  { partyNoise,              NoiseZoomParam,  0, 255,             0 },
+  { forestNoise,             NoiseZoomParam,  0, 255,             0 },
+  { cloudNoise,              NoiseZoomParam,  0, 255,             0 },
+  { fireNoise,               NoiseZoomParam,  0, 255,             0 },
+  { lavaNoise,               NoiseZoomParam,  0, 255,             0 },
+  { oceanNoise,              NoiseZoomParam,  0, 255,             0 },
+  { blackAndWhiteNoise,      NoiseZoomParam,  0, 255,             0 },
+  { blackAndBlueNoise,       NoiseZoomParam,  0, 255,             0 },
+};
+
+const uint8_t patternParamCount = ARRAY_SIZE(patternParams);
+
+struct StoredParam {
+  uint8_t pattern;
+  uint8_t param;
+  uint8_t value;
+};
+
+StoredParam storedParams[PARAMS_STORED];
+uint8_t storedParamCount = 0;
+bool paramsDirty = false;
+uint32_t paramsChangedMillis = 0;
+
+uint8_t paramSlots[PARAM_SLOTS]; // the ParamId in each slot
+uint8_t paramSlotCount = 0;
+uint8_t paramsPatternIndex = 255; // the pattern the params are applied for
+
+// The row for param in pattern's schema, if it has one.
+bool findPatternParam(uint8_t pattern, uint8_t param, PatternParam& row)
+{
+  for (uint8_t i = 0; i < patternParamCount; i++) {
+    memcpy_P(&row, &patternParams[i], sizeof(row));
+    if (row.pattern == patterns[pattern].pattern && row.param == param)
+      return true;
+  }
+  return false;
+}
+
+// Index of the stored value, or storedParamCount if there is none.
+uint8_t findStoredParam(uint8_t pattern, uint8_t param)
+{
+  uint8_t i = 0;
+  while (i < storedParamCount && (storedParams[i].pattern != pattern || storedParams[i].param != param))
+    i++;
+  return i;
+}
+
+// Point the param fields at the current pattern's params and give them
+// their values.  Called from loop() whenever the pattern has changed.
+void applyPatternParams()
+{
+  paramsPatternIndex = currentPatternIndex;
+
+  for (uint8_t i = 0; i < ParamIdCount; i++)
+    *paramInfo[i].value = paramInfo[i].defaultValue;
+
+  paramSlotCount = 0;
+  for (uint8_t i = 0; i < patternParamCount && paramSlotCount < PARAM_SLOTS; i++) {
+    PatternParam row;
+    memcpy_P(&row, &patternParams[i], sizeof(row));
+    if (row.pattern != patterns[currentPatternIndex].pattern)
+      continue;
+
+    const ParamInfo& info = paramInfo[row.param];
+    uint8_t stored = findStoredParam(currentPatternIndex, row.param);
+    *info.value = stored < storedParamCount ? storedParams[stored].value : row.defaultValue;
+
+    Field& field = fields[Param0Field + paramSlotCount];
+    field.label = info.label;
+    field.type = info.type == ParamBoolean ? BooleanFieldType : NumberFieldType;
+    field.min = row.min;
+    field.max = row.max;
+    field.value = info.value;
+
+    paramSlots[paramSlotCount++] = row.param;
+  }
+
+  for (uint8_t slot = 0; slot < PARAM_SLOTS; slot++) {
+    if (slot >= paramSlotCount) {
+      Field& field = fields[Param0Field + slot];
+      field.label = "";
+      field.type = HiddenFieldType;
+      field.min = 0;
+      field.max = 0;
+      field.value = &hiddenParamValue;
+    }
+    broadcastField(Param0Field + slot);
+  }
+}
+
+// Keep a new value of one of the current pattern's params, to be saved.
+void storePatternParam(uint8_t param, uint8_t value)
+{
+  PatternParam row;
+  if (!findPatternParam(currentPatternIndex, param, row))
+    return;
+
+  uint8_t i = findStoredParam(currentPatternIndex, param);
+  if (value == row.defaultValue) {
+    if (i == storedParamCount)
+      return;
+    storedParams[i] = storedParams[--storedParamCount];
+  }
+  else if (i < storedParamCount) {
+    if (storedParams[i].value == value)
+      return;
+    storedParams[i].value = value;
+  }
+  else if (storedParamCount < PARAMS_STORED) {
+    storedParams[storedParamCount++] = { currentPatternIndex, param, value };
+  }
+  else {
+    Serial.printf("Params: more than %u changed, not saved\n", PARAMS_STORED);
+    return;
+  }
+
+  paramsDirty = true;
+  paramsChangedMillis = millis();
+}
+
+void loadPatternParams()
+{
+  storedParamCount = 0;
+
+  File file = SPIFFS.open(PARAMS_FILE, "r");
+  if (!file)
+    return;
+
+  uint8_t header[PARAMS_FILE_HEADER_SIZE];
+  if (file.read(header, sizeof(header)) != sizeof(header) || memcmp(header, PARAMS_FILE_MAGIC, 4) != 0) {
+    Serial.printf("Params: %s is not a params file\n", PARAMS_FILE);
+    file.close();
+    return;
+  }
+
+  uint8_t dropped = 0;
+  for (uint8_t i = 0; i < header[4] && storedParamCount < PARAMS_STORED; i++) {
+    StoredParam stored;
+    if (file.read((uint8_t*) &stored, sizeof(stored)) != sizeof(stored))
+      break;
+
+    PatternParam row;
+    if (stored.pattern >= patternCount || !findPatternParam(stored.pattern, stored.param, row) ||
+        stored.value < row.min || stored.value > row.max) {
+      dropped++;
+      continue;
+    }
+    storedParams[storedParamCount++] = stored;
+  }
+
+  file.close();
+  Serial.printf("Params: %u loaded, %u dropped\n", storedParamCount, dropped);
+}
+
+bool savePatternParams()
+{
+  File file = SPIFFS.open(PARAMS_FILE, "w");
+  if (!file)
+    return false;
+
+  uint8_t header[PARAMS_FILE_HEADER_SIZE] = {};
+  memcpy(header, PARAMS_FILE_MAGIC, 4);
+  header[4] = storedParamCount;
+  bool ok = file.write(header, sizeof(header)) == sizeof(header) &&
+            file.write((const uint8_t*) storedParams, storedParamCount * sizeof(StoredParam)) == storedParamCount * sizeof(StoredParam);
+  file.close();
+  return ok;
+}
+
+// Called once a loop(): applies the params when the pattern has changed,
+// and saves them once they have settled.
+void handlePatternParams()
+{
+  if (currentPatternIndex != paramsPatternIndex)
+    applyPatternParams();
+
+  if (paramsDirty && millis() - paramsChangedMillis >= PARAMS_WRITE_DELAY) {
+    // on failure, try again after another delay
+    if (savePatternParams())
+      paramsDirty = false;
+    else
+      paramsChangedMillis = millis();
+  }
+}
@@ -0,0 +1,238 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Live preview of the matrix for the web app, sent over the WebSocket
+// protocol (see Protocol.h):
+//
+//   client -> device
+//     0x05 PREVIEW_SUBSCRIBE    fps     start getting frames, 1 to PREVIEW_MAX_FPS
+//     0x06 PREVIEW_UNSUBSCRIBE
+//     0x07 PREVIEW_ACK          seq     the client has drawn frame seq
+//
+//   device -> client
+//     0x82 PREVIEW_FRAME  seq flags width height  ops...
+//
+// A frame is the matrix in raster order (x across, then y down), encoded
+// against the previous frame as a list of ops:
+//
+//   00nnnnnn              n + 1 pixels unchanged
+//   01nnnnnn r g b        n + 1 pixels of one color
+//   1nnnnnnn r g b ...    n + 1 pixels, listed
+//
+// A key frame (flags bit 0) has no unchanged ops, so a client that has just
+// subscribed, or has missed a frame, can draw it from scratch.
+//
+// Nothing is encoded unless somebody has subscribed.  Each client may have
+// PREVIEW_MAX_IN_FLIGHT frames sent but not acked; while it is at that limit
+// its frames are dropped instead of queueing up behind a slow connection and
+// stalling loop(), and it gets a key frame once it catches up.
+
+#define PREVIEW_SUBSCRIBE   0x05
+#define PREVIEW_UNSUBSCRIBE 0x06
+#define PREVIEW_ACK         0x07
+#define PREVIEW_FRAME       0x82
+
+#define PREVIEW_MAX_FPS 30
+#define PREVIEW_MAX_IN_FLIGHT 2
+#define PREVIEW_CLIENTS 8
+
+#define PREVIEW_PIXELS (kMatrixWidth * kMatrixHeight)
+#define PREVIEW_HEADER_SIZE 5
+// worst case is every pixel listed, one op header per 128 pixels
+#define PREVIEW_BUFFER_SIZE (PREVIEW_HEADER_SIZE + PREVIEW_PIXELS * 3 + PREVIEW_PIXELS / 128 + 1)
+
+uint8_t previewSubscribers = 0; // one bit per WebSocket client number
+uint8_t previewOutOfSync = 0;   // subscribers that need a key frame
+uint8_t previewFps[PREVIEW_CLIENTS];
+uint8_t previewSent[PREVIEW_CLIENTS];
+uint8_t previewAcked[PREVIEW_CLIENTS];
+
+uint8_t previewSequence = 0;
+uint16_t previewInterval = 0;
+uint32_t previewLastMillis = 0;
+uint32_t previewFramesSent = 0;
+uint32_t previewFramesDropped = 0;
+
+CRGB previewFrame[PREVIEW_PIXELS]; // the last frame sent, as in-sync clients have it
+uint8_t previewBuffer[PREVIEW_BUFFER_SIZE];
+
+CRGB getPreviewPixel(uint16_t i)
+{
+  return leds[XY(i % kMatrixWidth, i / kMatrixWidth)];
+}
+
+uint16_t encodePreviewFrame(bool keyFrame)
+{
+  uint8_t* out = previewBuffer;
+  uint16_t length = 0;
+
+  out[length++] = PREVIEW_FRAME;
+  out[length++] = previewSequence;
+  out[length++] = keyFrame ? 1 : 0;
+  out[length++] = kMatrixWidth;
+  out[length++] = kMatrixHeight;
+
+  uint16_t i = 0;
+  while (i < PREVIEW_PIXELS) {
+    CRGB color = getPreviewPixel(i);
+    uint8_t n = 1;
+
+    if (!keyFrame && color == previewFrame[i]) {
+      while (i + n < PREVIEW_PIXELS && n < 64 && getPreviewPixel(i + n) == previewFrame[i + n])
+        n++;
+      out[length++] = n - 1;
+      i += n;
+      continue;
+    }
+
+    while (i + n < PREVIEW_PIXELS && n < 64 && getPreviewPixel(i + n) == color)
+      n++;
+
+    if (n >= 2) {
+      out[length++] = 0x40 | (n - 1);
+      out[length++] = color.r;
+      out[length++] = color.g;
+      out[length++] = color.b;
+      i += n;
+      continue;
+    }
+
+    // list pixels until one is unchanged or starts a run worth repeating
+    uint16_t header = length++;
+    n = 0;
+    while (i < PREVIEW_PIXELS && n < 128) {
+      color = getPreviewPixel(i);
+      if (!keyFrame && color == previewFrame[i])
+        break;
+      if (n > 0 && i + 2 < PREVIEW_PIXELS && getPreviewPixel(i + 1) == color && getPreviewPixel(i + 2) == color)
+        break;
+      out[length++] = color.r;
+      out[length++] = color.g;
+      out[length++] = color.b;
+      n++;
+      i++;
+    }
+    out[header] = 0x80 | (n - 1);
+  }
+
+  return length;
+}
+
+void sendPreviewFrame(uint8_t clients, uint16_t length)
+{
+  for (uint8_t num = 0; num < PREVIEW_CLIENTS; num++) {
+    uint8_t bit = 1 << num;
+    if (!(clients & bit))
+      continue;
+
+    if (webSocketsServer.sendBIN(num, previewBuffer, length)) {
+      previewSent[num] = previewSequence;
+      previewOutOfSync &= ~bit;
+      previewFramesSent++;
+    }
+    else {
+      previewOutOfSync |= bit;
+      previewFramesDropped++;
+    }
+  }
+}
+
+// Called once a frame, after FastLED.show().
+void sendPreview()
+{
+  if (!previewSubscribers)
+    return;
+
+  uint32_t now = millis();
+  if (now - previewLastMillis < previewInterval)
+    return;
+  previewLastMillis = now;
+
+  uint8_t ready = 0;
+  for (uint8_t num = 0; num < PREVIEW_CLIENTS; num++) {
+    uint8_t bit = 1 << num;
+    if (!(previewSubscribers & bit))
+      continue;
+
+    if ((uint8_t) (previewSent[num] - previewAcked[num]) < PREVIEW_MAX_IN_FLIGHT) {
+      ready |= bit;
+    }
+    else {
+      // too far behind, skip this frame and start it again from a key frame
+      previewOutOfSync |= bit;
+      previewFramesDropped++;
+    }
+  }
+
+  if (!ready)
+    return;
+
+  previewSequence++;
+
+  uint8_t inSync = ready & ~previewOutOfSync;
+  uint8_t behind = ready & previewOutOfSync;
+
+  if (inSync)
+    sendPreviewFrame(inSync, encodePreviewFrame(false));
+  if (behind)
+    sendPreviewFrame(behind, encodePreviewFrame(true));
+
+  for (uint16_t i = 0; i < PREVIEW_PIXELS; i++)
+    previewFrame[i] = getPreviewPixel(i);
+}
+
+void updatePreviewInterval()
+{
+  uint8_t fps = 0;
+  for (uint8_t num = 0; num < PREVIEW_CLIENTS; num++) {
+    if (previewSubscribers & (1 << num))
+      fps = max(fps, previewFps[num]);
+  }
+  previewInterval = fps ? 1000 / fps : 0;
+}
+
+void unsubscribePreview(uint8_t num)
+{
+  previewSubscribers &= ~(1 << num);
+  previewOutOfSync &= ~(1 << num);
+  updatePreviewInterval();
+}
+
+void handlePreviewMessage(uint8_t num, const uint8_t* payload, size_t length)
+{
+  if (num >= PREVIEW_CLIENTS)
+    return;
+
+  switch (payload[0]) {
+    case PREVIEW_SUBSCRIBE:
+      previewFps[num] = constrain(length > 1 ? payload[1] : 10, 1, PREVIEW_MAX_FPS);
+      previewSent[num] = previewAcked[num] = previewSequence;
+      previewSubscribers |= 1 << num;
+      previewOutOfSync |= 1 << num;
+      updatePreviewInterval();
+      break;
+
+    case PREVIEW_UNSUBSCRIBE:
+      unsubscribePreview(num);
+      break;
+
+    case PREVIEW_ACK:
+      if (length > 1)
+        previewAcked[num] = payload[1];
+      break;
+  }
+}
@@ -0,0 +1,258 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Binary WebSocket control protocol.  Every message is one binary frame that
+// starts with an opcode byte:
+//
+//   client -> device
+//     0x01 GET          id            ask for the value of a field
+//     0x02 SET          id value...   set a field
+//     0x03 SUBSCRIBE                  get VALUE messages instead of JSON text for
+//                                     every change, starting with every field now
+//     0x04 UNSUBSCRIBE                back to JSON text
+//     0x05-0x07                       live preview, see Preview.h
+//     0x08-0x09                       audio telemetry, see Telemetry.h
+//     0x0A                            metrics, see Metrics.h
+//
+//   device -> client
+//     0x81 VALUE        id value...   reply to GET, and change notifications,
+//                                     which can list several id value pairs
+//     0x82                            live preview frame, see Preview.h
+//     0x83                            audio telemetry, see Telemetry.h
+//     0xFF ERROR        opcode id     unknown field, wrong length or read-only
+//
+// id is the field's index in fields[], which is also its index in the /all
+// array.  The value is one byte, or r, g, b for a Color field.
+//
+// Messages are parsed in place and replies built on the stack, so nothing here
+// touches the heap.
+//
+// SETs are not applied straight away but posted to the command queue (see
+// CommandQueue.h) and applied at the start of the next frame.  Changes are
+// broadcast once a frame as well: broadcastField() only notes the field, and
+// sendBroadcasts() sends one VALUE message, or one JSON array to text
+// clients, with everything that changed.
+
+#define PROTOCOL_GET         0x01
+#define PROTOCOL_SET         0x02
+#define PROTOCOL_SUBSCRIBE   0x03
+#define PROTOCOL_UNSUBSCRIBE 0x04
+#define PROTOCOL_VALUE       0x81
+#define PROTOCOL_ERROR       0xFF
+
+#define PROTOCOL_MAX_VALUE_SIZE 3
+#define PROTOCOL_JSON_SIZE 384
+
+static_assert(FieldIdCount <= 32, "broadcastPending has one bit per field");
+
+// one bit per WebSocket client number
+uint8_t webSocketClients = 0;
+uint8_t binarySubscribers = 0;
+
+uint32_t broadcastPending = 0; // one bit per field id
+
+// id value..., as in a VALUE message
+uint8_t writeFieldIdValue(uint8_t* out, uint8_t id)
+{
+  const Field& field = fields[id];
+  uint8_t size = getFieldValueSize(field);
+
+  out[0] = id;
+  memcpy(out + 1, field.value, size);
+  return size + 1;
+}
+
+uint8_t writeFieldValue(uint8_t* message, uint8_t id)
+{
+  message[0] = PROTOCOL_VALUE;
+  return writeFieldIdValue(message + 1, id) + 1;
+}
+
+void sendProtocolError(uint8_t num, uint8_t opcode, uint8_t id)
+{
+  uint8_t message[3] = { PROTOCOL_ERROR, opcode, id };
+  webSocketsServer.sendBIN(num, message, sizeof(message));
+}
+
+// Note that a field has a new value, for sendBroadcasts() to tell every
+// client about.
+void broadcastField(uint8_t id)
+{
+  if (id < fieldCount && fields[id].value)
+    broadcastPending |= 1UL << id;
+}
+
+void sendTextBroadcast(uint8_t clients, char* json)
+{
+  for (uint8_t num = 0; num < 8; num++) {
+    if (clients & (1 << num))
+      webSocketsServer.sendTXT(num, json);
+  }
+}
+
+// Called once a frame: send the fields that have changed, binary to
+// subscribers, a JSON array to anyone else (built only if someone needs
+// it).
+void sendBroadcasts()
+{
+  if (!broadcastPending)
+    return;
+
+  uint32_t pending = broadcastPending;
+  broadcastPending = 0;
+
+  uint8_t textClients = webSocketClients & ~binarySubscribers;
+
+  if (binarySubscribers) {
+    uint8_t message[1 + FieldIdCount * (1 + PROTOCOL_MAX_VALUE_SIZE)];
+    uint8_t length = 0;
+    message[length++] = PROTOCOL_VALUE;
+
+    for (uint8_t id = 0; id < fieldCount; id++) {
+      if (pending & (1UL << id))
+        length += writeFieldIdValue(message + length, id);
+    }
+
+    for (uint8_t num = 0; num < 8; num++) {
+      if (binarySubscribers & (1 << num))
+        webSocketsServer.sendBIN(num, message, length);
+    }
+  }
+
+  if (textClients) {
+    char json[PROTOCOL_JSON_SIZE];
+    size_t length = 0;
+
+    for (uint8_t id = 0; id < fieldCount; id++) {
+      if (!(pending & (1UL << id)))
+        continue;
+
+      const Field& field = fields[id];
+      char value[12];
+      formatFieldValue(value, sizeof(value), field);
+      const char* quote = field.type == ColorFieldType ? "\"" : "";
+
+      char item[64];
+      int itemLength = snprintf(item, sizeof(item), "{\"name\":\"%s\",\"value\":%s%s%s}", field.name.c_str(), quote, value, quote);
+      // cut short it would not be JSON, so a field with a name too long to
+      // fit is left to the binary subscribers and /all
+      if (itemLength < 0 || (size_t) itemLength >= sizeof(item))
+        continue;
+
+      // a long list goes out as more than one array
+      if (length > 0 && length + 1 + itemLength + 2 > sizeof(json)) {
+        json[length++] = ']';
+        json[length] = 0;
+        sendTextBroadcast(textClients, json);
+        length = 0;
+      }
+
+      json[length] = length == 0 ? '[' : ',';
+      length++;
+      memcpy(json + length, item, itemLength);
+      length += itemLength;
+    }
+
+    json[length++] = ']';
+    json[length] = 0;
+    sendTextBroadcast(textClients, json);
+  }
+}
+
+void handleProtocolMessage(uint8_t num, const uint8_t* payload, size_t length)
+{
+  if (length == 0)
+    return;
+
+  uint8_t opcode = payload[0];
+
+  switch (opcode) {
+    case PROTOCOL_SUBSCRIBE:
+      binarySubscribers |= 1 << num;
+      for (uint8_t id = 0; id < fieldCount; id++) {
+        if (fields[id].value) {
+          uint8_t message[2 + PROTOCOL_MAX_VALUE_SIZE];
+          webSocketsServer.sendBIN(num, message, writeFieldValue(message, id));
+        }
+      }
+      return;
+
+    case PROTOCOL_UNSUBSCRIBE:
+      binarySubscribers &= ~(1 << num);
+      return;
+
+    case PREVIEW_SUBSCRIBE:
+    case PREVIEW_UNSUBSCRIBE:
+    case PREVIEW_ACK:
+      handlePreviewMessage(num, payload, length);
+      return;
+
+    case TELEMETRY_SUBSCRIBE:
+    case TELEMETRY_UNSUBSCRIBE:
+      handleTelemetryMessage(num, payload, length);
+      return;
+
+    case METRICS:
+      handleMetricsMessage(num, payload, length);
+      return;
+
+    case PROTOCOL_GET:
+    case PROTOCOL_SET:
+      break;
+
+    default:
+      sendProtocolError(num, opcode, 0);
+      return;
+  }
+
+  uint8_t id = length > 1 ? payload[1] : 0xFF;
+  if (id >= fieldCount || !fields[id].value) {
+    sendProtocolError(num, opcode, id);
+    return;
+  }
+
+  const Field& field = fields[id];
+
+  if (opcode == PROTOCOL_GET) {
+    uint8_t message[2 + PROTOCOL_MAX_VALUE_SIZE];
+    webSocketsServer.sendBIN(num, message, writeFieldValue(message, id));
+    return;
+  }
+
+  if (!field.set || length != (size_t) (2 + getFieldValueSize(field))) {
+    sendProtocolError(num, opcode, id);
+    return;
+  }
+
+  // the new value is broadcast once it has been applied, including back to
+  // this client
+  if (!postCommand(id, payload + 2))
+    sendProtocolError(num, opcode, id);
+}
+
+void handleProtocolConnect(uint8_t num)
+{
+  webSocketClients |= 1 << num;
+}
+
+void handleProtocolDisconnect(uint8_t num)
+{
+  webSocketClients &= ~(1 << num);
+  binarySubscribers &= ~(1 << num);
+  unsubscribePreview(num);
+  unsubscribeTelemetry(num);
+}
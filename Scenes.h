@@ -0,0 +1,338 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// What autoplay plays: a playlist of scenes.
+//
+// A scene is a pattern with, optionally, a palette, a brightness, a value
+// for one of the pattern's params (see PatternParams.h) and how long it
+// lasts.  It can also end early on what the audio does: a drop (the bass
+// coming back hard after a quieter stretch) or the music stopping.  Either
+// can happen in the first SCENE_MIN_MILLIS, when a scene can't end yet: a
+// drop is kept until then, and silence that began during the scene still
+// ends it once it can.  The playlist plays its scenes in order, or picks
+// the next at random by weight.
+//
+// A scene's palette and brightness are only for while it plays: turning
+// autoplay off puts back the palette and brightness settings.
+//
+// The playlist is /scenes.bin, made by tools/mkscenes.py and read once at
+// boot, so changing scenes doesn't touch SPIFFS.  Little endian:
+//
+//   offset  size
+//        0     4  magic "SCN1"
+//        4     1  count, at most SCENES_MAX
+//        5     1  PlaylistMode
+//        6     2  reserved, 0
+//        8   8*n  scenes:
+//                   pattern     index in patterns[]
+//                   palette     index in palettes[], or SCENE_KEEP
+//                   brightness  share of the brightness setting, 255 for all
+//                   duration    seconds, 0 for the autoplay duration field
+//                   weight      how likely a weighted playlist picks it
+//                   flags       SCENE_ADVANCE_ON_DROP, _ON_SILENCE
+//                   param       a ParamId, or SCENE_KEEP
+//                   paramValue
+//
+// Without the file, autoplay steps through patterns[] as it always has,
+// leaving out the test patterns.
+//
+//   GET /scenes   the playlist and the scene playing, as JSON
+
+#define SCENES_MAX 32
+#define SCENES_FILE "/scenes.bin"
+#define SCENES_FILE_MAGIC "SCN1"
+#define SCENES_FILE_HEADER_SIZE 8
+
+#define SCENE_KEEP 255
+#define SCENE_ADVANCE_ON_DROP 0x01
+#define SCENE_ADVANCE_ON_SILENCE 0x02
+
+#define SCENE_MIN_MILLIS 4000 // before the audio can end a scene
+#define SCENE_SILENCE_LEVEL 8 // every band's spectrumByte under it
+#define SCENE_SILENCE_MILLIS 2000
+#define SCENE_DROP_RISE 80 // of the fast bass average over the slow one
+
+enum PlaylistMode {
+  PlaylistOrdered,
+  PlaylistWeighted,
+  PlaylistModeCount
+};
+
+const char* const playlistModeNames[PlaylistModeCount] = { "ordered", "weighted" };
+
+struct Scene {
+  uint8_t pattern;
+  uint8_t palette;
+  uint8_t brightness;
+  uint8_t duration;
+  uint8_t weight;
+  uint8_t flags;
+  uint8_t param;
+  uint8_t paramValue;
+};
+
+Scene scenes[SCENES_MAX];
+uint8_t sceneCount = 0;
+uint8_t playlistMode = PlaylistOrdered;
+
+bool scenePlaying = false;
+uint8_t currentScene = 0;
+uint32_t sceneStartMillis = 0;
+uint8_t sceneBrightness = 255;
+
+// bass level << 4, averaged over about 4 and about 128 frames
+uint16_t sceneBassFast = 0;
+uint16_t sceneBassSlow = 0;
+bool sceneDropArmed = false;
+bool sceneDropped = false; // a drop since the scene started
+uint32_t sceneLoudMillis = 0;
+bool sceneSilent = false;
+bool scenePaletteSet = false; // a scene has changed the palette from the setting
+
+void loadScenes()
+{
+  sceneCount = 0;
+
+  File file = SPIFFS.open(SCENES_FILE, "r");
+  if (!file)
+    return;
+
+  uint8_t header[SCENES_FILE_HEADER_SIZE];
+  if (file.read(header, sizeof(header)) != sizeof(header) || memcmp(header, SCENES_FILE_MAGIC, 4) != 0) {
+    Serial.printf("Scenes: %s is not a playlist\n", SCENES_FILE);
+    file.close();
+    return;
+  }
+
+  playlistMode = header[5] < PlaylistModeCount ? header[5] : PlaylistOrdered;
+
+  uint8_t dropped = 0;
+  for (uint8_t i = 0; i < header[4] && sceneCount < SCENES_MAX; i++) {
+    Scene scene;
+    if (file.read((uint8_t*) &scene, sizeof(scene)) != sizeof(scene))
+      break;
+
+    if (scene.pattern >= patternCount ||
+        (scene.palette != SCENE_KEEP && scene.palette >= paletteCount) ||
+        (scene.param != SCENE_KEEP && scene.param >= ParamIdCount)) {
+      dropped++;
+      continue;
+    }
+    scenes[sceneCount++] = scene;
+  }
+
+  file.close();
+  Serial.printf("Scenes: %u in a %s playlist, %u dropped\n", sceneCount, playlistModeNames[playlistMode], dropped);
+}
+
+// Follow the audio for the drop and silence, see sceneAudioEvents().
+// Called every frame, whether or not autoplay is on, so the averages are
+// ready.
+void detectSceneAudio()
+{
+  uint32_t now = millis();
+
+  uint8_t loudest = 0;
+  for (uint8_t i = 0; i < 7; i++)
+    loudest = max(loudest, spectrumByte[i]);
+
+  if (loudest >= SCENE_SILENCE_LEVEL) {
+    sceneLoudMillis = now;
+    sceneSilent = false;
+  }
+  else if (!sceneSilent && now - sceneLoudMillis >= SCENE_SILENCE_MILLIS) {
+    sceneSilent = true;
+  }
+
+  // a drop: the bass well over its long average, after a time under it
+  int32_t bass = ((spectrumByte[0] + spectrumByte[1]) / 2) << 4;
+  sceneBassFast += (bass - sceneBassFast) / 4;
+  sceneBassSlow += (bass - sceneBassSlow) / 128;
+  if (sceneBassFast < sceneBassSlow) {
+    sceneDropArmed = true;
+  }
+  else if (sceneDropArmed && sceneBassFast > sceneBassSlow + (SCENE_DROP_RISE << 4)) {
+    sceneDropArmed = false;
+    sceneDropped = true;
+  }
+}
+
+// What the audio has done during the current scene, as SCENE_ADVANCE_
+// flags: a drop, or the music stopped (it was playing after the scene
+// started, and is silent now).  A scene that started in silence isn't
+// ended by it, so a silent stretch doesn't run through the playlist.
+uint8_t sceneAudioEvents()
+{
+  uint8_t events = 0;
+  if (sceneDropped)
+    events |= SCENE_ADVANCE_ON_DROP;
+  if (sceneSilent && (int32_t) (sceneLoudMillis - sceneStartMillis) >= 0)
+    events |= SCENE_ADVANCE_ON_SILENCE;
+  return events;
+}
+
+// The scene after the current one: the next in the list, or one picked by
+// weight, other than the current one if there is a choice.
+uint8_t nextScene()
+{
+  if (playlistMode == PlaylistWeighted) {
+    uint16_t total = 0;
+    for (uint8_t i = 0; i < sceneCount; i++) {
+      if (i != currentScene || sceneCount == 1)
+        total += scenes[i].weight;
+    }
+
+    if (total > 0) {
+      uint16_t pick = random16(total);
+      for (uint8_t i = 0; i < sceneCount; i++) {
+        if (i == currentScene && sceneCount > 1)
+          continue;
+        if (pick < scenes[i].weight)
+          return i;
+        pick -= scenes[i].weight;
+      }
+    }
+  }
+
+  return (currentScene + 1) % sceneCount;
+}
+
+void startScene(uint8_t index)
+{
+  const Scene& scene = scenes[index];
+  currentScene = index;
+  sceneStartMillis = millis();
+  sceneDropped = false;
+
+  setPattern(scene.pattern);
+
+  if (scene.palette != SCENE_KEEP) {
+    // not setPalette(): a scene's palette isn't saved as the setting
+    currentPaletteIndex = scene.palette;
+    scenePaletteSet = true;
+    broadcastField(PaletteField);
+  }
+
+  sceneBrightness = scene.brightness;
+
+  // the pattern's own params now, rather than next frame, so the scene's
+  // value goes on top of them
+  applyPatternParams();
+  if (scene.param != SCENE_KEEP) {
+    *paramInfo[scene.param].value = scene.paramValue;
+    for (uint8_t slot = 0; slot < paramSlotCount; slot++) {
+      if (paramSlots[slot] == scene.param)
+        broadcastField(Param0Field + slot);
+    }
+  }
+}
+
+// Test patterns that the built-in playlist leaves out.
+bool autoplaySkips(uint8_t index)
+{
+  return patterns[index].pattern == matrixTest || patterns[index].pattern == print_audio;
+}
+
+// Called once a loop(), before the pattern: moves autoplay on when the
+// scene is over.
+void handleScenes()
+{
+  detectSceneAudio();
+
+  if (!autoplay) {
+    scenePlaying = false;
+    if (sceneBrightness != 255) {
+      sceneBrightness = 255;
+      FastLED.setBrightness(brightness);
+    }
+    if (scenePaletteSet) {
+      // setPalette() writes the setting, which a scene's palette skips
+      scenePaletteSet = false;
+      uint8_t palette = readSetting(8);
+      currentPaletteIndex = palette < paletteCount ? palette : 0;
+      broadcastField(PaletteField);
+    }
+    return;
+  }
+
+  if (sceneCount == 0) {
+    if (millis() > autoPlayTimeout) {
+      do {
+        adjustPattern(true);
+      } while (autoplaySkips(currentPatternIndex));
+      autoPlayTimeout = millis() + (autoplayDuration * 1000);
+    }
+    return;
+  }
+
+  if (!scenePlaying) {
+    scenePlaying = true;
+    currentScene = sceneCount - 1;
+    startScene(nextScene());
+  }
+  else {
+    const Scene& scene = scenes[currentScene];
+    uint32_t elapsed = millis() - sceneStartMillis;
+    uint32_t duration = (scene.duration ? scene.duration : autoplayDuration) * 1000UL;
+    if (elapsed >= duration || (elapsed >= SCENE_MIN_MILLIS && (sceneAudioEvents() & scene.flags)))
+      startScene(nextScene());
+  }
+
+  // every frame, as setBrightness() sets FastLED's to the field's value
+  FastLED.setBrightness(scale8(brightness, sceneBrightness));
+}
+
+void handleSceneList()
+{
+  JsonWriter json(webServer);
+  json.begin("application/json");
+  json.print("{\"mode\":");
+  json.printString(playlistModeNames[playlistMode]);
+  json.print(",\"playing\":");
+  json.print(scenePlaying && autoplay ? "true" : "false");
+  json.print(",\"current\":");
+  json.print((unsigned int) currentScene);
+  json.print(",\"scenes\":[");
+
+  for (uint8_t i = 0; i < sceneCount; i++) {
+    const Scene& scene = scenes[i];
+    if (i > 0)
+      json.print(',');
+    json.print("{\"pattern\":");
+    json.print((unsigned int) scene.pattern);
+    json.print(",\"name\":");
+    json.printString(patterns[scene.pattern].name);
+    json.print(",\"palette\":");
+    json.print((unsigned int) scene.palette);
+    json.print(",\"brightness\":");
+    json.print((unsigned int) scene.brightness);
+    json.print(",\"duration\":");
+    json.print((unsigned int) scene.duration);
+    json.print(",\"weight\":");
+    json.print((unsigned int) scene.weight);
+    json.print(",\"flags\":");
+    json.print((unsigned int) scene.flags);
+    json.print(",\"param\":");
+    json.print((unsigned int) scene.param);
+    json.print(",\"paramValue\":");
+    json.print((unsigned int) scene.paramValue);
+    json.print('}');
+  }
+
+  json.print("]}");
+  json.end();
+}
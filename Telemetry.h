@@ -0,0 +1,157 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Audio telemetry for tuning the AGC and beat detection from a browser
+// (data/telemetry.htm) instead of print_audio and a serial cable.  Sent over
+// the WebSocket protocol (see Protocol.h):
+//
+//   client -> device
+//     0x08 TELEMETRY_SUBSCRIBE    decimation   one sample every decimation audio reads
+//     0x09 TELEMETRY_UNSUBSCRIBE
+//
+//   device -> client
+//     0x83 TELEMETRY  count  samples...
+//
+// Each sample is TELEMETRY_SAMPLE_SIZE bytes, 16 bit values little endian:
+//
+//   millis        low 16 bits of millis()
+//   value[7]      spectrumValue, after noise floor, correction and gain
+//   decay[7]      spectrumDecay
+//   peaks[7]      spectrumPeaks
+//   audioAvg
+//   gainAGC       fixed point, 256 = 1.0
+//   flags         8 bits, bit 0: a beat was detected since the last sample
+//
+// Samples are batched TELEMETRY_BATCH to a message.  With more than one
+// subscriber the smallest decimation asked for wins.  When nobody has
+// subscribed recordTelemetry() returns straight away.
+
+#define TELEMETRY_SUBSCRIBE   0x08
+#define TELEMETRY_UNSUBSCRIBE 0x09
+#define TELEMETRY             0x83
+
+#define TELEMETRY_CLIENTS 8
+#define TELEMETRY_BATCH 8
+#define TELEMETRY_HEADER_SIZE 2
+#define TELEMETRY_SAMPLE_SIZE 49
+
+uint8_t telemetrySubscribers = 0; // one bit per WebSocket client number
+uint8_t telemetryDecimation[TELEMETRY_CLIENTS];
+uint8_t telemetryInterval = 1;
+uint8_t telemetryCountdown = 0;
+uint8_t telemetryBeat = 0;
+uint32_t telemetryDropped = 0;
+
+uint8_t telemetryBuffer[TELEMETRY_HEADER_SIZE + TELEMETRY_BATCH * TELEMETRY_SAMPLE_SIZE];
+uint8_t telemetryCount = 0;
+
+uint8_t* writeTelemetry16(uint8_t* out, float value)
+{
+  uint16_t v = value <= 0 ? 0 : value >= 65535 ? 65535 : (uint16_t) (value + 0.5f);
+  *out++ = v & 0xFF;
+  *out++ = v >> 8;
+  return out;
+}
+
+void sendTelemetry()
+{
+  uint16_t length = TELEMETRY_HEADER_SIZE + telemetryCount * TELEMETRY_SAMPLE_SIZE;
+  telemetryBuffer[0] = TELEMETRY;
+  telemetryBuffer[1] = telemetryCount;
+
+  for (uint8_t num = 0; num < TELEMETRY_CLIENTS; num++) {
+    if (telemetrySubscribers & (1 << num)) {
+      if (!webSocketsServer.sendBIN(num, telemetryBuffer, length))
+        telemetryDropped++;
+    }
+  }
+
+  telemetryCount = 0;
+}
+
+// Called after every readAudio() and beat detection.
+void recordTelemetry()
+{
+  if (!telemetrySubscribers)
+    return;
+
+  telemetryBeat |= audioBeat;
+
+  if (telemetryCountdown > 1) {
+    telemetryCountdown--;
+    return;
+  }
+  telemetryCountdown = telemetryInterval;
+
+  uint8_t* out = telemetryBuffer + TELEMETRY_HEADER_SIZE + telemetryCount * TELEMETRY_SAMPLE_SIZE;
+
+  out = writeTelemetry16(out, millis() & 0xFFFF);
+  for (uint8_t i = 0; i < 7; i++)
+    out = writeTelemetry16(out, spectrumValue[i]);
+  for (uint8_t i = 0; i < 7; i++)
+    out = writeTelemetry16(out, spectrumDecay[i]);
+  for (uint8_t i = 0; i < 7; i++)
+    out = writeTelemetry16(out, spectrumPeaks[i]);
+  out = writeTelemetry16(out, audioAvg);
+  out = writeTelemetry16(out, gainAGC * 256);
+  *out = telemetryBeat;
+
+  telemetryBeat = 0;
+
+  if (++telemetryCount == TELEMETRY_BATCH)
+    sendTelemetry();
+}
+
+void updateTelemetryInterval()
+{
+  uint8_t interval = 255;
+  for (uint8_t num = 0; num < TELEMETRY_CLIENTS; num++) {
+    if (telemetrySubscribers & (1 << num))
+      interval = min(interval, telemetryDecimation[num]);
+  }
+  telemetryInterval = interval;
+  telemetryCountdown = min(telemetryCountdown, telemetryInterval);
+}
+
+void unsubscribeTelemetry(uint8_t num)
+{
+  telemetrySubscribers &= ~(1 << num);
+  updateTelemetryInterval();
+
+  if (!telemetrySubscribers) {
+    telemetryCount = 0;
+    telemetryBeat = 0;
+  }
+}
+
+void handleTelemetryMessage(uint8_t num, const uint8_t* payload, size_t length)
+{
+  if (num >= TELEMETRY_CLIENTS)
+    return;
+
+  switch (payload[0]) {
+    case TELEMETRY_SUBSCRIBE:
+      telemetryDecimation[num] = max(length > 1 ? payload[1] : 4, 1);
+      telemetrySubscribers |= 1 << num;
+      updateTelemetryInterval();
+      break;
+
+    case TELEMETRY_UNSUBSCRIBE:
+      unsubscribeTelemetry(num);
+      break;
+  }
+}
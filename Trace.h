@@ -0,0 +1,188 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// A trace of what each frame spent its time on, for finding the
+// occasional slow frame that /metrics only shows as a count.
+//
+//   TRACE_SCOPE("name");      begin now, end when the scope does
+//   TRACE_BEGIN("name");      begin
+//   TRACE_END();              end the innermost one begun
+//
+// Events are a cycle count (ESP.getCycleCount(), which the host build
+// takes from std::chrono) and the name, written to a ring of TRACE_EVENTS
+// in RAM.  The names must be strings that stay put: literals, or pattern
+// names.  beginFrame() ends one "frame" event and begins the next.
+//
+// When a frame takes longer than traceTriggerMicros the ring is frozen, so
+// the frame stays in it until someone looks.
+//
+//   GET /trace                 the ring as Chrome trace event JSON, for
+//                              chrome://tracing or ui.perfetto.dev
+//   GET /trace?reset=1         empty it and start recording again
+//   GET /trace?trigger=40000   the same, but freeze after a frame longer
+//                              than 40 ms, 0 never
+//
+// With TRACE_ENABLED 0, the default, the macros are empty and nothing is
+// recorded.
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+#define TRACE_EVENTS 256 // a power of two
+#define TRACE_MASK (TRACE_EVENTS - 1)
+#define TRACE_TRIGGER_MICROS 30000
+
+#define TRACE_PHASE_BEGIN 'B'
+#define TRACE_PHASE_END 'E'
+
+#if TRACE_ENABLED
+
+struct TraceEvent {
+  uint32_t cycles;
+  const char* name;
+  char phase;
+};
+
+TraceEvent traceEvents[TRACE_EVENTS];
+uint16_t traceHead = 0;
+bool traceWrapped = false;
+bool traceFrozen = false;
+uint32_t traceTriggerMicros = TRACE_TRIGGER_MICROS;
+
+inline void traceEvent(const char* name, char phase)
+{
+  if (traceFrozen)
+    return;
+
+  TraceEvent& event = traceEvents[traceHead];
+  event.cycles = ESP.getCycleCount();
+  event.name = name;
+  event.phase = phase;
+
+  traceHead = (traceHead + 1) & TRACE_MASK;
+  if (traceHead == 0)
+    traceWrapped = true;
+}
+
+struct TraceScope {
+  TraceScope(const char* name) { traceEvent(name, TRACE_PHASE_BEGIN); }
+  ~TraceScope() { traceEvent(NULL, TRACE_PHASE_END); }
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_BEGIN(name) traceEvent(name, TRACE_PHASE_BEGIN)
+#define TRACE_END() traceEvent(NULL, TRACE_PHASE_END)
+
+// Called by beginFrame() with how long the last frame took.
+void traceFrame(uint32_t elapsedMicros)
+{
+  if (traceFrozen)
+    return;
+
+  traceEvent(NULL, TRACE_PHASE_END);
+  if (traceTriggerMicros && elapsedMicros > traceTriggerMicros) {
+    traceFrozen = true;
+    Serial.printf("Trace: frozen after a %u us frame\n", elapsedMicros);
+    return;
+  }
+  traceEvent("frame", TRACE_PHASE_BEGIN);
+}
+
+void handleTrace()
+{
+  if (webServer.hasArg("trigger"))
+    traceTriggerMicros = webServer.arg("trigger").toInt();
+
+  if (webServer.hasArg("reset") || webServer.hasArg("trigger")) {
+    traceHead = 0;
+    traceWrapped = false;
+    traceFrozen = false;
+    webServer.send(200, "text/plain", "OK");
+    return;
+  }
+
+  // nothing new while it is written out
+  bool frozen = traceFrozen;
+  traceFrozen = true;
+
+  uint16_t first = traceWrapped ? traceHead : 0;
+  uint16_t count = traceWrapped ? TRACE_EVENTS : traceHead;
+  uint32_t cyclesPerMicro = ESP.getCpuFreqMHz();
+
+  JsonWriter json(webServer);
+  json.begin("application/json");
+  json.print("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+  // cycle counts wrap every 2^32 cycles, under a minute, so time is added
+  // up from one event to the next
+  uint64_t cycles = 0;
+  uint32_t last = traceEvents[first].cycles;
+  uint8_t depth = 0;
+  bool comma = false;
+
+  for (uint16_t i = 0; i < count; i++) {
+    const TraceEvent& event = traceEvents[(first + i) & TRACE_MASK];
+    cycles += event.cycles - last;
+    last = event.cycles;
+
+    // the begin of an end may have been overwritten
+    if (event.phase == TRACE_PHASE_END) {
+      if (depth == 0)
+        continue;
+      depth--;
+    }
+    else {
+      depth++;
+    }
+
+    // microseconds, to the ns
+    uint64_t nanos = cycles * 1000 / cyclesPerMicro;
+    char line[96];
+    snprintf(line, sizeof(line), "%s{\"ph\":\"%c\",\"ts\":%u.%03u,\"pid\":1,\"tid\":1", comma ? "," : "", event.phase,
+             (uint32_t) (nanos / 1000), (uint32_t) (nanos % 1000));
+    json.print(line);
+    if (event.name) {
+      json.print(",\"name\":");
+      json.printString(event.name);
+    }
+    json.print('}');
+    comma = true;
+  }
+
+  json.print("]}");
+  json.end();
+
+  traceFrozen = frozen;
+}
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_BEGIN(name)
+#define TRACE_END()
+
+inline void traceFrame(uint32_t elapsedMicros) {}
+
+void handleTrace()
+{
+  webServer.send(404, "text/plain", "Tracing is off, build with TRACE_ENABLED 1");
+}
+
+#endif
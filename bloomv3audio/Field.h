@@ -18,6 +18,7 @@
 
 typedef String (*FieldSetter)(String);
 typedef String (*FieldGetter)();
+typedef void (*FieldOptionsWriter)(JsonWriter& json);
 
 const String NumberFieldType = "Number";
 const String BooleanFieldType = "Boolean";
@@ -32,7 +33,7 @@ typedef struct Field {
   uint8_t min;
   uint8_t max;
   FieldGetter getValue;
-  FieldGetter getOptions;
+  FieldOptionsWriter writeOptions;
   FieldSetter setValue;
 };
 
@@ -64,43 +65,51 @@ String setFieldValue(String name, String value, FieldList fields, uint8_t count)
   return String();
 }
 
-String getFieldsJson(FieldList fields, uint8_t count) {
-  String json = "[";
+// Stream the /all array through json, see JsonWriter.h.
+void writeFieldsJson(JsonWriter& json, FieldList fields, uint8_t count) {
+  json.print('[');
 
   for (uint8_t i = 0; i < count; i++) {
-    Field field = fields[i];
+    const Field& field = fields[i];
 
-    json += "{\"name\":\"" + field.name + "\",\"label\":\"" + field.label + "\",\"type\":\"" + field.type + "\"";
+    json.print("{\"name\":");
+    json.printString(field.name);
+    json.print(",\"label\":");
+    json.printString(field.label);
+    json.print(",\"type\":");
+    json.printString(field.type);
 
-    if(field.getValue) {
+    if (field.getValue) {
       if (field.type == ColorFieldType || field.type == "String") {
-        json += ",\"value\":\"" + field.getValue() + "\"";
+        json.print(",\"value\":");
+        json.printString(field.getValue());
       }
       else {
-        json += ",\"value\":" + field.getValue();
+        json.print(",\"value\":");
+        json.print(field.getValue());
       }
     }
 
     if (field.type == NumberFieldType) {
-      json += ",\"min\":" + String(field.min);
-      json += ",\"max\":" + String(field.max);
+      json.print(",\"min\":");
+      json.print((unsigned int) field.min);
+      json.print(",\"max\":");
+      json.print((unsigned int) field.max);
     }
 
-    if (field.getOptions) {
-      json += ",\"options\":[";
-      json += field.getOptions();
-      json += "]";
+    if (field.writeOptions) {
+      json.print(",\"options\":[");
+      field.writeOptions(json);
+      json.print(']');
     }
 
-    json += "}";
+    json.print('}');
 
     if (i < count - 1)
-      json += ",";
+      json.print(',');
   }
 
-  json += "]";
-
-  return json;
+  json.print(']');
 }
 
 /*
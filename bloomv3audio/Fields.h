@@ -45,16 +45,12 @@ String getPattern() {
   return String(currentPatternIndex);
 }
 
-String getPatterns() {
-  String json = "";
-
+void writePatterns(JsonWriter& json) {
   for (uint8_t i = 0; i < patternCount; i++) {
-    json += "\"" + patterns[i].name + "\"";
+    json.printString(patterns[i].name);
     if (i < patternCount - 1)
-      json += ",";
+      json.print(',');
   }
-
-  return json;
 }
 
 String getAutoplay() {
@@ -92,11 +88,11 @@ String getTwinkleDensity() {
 FieldList fields = {
   { "power", "Power", BooleanFieldType, 0, 1, getPower },
   { "brightness", "Brightness", NumberFieldType, 1, 255, getBrightness },
-  { "pattern", "Pattern", SelectFieldType, 0, patternCount, getPattern, getPatterns },
+  { "pattern", "Pattern", SelectFieldType, 0, patternCount, getPattern, writePatterns },
   { "speed", "Speed", NumberFieldType, 1, 255, getSpeed },
   { "autoplay", "Autoplay", SectionFieldType },
   { "autoplay", "Autoplay", BooleanFieldType, 0, 1, getAutoplay },
-  { "autoplayDuration", "Autoplay Duration", NumberFieldType, 0, 255, getAutoplayDuration },
+  { "autoplayDuration", "Autoplay Duration", NumberFieldType, 1, 255, getAutoplayDuration },
   { "solidColor", "Solid Color", SectionFieldType },
   { "solidColor", "Color", ColorFieldType, 0, 255, getSolidColor },
   { "fire", "Fire & Water", SectionFieldType },
@@ -0,0 +1,118 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Writes a JSON response straight into the HTTP reply, one small chunk at a
+// time, instead of building the whole document in a String first.  With the
+// pattern list that String used to be a few KB, grown one append at a time on
+// an already fragmented heap.
+//
+//   JsonWriter json(webServer);
+//   json.begin("text/json");
+//   json.print("[");
+//   json.printString(name);
+//   json.print("]");
+//   json.end();
+//
+// Strings are written as they are, without escaping, like the code it
+// replaces.
+
+#define JSON_WRITER_BUFFER_SIZE 256
+
+class JsonWriter {
+  public:
+    JsonWriter(ESP8266WebServer& server) : server(server) {}
+
+    void begin(const char* contentType)
+    {
+      used = 0;
+      length = 0;
+      minFreeHeap = ESP.getFreeHeap();
+
+      server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+      server.send(200, contentType, "");
+    }
+
+    void print(const char* text)
+    {
+      while (*text) {
+        if (used == JSON_WRITER_BUFFER_SIZE)
+          flush();
+        buffer[used++] = *text++;
+      }
+    }
+
+    void print(const String& text)
+    {
+      print(text.c_str());
+    }
+
+    void print(char c)
+    {
+      if (used == JSON_WRITER_BUFFER_SIZE)
+        flush();
+      buffer[used++] = c;
+    }
+
+    void print(unsigned int value)
+    {
+      char text[11];
+      snprintf(text, sizeof(text), "%u", value);
+      print(text);
+    }
+
+    // "text"
+    void printString(const char* text)
+    {
+      print('"');
+      print(text);
+      print('"');
+    }
+
+    void printString(const String& text)
+    {
+      printString(text.c_str());
+    }
+
+    // finish the response, with the empty chunk that ends it
+    void end()
+    {
+      flush();
+      server.sendContent("");
+    }
+
+    size_t length = 0;
+    uint32_t minFreeHeap = 0;
+
+  private:
+    void flush()
+    {
+      if (used == 0)
+        return;
+
+      minFreeHeap = min(minFreeHeap, ESP.getFreeHeap());
+
+      // sendContent_P copies with memcpy_P, which reads RAM as well as flash,
+      // and saves sendContent(String) making a heap copy of every chunk
+      server.sendContent_P(buffer, used);
+      length += used;
+      used = 0;
+    }
+
+    ESP8266WebServer& server;
+    char buffer[JSON_WRITER_BUFFER_SIZE];
+    size_t used = 0;
+};
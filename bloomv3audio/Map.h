@@ -1,8 +1,37 @@
-uint8_t levels[NUM_LEDS] = { 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4 };
+const uint8_t levels[] = { 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4 };
 
-uint8_t zCoords[NUM_LEDS] = { 0, 0, 0, 0, 0, 64, 64, 64, 64, 64, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 192, 192, 192, 192, 192, 255, 255, 255, 255, 255 };
+const uint8_t zCoords[] = { 0, 0, 0, 0, 0, 64, 64, 64, 64, 64, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 192, 192, 192, 192, 192, 255, 255, 255, 255, 255 };
 
-uint8_t angles[NUM_LEDS] = { 0, 51, 102, 154, 205, 26, 77, 128, 179, 230, 13, 38, 64, 90, 115, 141, 166, 192, 218, 243, 0, 51, 102, 154, 205, 26, 77, 128, 179, 230 };
+const uint8_t angles[] = { 0, 51, 102, 154, 205, 26, 77, 128, 179, 230, 13, 38, 64, 90, 115, 141, 166, 192, 218, 243, 0, 51, 102, 154, 205, 26, 77, 128, 179, 230 };
+
+const uint8_t mapLedCount = ARRAY_SIZE(angles);
+
+// The bloom is an icosidodecahedron stood on a pentagon: five rings of LEDs,
+// the middle one widest.  Ring radius relative to the middle ring:
+const uint8_t levelRadius[] = { 134, 217, 255, 217, 134 };
+
+// Built-in layout for when there is no /layout.bin on SPIFFS.
+void layoutFromMap()
+{
+  layoutWidth = 0;
+  layoutHeight = 0;
+  layoutCount = min((int) mapLedCount, LAYOUT_MAX_LEDS);
+
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    float angle = angles[i] * PI / 128.0f;
+    layoutX[i] = 128 + cosf(angle) * levelRadius[levels[i]] / 2;
+    layoutY[i] = 128 + sinf(angle) * levelRadius[levels[i]] / 2;
+    layoutZ[i] = zCoords[i];
+    layoutGroup[i] = levels[i];
+  }
+
+  layoutComputePolar();
+
+  // keep the exact angles rather than the ones rounded through x and y
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    layoutAngle[i] = angles[i];
+  }
+}
 
 const uint8_t starCount = 12;
 const uint8_t starLength = 5;
@@ -85,42 +114,48 @@ void paletteTris() {
 }
 
 void fallingRainbow() {
-  for (uint8_t i = 0; i < NUM_LEDS; i++) {
-    leds[i] = CHSV(zCoords[i] / 6 - beat8(speed), 255, 255);
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    leds[i] = CHSV(layoutZ[i] / 6 - beat8(speed), 255, 255);
   }
+  layoutClearRest(leds, NUM_LEDS);
 }
 
 void risingRainbow() {
-  for (uint8_t i = 0; i < NUM_LEDS; i++) {
-    leds[i] = CHSV(zCoords[i] / 6 + beat8(speed), 255, 255);
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    leds[i] = CHSV(layoutZ[i] / 6 + beat8(speed), 255, 255);
   }
+  layoutClearRest(leds, NUM_LEDS);
 }
 
 void rotatingRainbow()
 {
-  for (uint8_t i = 0; i < NUM_LEDS; i++)
+  for (uint16_t i = 0; i < layoutCount; i++)
   {
-    leds[i] = CHSV(angles[i] + beat8(speed), 255, 255);
+    leds[i] = CHSV(layoutAngle[i] + beat8(speed), 255, 255);
   }
+  layoutClearRest(leds, NUM_LEDS);
 }
 
 
 void fallingPalette() {
-  for (uint8_t i = 0; i < NUM_LEDS; i++) {
-    leds[i] = ColorFromPalette(gCurrentPalette, zCoords[i] / 8 - beat8(speed));
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    leds[i] = ColorFromPalette(gCurrentPalette, layoutZ[i] / 8 - beat8(speed));
   }
+  layoutClearRest(leds, NUM_LEDS);
 }
 
 void risingPalette() {
-  for (uint8_t i = 0; i < NUM_LEDS; i++) {
-    leds[i] = ColorFromPalette(gCurrentPalette, zCoords[i] / 8 + beat8(speed));
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    leds[i] = ColorFromPalette(gCurrentPalette, layoutZ[i] / 8 + beat8(speed));
   }
+  layoutClearRest(leds, NUM_LEDS);
 }
 
 void rotatingPalette()
 {
-  for (uint8_t i = 0; i < NUM_LEDS; i++)
+  for (uint16_t i = 0; i < layoutCount; i++)
   {
-    leds[i] = ColorFromPalette(gCurrentPalette, angles[i] + beat8(speed));
+    leds[i] = ColorFromPalette(gCurrentPalette, layoutAngle[i] + beat8(speed));
   }
+  layoutClearRest(leds, NUM_LEDS);
 }
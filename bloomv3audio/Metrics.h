@@ -0,0 +1,280 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Runtime metrics, in the Prometheus text format, from GET /metrics or
+// over the WebSocket protocol (see Protocol.h):
+//
+//   client -> device
+//     0x0A METRICS        ask for the metrics
+//
+//   device -> client
+//     a text frame with the same text /metrics returns
+//
+// loop() is split into phases, and endPhase() adds the time since the
+// last one ended to that phase's total:
+//
+//   beginFrame()
+//   audio      readAudio(), beat detection, audio sync, telemetry
+//   network    see Network.h, clock sync, settings, commands, broadcasts
+//   pattern    the pattern function and palette changes
+//   show       FastLED.show()
+//   network    the live preview
+//
+// beginFrame() also puts the time since the last frame in the frame time
+// histogram and in the previous pattern's totals.  Everything is a fixed
+// size counter, so updating them is a few adds per frame; the text is only
+// made when someone asks for it.
+//
+// In a sketch with Fire.h, audioFire2D's cycle counts are there too, and
+// in one with AudioSync.h, the audio sync counters.
+
+#define METRICS           0x0A
+
+#define METRICS_BUCKETS 9
+// one frame at FRAMES_PER_SECOND; a frame that takes longer drops some
+#define METRICS_FRAME_MICROS (1000000UL / FRAMES_PER_SECOND)
+#define METRICS_LINE_SIZE 128
+
+enum MetricsPhase {
+  PhaseAudio,
+  PhaseNetwork,
+  PhasePattern,
+  PhaseShow,
+  PhaseCount,
+};
+
+const char* const metricsPhaseNames[PhaseCount] = { "audio", "network", "pattern", "show" };
+
+// upper bounds in us, and as the le label
+const uint32_t metricsBucketMicros[METRICS_BUCKETS] = { 1000, 2000, 4000, 8000, 16000, 33000, 66000, 133000, 0xFFFFFFFF };
+const char* const metricsBucketNames[METRICS_BUCKETS] = { "0.001", "0.002", "0.004", "0.008", "0.016", "0.033", "0.066", "0.133", "+Inf" };
+
+uint32_t frameBuckets[METRICS_BUCKETS];
+uint32_t frameCount = 0;
+uint64_t frameMicrosTotal = 0;
+uint32_t framesDropped = 0;
+
+uint64_t phaseMicros[PhaseCount];
+uint32_t phaseStartMicros = 0;
+
+uint32_t patternFrames[patternCount];
+uint64_t patternMicros[patternCount];
+uint8_t framePattern = 0; // the pattern the last frame drew
+
+uint32_t freeHeapLow = 0xFFFFFFFF;
+
+uint32_t frameStartMicros = 0;
+
+// Called at the start of every loop().
+void beginFrame()
+{
+  uint32_t now = micros();
+
+  if (frameStartMicros) {
+    uint32_t elapsed = now - frameStartMicros;
+
+    uint8_t bucket = 0;
+    while (elapsed > metricsBucketMicros[bucket])
+      bucket++;
+    frameBuckets[bucket]++;
+    frameCount++;
+    frameMicrosTotal += elapsed;
+    framesDropped += (elapsed - 1) / METRICS_FRAME_MICROS;
+
+    patternFrames[framePattern]++;
+    patternMicros[framePattern] += elapsed;
+
+    traceFrame(elapsed);
+  }
+
+  frameStartMicros = now;
+  phaseStartMicros = now;
+  framePattern = currentPatternIndex;
+
+  uint32_t freeHeap = ESP.getFreeHeap();
+  if (freeHeap < freeHeapLow)
+    freeHeapLow = freeHeap;
+}
+
+void endPhase(MetricsPhase phase)
+{
+  uint32_t now = micros();
+  phaseMicros[phase] += now - phaseStartMicros;
+  phaseStartMicros = now;
+}
+
+// Output is anything with print(const char*).
+template <typename Output>
+void printMetric(Output& out, const char* format, ...)
+{
+  char line[METRICS_LINE_SIZE];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  out.print(line);
+}
+
+// "12.345678"
+template <typename Output>
+void printMetricSeconds(Output& out, const char* name, const char* labels, uint64_t micros)
+{
+  printMetric(out, "%s%s %u.%06u\n", name, labels, (uint32_t) (micros / 1000000), (uint32_t) (micros % 1000000));
+}
+
+template <typename Output>
+void writeMetrics(Output& out)
+{
+  char labels[64];
+
+  out.print("# HELP fastled_frame_seconds Time from the start of one frame to the next.\n"
+            "# TYPE fastled_frame_seconds histogram\n");
+  uint32_t count = 0;
+  for (uint8_t i = 0; i < METRICS_BUCKETS; i++) {
+    count += frameBuckets[i];
+    printMetric(out, "fastled_frame_seconds_bucket{le=\"%s\"} %u\n", metricsBucketNames[i], count);
+  }
+  printMetricSeconds(out, "fastled_frame_seconds_sum", "", frameMicrosTotal);
+  printMetric(out, "fastled_frame_seconds_count %u\n", frameCount);
+
+  printMetric(out, "# HELP fastled_frames_dropped_total Frames not drawn at %u fps because one took too long.\n", FRAMES_PER_SECOND);
+  out.print("# TYPE fastled_frames_dropped_total counter\n");
+  printMetric(out, "fastled_frames_dropped_total %u\n", framesDropped);
+
+  out.print("# HELP fastled_phase_seconds_total Time spent in each phase of loop().\n"
+            "# TYPE fastled_phase_seconds_total counter\n");
+  for (uint8_t i = 0; i < PhaseCount; i++) {
+    snprintf(labels, sizeof(labels), "{phase=\"%s\"}", metricsPhaseNames[i]);
+    printMetricSeconds(out, "fastled_phase_seconds_total", labels, phaseMicros[i]);
+  }
+
+  out.print("# HELP fastled_pattern_frames_total Frames drawn by each pattern.\n"
+            "# TYPE fastled_pattern_frames_total counter\n");
+  for (uint8_t i = 0; i < patternCount; i++) {
+    if (patternFrames[i])
+      printMetric(out, "fastled_pattern_frames_total{index=\"%u\",pattern=\"%s\"} %u\n", i, patterns[i].name.c_str(), patternFrames[i]);
+  }
+
+  out.print("# HELP fastled_pattern_seconds_total Frame time while each pattern was drawing.\n"
+            "# TYPE fastled_pattern_seconds_total counter\n");
+  for (uint8_t i = 0; i < patternCount; i++) {
+    if (patternFrames[i]) {
+      snprintf(labels, sizeof(labels), "{index=\"%u\",pattern=\"%s\"}", i, patterns[i].name.c_str());
+      printMetricSeconds(out, "fastled_pattern_seconds_total", labels, patternMicros[i]);
+    }
+  }
+
+  out.print("# HELP fastled_pattern_info The current pattern.\n"
+            "# TYPE fastled_pattern_info gauge\n");
+  printMetric(out, "fastled_pattern_info{index=\"%u\",pattern=\"%s\"} 1\n", currentPatternIndex, patterns[currentPatternIndex].name.c_str());
+
+  out.print("# HELP fastled_network_max_seconds Longest a frame's transfers have taken, see Network.h.\n"
+            "# TYPE fastled_network_max_seconds gauge\n");
+  printMetricSeconds(out, "fastled_network_max_seconds", "", networkMicrosWorst);
+  out.print("# HELP fastled_network_transfers_total File and list transfers started.\n"
+            "# TYPE fastled_network_transfers_total counter\n");
+  printMetric(out, "fastled_network_transfers_total %u\n", transfersStarted);
+  out.print("# HELP fastled_network_transfers_aborted_total Transfers cut off by the client going away.\n"
+            "# TYPE fastled_network_transfers_aborted_total counter\n");
+  printMetric(out, "fastled_network_transfers_aborted_total %u\n", transfersAborted);
+
+#ifdef FIRE2D_CYCLE_BUDGET
+  out.print("# HELP fastled_fire2d_cycles CPU cycles audioFire2D's last frame took.\n"
+            "# TYPE fastled_fire2d_cycles gauge\n");
+  printMetric(out, "fastled_fire2d_cycles %u\n", fire2DCycles);
+  out.print("# HELP fastled_fire2d_max_cycles Most CPU cycles an audioFire2D frame has taken.\n"
+            "# TYPE fastled_fire2d_max_cycles gauge\n");
+  printMetric(out, "fastled_fire2d_max_cycles %u\n", fire2DMaxCycles);
+  printMetric(out, "# HELP fastled_fire2d_frames_over_budget_total audioFire2D frames over %u cycles.\n", (uint32_t) FIRE2D_CYCLE_BUDGET);
+  out.print("# TYPE fastled_fire2d_frames_over_budget_total counter\n");
+  printMetric(out, "fastled_fire2d_frames_over_budget_total %u\n", fire2DOverBudget);
+#endif
+
+#ifdef AUDIO_SYNC_PORT
+  out.print("# HELP fastled_audio_sync_mode_info Whether this node shares its audio or plays another's.\n"
+            "# TYPE fastled_audio_sync_mode_info gauge\n");
+  printMetric(out, "fastled_audio_sync_mode_info{mode=\"%s\"} 1\n", audioSyncModeNames[audioSyncMode]);
+  out.print("# HELP fastled_audio_sync_packets_total Audio sync packets, by what became of them.\n"
+            "# TYPE fastled_audio_sync_packets_total counter\n");
+  printMetric(out, "fastled_audio_sync_packets_total{result=\"sent\"} %u\n", audioSyncSent);
+  printMetric(out, "fastled_audio_sync_packets_total{result=\"received\"} %u\n", audioSyncReceived);
+  printMetric(out, "fastled_audio_sync_packets_total{result=\"late\"} %u\n", audioSyncLate);
+  printMetric(out, "fastled_audio_sync_packets_total{result=\"lost\"} %u\n", audioSyncLost);
+  out.print("# HELP fastled_audio_sync_concealed_total Frames a slave faded out for want of a packet.\n"
+            "# TYPE fastled_audio_sync_concealed_total counter\n");
+  printMetric(out, "fastled_audio_sync_concealed_total %u\n", audioSyncConcealed);
+  out.print("# HELP fastled_audio_sync_transit_milliseconds A slave's clock less the master's, at the quickest packet.\n"
+            "# TYPE fastled_audio_sync_transit_milliseconds gauge\n");
+  printMetric(out, "fastled_audio_sync_transit_milliseconds %d\n", audioSyncTransit);
+#endif
+
+  out.print("# HELP fastled_heap_free_bytes Free heap.\n"
+            "# TYPE fastled_heap_free_bytes gauge\n");
+  printMetric(out, "fastled_heap_free_bytes %u\n", ESP.getFreeHeap());
+  out.print("# HELP fastled_heap_free_low_bytes Lowest free heap seen at the start of a frame.\n"
+            "# TYPE fastled_heap_free_low_bytes gauge\n");
+  printMetric(out, "fastled_heap_free_low_bytes %u\n", freeHeapLow);
+  out.print("# HELP fastled_heap_max_block_bytes Largest block that can be allocated.\n"
+            "# TYPE fastled_heap_max_block_bytes gauge\n");
+  printMetric(out, "fastled_heap_max_block_bytes %u\n", ESP.getMaxFreeBlockSize());
+  out.print("# HELP fastled_heap_fragmentation_percent Heap fragmentation.\n"
+            "# TYPE fastled_heap_fragmentation_percent gauge\n");
+  printMetric(out, "fastled_heap_fragmentation_percent %u\n", ESP.getHeapFragmentation());
+
+  if (!apMode) {
+    out.print("# HELP fastled_wifi_rssi_dbm Signal strength of the access point we are connected to.\n"
+              "# TYPE fastled_wifi_rssi_dbm gauge\n");
+    printMetric(out, "fastled_wifi_rssi_dbm %d\n", WiFi.RSSI());
+  }
+
+  out.print("# HELP fastled_uptime_seconds Time since boot.\n"
+            "# TYPE fastled_uptime_seconds counter\n");
+  printMetric(out, "fastled_uptime_seconds %u\n", millis() / 1000);
+}
+
+// What writeMetrics() needs, for counting the text's length and then
+// making it, for a WebSocket frame.
+struct MetricsLength {
+  size_t length = 0;
+  void print(const char* text) { length += strlen(text); }
+};
+
+struct MetricsString {
+  String& text;
+  void print(const char* text) { this->text += text; }
+};
+
+void handleMetricsMessage(uint8_t num, const uint8_t* payload, size_t length)
+{
+  MetricsLength counter;
+  writeMetrics(counter);
+
+  String text;
+  text.reserve(counter.length + METRICS_LINE_SIZE); // the values may have grown since
+  MetricsString out = { text };
+  writeMetrics(out);
+
+  webSocketsServer.sendTXT(num, text);
+}
+
+void handleMetrics()
+{
+  JsonWriter out(webServer);
+  out.begin("text/plain; version=0.0.4");
+  writeMetrics(out);
+  out.end();
+}
@@ -0,0 +1,204 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The network phase of loop(), with a time budget per frame.
+//
+// webServer.handleClient() used to send a whole static file before it
+// returned: with bootstrap.min.css or jQuery that held up the next frame by
+// tens of ms, and a browser loading the UI asks for several of them.  Now
+// static files and /list only get their headers sent by the handler; the
+// body is a transfer that handleNetwork() carries on with, a TCP window at
+// a time, for as long as the frame's budget lasts, and picks up again next
+// frame.
+//
+// Each frame:
+//
+//   webSocketsServer.loop()     always, control messages are small
+//   webServer.handleClient()    if there is budget and a free transfer slot
+//   transfers                   until the budget is used up
+//
+// Only as much is written as the TCP send window has room for, so a write
+// never waits for an ACK.  While both slots are busy new requests wait in
+// the listen backlog.
+//
+// handleNetwork() also keeps the worst network phase time, which
+// beginFrame() prints with the worst frame time (see Metrics.h), to see
+// what a browser loading the UI costs.
+
+#define NETWORK_BUDGET_MICROS 3000
+#define TRANSFER_SLOTS 2
+// the longest /list entry: {"type":"file","name":"<31 characters>"}
+#define TRANSFER_LIST_ENTRY_SIZE 64
+
+uint32_t networkBudgetMicros = NETWORK_BUDGET_MICROS;
+
+enum TransferType {
+  TransferNone,
+  TransferFile,
+  TransferList,
+};
+
+struct Transfer {
+  TransferType type;
+  WiFiClient client;
+  File file;
+  uint32_t remaining; // bytes of file still to send
+  Dir dir;
+  bool first;
+};
+
+Transfer transfers[TRANSFER_SLOTS];
+
+// for /metrics, see Metrics.h
+uint32_t transfersStarted = 0;
+uint32_t transfersAborted = 0;
+uint32_t networkMicrosWorst = 0; // the longest a frame's transfers took
+
+Transfer* findFreeTransfer()
+{
+  for (uint8_t i = 0; i < TRANSFER_SLOTS; i++) {
+    if (transfers[i].type == TransferNone)
+      return &transfers[i];
+  }
+  return NULL;
+}
+
+void endTransfer(Transfer& transfer)
+{
+  if (transfer.type == TransferFile)
+    transfer.file.close();
+  transfer.dir = Dir();
+  transfer.client.stop();
+  transfer.client = WiFiClient();
+  transfer.type = TransferNone;
+}
+
+// Send the headers for the next size bytes of file and leave the body to
+// handleNetwork().  Called from a webServer handler.  Returns false if
+// there is no free slot.
+bool startFileTransfer(File& file, uint32_t size, const String& contentType, bool gzip, const char* cacheControl)
+{
+  Transfer* transfer = findFreeTransfer();
+  if (!transfer)
+    return false;
+
+  webServer.setContentLength(size);
+  if (gzip && contentType != "application/x-gzip" && contentType != "application/octet-stream")
+    webServer.sendHeader("Content-Encoding", "gzip");
+  if (cacheControl)
+    webServer.sendHeader("Cache-Control", cacheControl);
+  webServer.send(200, contentType, "");
+
+  transfer->type = TransferFile;
+  transfer->client = webServer.client();
+  transfer->file = file;
+  transfer->remaining = size;
+  transfersStarted++;
+  return true;
+}
+
+// The same for a JSON list of the files in dir.  Its length isn't known
+// until the end, so the reply ends when the connection is closed.
+bool startListTransfer(Dir& dir)
+{
+  Transfer* transfer = findFreeTransfer();
+  if (!transfer)
+    return false;
+
+  WiFiClient client = webServer.client();
+  client.print("HTTP/1.1 200 OK\r\nContent-Type: text/json\r\nConnection: close\r\n\r\n[");
+
+  transfer->type = TransferList;
+  transfer->client = client;
+  transfer->dir = dir;
+  transfer->first = true;
+  transfersStarted++;
+  return true;
+}
+
+// Send the next piece of transfer, as much as the send window takes.
+// Returns false if it couldn't send anything.
+bool continueTransfer(Transfer& transfer)
+{
+  if (!transfer.client.connected()) {
+    transfersAborted++;
+    endTransfer(transfer);
+    return false;
+  }
+
+  size_t space = transfer.client.availableForWrite();
+
+  if (transfer.type == TransferFile) {
+    uint8_t buffer[HTTP_DOWNLOAD_UNIT_SIZE];
+    size_t length = transfer.file.read(buffer, min(min(space, sizeof(buffer)), (size_t) transfer.remaining));
+    if (length > 0)
+      transfer.client.write(buffer, length);
+    transfer.remaining -= length;
+    if (transfer.remaining == 0 || !transfer.file.available())
+      endTransfer(transfer);
+    return length > 0;
+  }
+
+  // TransferList, one entry at a time
+  if (space < TRANSFER_LIST_ENTRY_SIZE + 1)
+    return false;
+
+  if (!transfer.dir.next()) {
+    transfer.client.write((const uint8_t*) "]", 1);
+    endTransfer(transfer);
+    return true;
+  }
+
+  char entry[TRANSFER_LIST_ENTRY_SIZE + 1];
+  int length = snprintf(entry, sizeof(entry), "%s{\"type\":\"file\",\"name\":\"%s\"}",
+                        transfer.first ? "" : ",", transfer.dir.fileName().c_str() + 1);
+  transfer.client.write((const uint8_t*) entry, min(length, (int) sizeof(entry) - 1));
+  transfer.first = false;
+  return true;
+}
+
+void handleNetwork()
+{
+  TRACE_SCOPE("network");
+  uint32_t start = micros();
+
+  TRACE_BEGIN("webSocketsServer");
+  webSocketsServer.loop();
+  TRACE_END();
+
+  if (micros() - start < networkBudgetMicros && findFreeTransfer()) {
+    TRACE_SCOPE("handleClient");
+    webServer.handleClient();
+  }
+
+  TRACE_BEGIN("transfers");
+  // round robin over the transfers until they are done, blocked on the
+  // send window, or the budget is spent
+  bool sent = true;
+  while (sent && micros() - start < networkBudgetMicros) {
+    sent = false;
+    for (uint8_t i = 0; i < TRANSFER_SLOTS; i++) {
+      if (transfers[i].type != TransferNone)
+        sent |= continueTransfer(transfers[i]);
+    }
+  }
+  TRACE_END();
+
+  uint32_t elapsed = micros() - start;
+  if (elapsed > networkMicrosWorst)
+    networkMicrosWorst = elapsed;
+}
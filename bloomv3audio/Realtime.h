@@ -0,0 +1,255 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Realtime pixel input from a show controller over UDP, on udpLocalPort.
+// Three protocols are recognised by their headers, so they can share the
+// one port:
+//
+//   DDP          10 byte header (14 with a timecode), RGB data at a byte
+//                offset into the strip; once a sender has set the push flag
+//                its frames are only shown on push
+//   E1.31/sACN   DMX universes of 170 RGB pixels, universe
+//                REALTIME_E131_START_UNIVERSE first
+//   Art-Net      ArtDmx, the same layout from REALTIME_ARTNET_START_UNIVERSE;
+//                Art-Net numbers universes from 0, E1.31 from 1
+//
+// Pixel data is read from the packet straight into leds[], without going
+// through a buffer.  Packets that arrive late (an older sequence number than
+// the last one for that stream) are dropped rather than drawn over newer
+// data; there is no reorder buffer, since holding packets back would cost
+// the copies this avoids.
+//
+// While packets keep arriving the local pattern is paused.  After
+// REALTIME_TIMEOUT ms without one it takes over again.
+
+#define REALTIME_TIMEOUT 2500
+#define REALTIME_E131_START_UNIVERSE 1
+#define REALTIME_ARTNET_START_UNIVERSE 0
+#define REALTIME_UNIVERSE_PIXELS 170
+#define REALTIME_UNIVERSES ((NUM_LEDS + REALTIME_UNIVERSE_PIXELS - 1) / REALTIME_UNIVERSE_PIXELS)
+// packets handled per loop(), so a flood can't starve the web server
+#define REALTIME_MAX_PACKETS 8
+
+#define DDP_HEADER_SIZE 10
+#define DDP_FLAGS_VERSION_MASK 0xC0
+#define DDP_FLAGS_VERSION_1 0x40
+#define DDP_FLAGS_TIMECODE 0x10
+#define DDP_FLAGS_QUERY 0x04
+#define DDP_FLAGS_PUSH 0x01
+#define DDP_ID_DISPLAY 1
+#define DDP_ID_ALL 255
+
+#define E131_HEADER_SIZE 126
+#define ARTNET_HEADER_SIZE 18
+#define ARTNET_OPCODE_DMX 0x5000
+
+bool realtimeActive = false;
+bool realtimeFrameReady = false;
+uint32_t realtimeLastPacket = 0;
+
+uint8_t ddpSequence = 0;
+bool ddpPush = false;
+uint8_t universeSequence[REALTIME_UNIVERSES];
+
+uint32_t realtimePackets = 0;
+uint32_t realtimeFrames = 0;
+uint32_t realtimeDropped = 0;
+
+// true if sequence is older than last: 8 bit sequence numbers, using the
+// window from the E1.31 spec, and 0 meaning the sender doesn't number them
+bool isLateSequence(uint8_t sequence, uint8_t last)
+{
+  int8_t difference = sequence - last;
+  return sequence != 0 && difference <= 0 && difference > -20;
+}
+
+// Read count bytes of RGB data into leds[], starting at byte offset, and
+// throw away whatever doesn't fit.
+void readRealtimePixels(uint32_t offset, uint16_t count)
+{
+  const uint32_t size = NUM_LEDS * sizeof(CRGB);
+  if (offset >= size)
+    return;
+  if (count > size - offset)
+    count = size - offset;
+
+  udp.read((uint8_t*) leds + offset, count);
+}
+
+bool handleDdp(const uint8_t* header, int size)
+{
+  uint8_t flags = header[0];
+  if ((flags & DDP_FLAGS_VERSION_MASK) != DDP_FLAGS_VERSION_1 || (flags & DDP_FLAGS_QUERY))
+    return false;
+  if (header[3] != DDP_ID_DISPLAY && header[3] != DDP_ID_ALL)
+    return false;
+
+  // 4 bit sequence number, 0 when unused
+  uint8_t sequence = header[1] & 0x0F;
+  if (sequence && ddpSequence) {
+    int8_t difference = ((sequence - ddpSequence) & 0x0F);
+    if (difference == 0 || difference > 8) {
+      realtimeDropped++;
+      return true;
+    }
+  }
+  ddpSequence = sequence;
+
+  uint32_t offset = ((uint32_t) header[4] << 24) | ((uint32_t) header[5] << 16) | (header[6] << 8) | header[7];
+  uint16_t length = (header[8] << 8) | header[9];
+
+  int headerSize = DDP_HEADER_SIZE;
+  if (flags & DDP_FLAGS_TIMECODE) {
+    uint8_t timecode[4];
+    headerSize += udp.read(timecode, sizeof(timecode));
+  }
+
+  if (length > size - headerSize)
+    length = size - headerSize;
+
+  readRealtimePixels(offset, length);
+
+  if (flags & DDP_FLAGS_PUSH)
+    ddpPush = true;
+  if (!ddpPush || (flags & DDP_FLAGS_PUSH))
+    realtimeFrameReady = true;
+  return true;
+}
+
+// E1.31 and Art-Net: one universe of DMX, 3 channels per pixel, where
+// startUniverse is the protocol's first universe for the strip
+void handleUniverse(uint16_t universe, uint16_t startUniverse, uint8_t sequence, int channels)
+{
+  if (universe < startUniverse || universe >= startUniverse + REALTIME_UNIVERSES)
+    return;
+
+  uint8_t index = universe - startUniverse;
+  if (isLateSequence(sequence, universeSequence[index])) {
+    realtimeDropped++;
+    return;
+  }
+  universeSequence[index] = sequence;
+
+  if (channels > REALTIME_UNIVERSE_PIXELS * 3)
+    channels = REALTIME_UNIVERSE_PIXELS * 3;
+  readRealtimePixels(index * REALTIME_UNIVERSE_PIXELS * sizeof(CRGB), channels);
+  realtimeFrameReady = true;
+}
+
+bool handleE131(const uint8_t* header, int size)
+{
+  static const uint8_t acnId[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+
+  if (size < E131_HEADER_SIZE || header[0] != 0x00 || header[1] != 0x10 || memcmp(header + 4, acnId, sizeof(acnId)) != 0)
+    return false;
+
+  // root vector VECTOR_ROOT_E131_DATA, framing vector VECTOR_E131_DATA_PACKET
+  if (header[21] != 0x04 || header[43] != 0x02)
+    return true;
+
+  // preview data and stream terminated are not for us, DMX start code 0 only
+  uint8_t options = header[112];
+  if ((options & 0xC0) || header[125] != 0)
+    return true;
+
+  uint8_t sequence = header[111];
+  uint16_t universe = (header[113] << 8) | header[114];
+  int count = (header[123] << 8) | header[124]; // includes the start code
+
+  if (count < 1)
+    return true;
+
+  handleUniverse(universe, REALTIME_E131_START_UNIVERSE, sequence, min(count - 1, size - E131_HEADER_SIZE));
+  return true;
+}
+
+bool handleArtnet(const uint8_t* header, int size)
+{
+  if (size < ARTNET_HEADER_SIZE || memcmp(header, "Art-Net", 8) != 0)
+    return false;
+
+  uint16_t opcode = header[8] | (header[9] << 8);
+  if (opcode != ARTNET_OPCODE_DMX)
+    return true;
+
+  uint8_t sequence = header[12];
+  uint16_t universe = header[14] | (header[15] << 8);
+  int length = (header[16] << 8) | header[17];
+
+  handleUniverse(universe, REALTIME_ARTNET_START_UNIVERSE, sequence, min(length, size - ARTNET_HEADER_SIZE));
+  return true;
+}
+
+// Read what has arrived and show it.  Returns true while realtime input is
+// driving the LEDs, false when the local pattern should run.
+bool handleRealtime()
+{
+  for (uint8_t i = 0; i < REALTIME_MAX_PACKETS; i++) {
+    int size = udp.parsePacket();
+    if (size <= 0)
+      break;
+
+    // read enough of the header to tell the protocols apart, then the rest
+    // of the header for the one it is
+    uint8_t header[E131_HEADER_SIZE];
+    int headerSize = udp.read(header, min(size, DDP_HEADER_SIZE));
+
+    bool handled = false;
+    if (headerSize == DDP_HEADER_SIZE) {
+      // "Art-Net" has to be checked first, 'A' looks like DDP version 1
+      if (memcmp(header, "Art-Net", 7) == 0) {
+        udp.read(header + headerSize, min(size, ARTNET_HEADER_SIZE) - headerSize);
+        handled = handleArtnet(header, size);
+      }
+      else if (header[0] == 0x00 && header[1] == 0x10) {
+        udp.read(header + headerSize, min(size, E131_HEADER_SIZE) - headerSize);
+        handled = handleE131(header, size);
+      }
+      else if ((header[0] & DDP_FLAGS_VERSION_MASK) == DDP_FLAGS_VERSION_1) {
+        handled = handleDdp(header, size);
+      }
+    }
+
+    if (handled) {
+      realtimePackets++;
+      realtimeLastPacket = millis();
+      if (!realtimeActive) {
+        realtimeActive = true;
+        Serial.printf("Realtime input from %s\n", udp.remoteIP().toString().c_str());
+      }
+    }
+  }
+
+  if (realtimeActive && millis() - realtimeLastPacket > REALTIME_TIMEOUT) {
+    realtimeActive = false;
+    ddpSequence = 0;
+    ddpPush = false;
+    memset(universeSequence, 0, sizeof(universeSequence));
+    Serial.printf("Realtime input stopped: %u packets, %u frames, %u dropped\n", realtimePackets, realtimeFrames, realtimeDropped);
+  }
+
+  if (!realtimeActive)
+    return false;
+
+  if (realtimeFrameReady) {
+    realtimeFrameReady = false;
+    realtimeFrames++;
+    FastLED.show();
+  }
+
+  return true;
+}
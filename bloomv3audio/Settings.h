@@ -0,0 +1,193 @@
+/*
+   ESP8266 + FastLED + Audio: https://github.com/jasoncoon/esp8266-fastled-audio
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Settings, kept in the flash sector the EEPROM library used to have.
+//
+// EEPROM.commit() erases and rewrites the whole sector every time, which
+// stalls loop() for a few ms and wears the flash out a sector at a time:
+// dragging the brightness slider did it dozens of times.  Instead, changes
+// are made in RAM with writeSetting(), and only once nothing has changed
+// for SETTINGS_WRITE_DELAY ms is a record with all of them appended to the
+// sector.  A record only programs its own few bytes, no erase.
+//
+// Record, SETTINGS_RECORD_SIZE bytes:
+//
+//   'S' SETTINGS_SIZE  sequence (16 bits, little endian)
+//   settings[SETTINGS_SIZE]
+//   CRC-32 of the above
+//
+// beginSettings() takes the last record with a good CRC, so a record torn
+// by a reset half way through writing is skipped.  When the sector is
+// full it is erased and the current record written at the start, which is
+// the only erase in SETTINGS_RECORDS writes; a reset between the two
+// loses the settings, as a reset during EEPROM.commit() always could.
+
+#ifndef SETTINGS_SECTOR
+extern "C" uint32_t _SPIFFS_end;
+// where the ESP8266 core puts EEPROM, just after SPIFFS
+#define SETTINGS_SECTOR ((((uint32_t) &_SPIFFS_end) - 0x40200000) / SPI_FLASH_SEC_SIZE)
+#endif
+
+#define SETTINGS_SIZE 16
+#define SETTINGS_RECORD_SIZE (4 + SETTINGS_SIZE + 4)
+#define SETTINGS_RECORDS (SPI_FLASH_SEC_SIZE / SETTINGS_RECORD_SIZE)
+#define SETTINGS_MAGIC 'S'
+#define SETTINGS_WRITE_DELAY 3000
+
+uint8_t settings[SETTINGS_SIZE];
+bool settingsDirty = false;
+uint32_t settingsChangedMillis = 0;
+
+uint16_t settingsSequence = 0;
+uint16_t settingsNextRecord = 0; // where the next record goes
+
+uint32_t settingsWrites = 0;
+uint32_t settingsErases = 0;
+
+uint32_t settingsCrc(const uint8_t* data, size_t length)
+{
+  uint32_t crc = 0xFFFFFFFF;
+  while (length--) {
+    crc ^= *data++;
+    for (uint8_t bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+  }
+  return ~crc;
+}
+
+bool readSettingsRecord(uint16_t index, uint32_t* record)
+{
+  return ESP.flashRead(SETTINGS_SECTOR * SPI_FLASH_SEC_SIZE + index * SETTINGS_RECORD_SIZE, record, SETTINGS_RECORD_SIZE);
+}
+
+// Find the newest record and load it into settings[].  Returns false if
+// there isn't one.
+bool beginSettings()
+{
+  uint32_t record[SETTINGS_RECORD_SIZE / 4];
+  const uint8_t* bytes = (const uint8_t*) record;
+  int16_t newest = -1;
+  bool legacy = false;
+
+  settingsNextRecord = 0;
+
+  for (uint16_t i = 0; i < SETTINGS_RECORDS; i++) {
+    if (!readSettingsRecord(i, record))
+      break;
+
+    bool erased = true;
+    for (uint8_t j = 0; j < SETTINGS_RECORD_SIZE / 4; j++)
+      erased &= record[j] == 0xFFFFFFFF;
+    if (erased)
+      continue;
+
+    settingsNextRecord = i + 1;
+
+    if (bytes[0] != SETTINGS_MAGIC || bytes[1] != SETTINGS_SIZE) {
+      // the start of the sector as the EEPROM library left it
+      legacy |= i == 0;
+      continue;
+    }
+
+    uint32_t crc = bytes[SETTINGS_RECORD_SIZE - 4] | (bytes[SETTINGS_RECORD_SIZE - 3] << 8) |
+                   ((uint32_t) bytes[SETTINGS_RECORD_SIZE - 2] << 16) | ((uint32_t) bytes[SETTINGS_RECORD_SIZE - 1] << 24);
+    if (crc != settingsCrc(bytes, SETTINGS_RECORD_SIZE - 4))
+      continue;
+
+    newest = i;
+    settingsSequence = bytes[2] | (bytes[3] << 8);
+    memcpy(settings, bytes + 4, SETTINGS_SIZE);
+  }
+
+  if (newest < 0 && legacy) {
+    // settings saved by EEPROM.commit() before there was a journal
+    readSettingsRecord(0, record);
+    memcpy(settings, bytes, SETTINGS_SIZE);
+    Serial.printf("Settings: taken from EEPROM\n");
+    return true;
+  }
+
+  if (newest < 0) {
+    Serial.printf("Settings: none saved\n");
+    return false;
+  }
+
+  Serial.printf("Settings: record %u of %u, sequence %u\n", newest, SETTINGS_RECORDS, settingsSequence);
+  return true;
+}
+
+uint8_t readSetting(uint8_t address)
+{
+  return address < SETTINGS_SIZE ? settings[address] : 0;
+}
+
+void writeSetting(uint8_t address, uint8_t value)
+{
+  if (address >= SETTINGS_SIZE || settings[address] == value)
+    return;
+
+  settings[address] = value;
+  settingsDirty = true;
+  settingsChangedMillis = millis();
+}
+
+// Append a record with the current settings, erasing the sector first if
+// it is full.
+bool commitSettings()
+{
+  if (settingsNextRecord >= SETTINGS_RECORDS) {
+    if (!ESP.flashEraseSector(SETTINGS_SECTOR))
+      return false;
+    settingsNextRecord = 0;
+    settingsErases++;
+  }
+
+  uint32_t record[SETTINGS_RECORD_SIZE / 4];
+  uint8_t* bytes = (uint8_t*) record;
+
+  settingsSequence++;
+  bytes[0] = SETTINGS_MAGIC;
+  bytes[1] = SETTINGS_SIZE;
+  bytes[2] = settingsSequence & 0xFF;
+  bytes[3] = settingsSequence >> 8;
+  memcpy(bytes + 4, settings, SETTINGS_SIZE);
+
+  uint32_t crc = settingsCrc(bytes, SETTINGS_RECORD_SIZE - 4);
+  bytes[SETTINGS_RECORD_SIZE - 4] = crc & 0xFF;
+  bytes[SETTINGS_RECORD_SIZE - 3] = (crc >> 8) & 0xFF;
+  bytes[SETTINGS_RECORD_SIZE - 2] = (crc >> 16) & 0xFF;
+  bytes[SETTINGS_RECORD_SIZE - 1] = crc >> 24;
+
+  // on a failed write the slot is used up either way; try the next one
+  // after another delay
+  uint16_t index = settingsNextRecord++;
+  if (!ESP.flashWrite(SETTINGS_SECTOR * SPI_FLASH_SEC_SIZE + index * SETTINGS_RECORD_SIZE, record, SETTINGS_RECORD_SIZE)) {
+    settingsChangedMillis = millis();
+    return false;
+  }
+
+  settingsDirty = false;
+  settingsWrites++;
+  return true;
+}
+
+// Called once a loop(): writes the settings once they have settled.
+void handleSettings()
+{
+  if (settingsDirty && millis() - settingsChangedMillis >= SETTINGS_WRITE_DELAY)
+    commitSettings();
+}
@@ -170,7 +170,7 @@ void drawTwinkles()
   // numbers that it generates is (paradoxically) stable.
   uint16_t PRNG16 = 11337;
 
-  uint32_t clock32 = millis();
+  uint32_t clock32 = GET_MILLIS();
 
   // Set up the background color, "bg".
   // if AUTO_SELECT_BACKGROUND_COLOR == 1, and the first two colors of
@@ -194,7 +194,7 @@ void drawTwinkles()
 
   uint8_t backgroundBrightness = bg.getAverageLight();
 
-  for(uint8_t i = 0; i < NUM_LEDS; i++) {
+  for(uint16_t i = 0; i < NUM_LEDS; i++) {
     CRGB& pixel = leds[i];
 
     PRNG16 = (uint16_t)(PRNG16 * 2053) + 1384; // next 'random' number
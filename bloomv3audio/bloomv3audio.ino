@@ -19,6 +19,8 @@
 
 
 
+// patterns run on the shared clock from ClockSync.h
+#define USE_GET_MILLISECOND_TIMER
 #include <FastLED.h>
 FASTLED_USING_NAMESPACE
 
@@ -32,11 +34,12 @@ extern "C" {
 #include <ESP8266HTTPUpdateServer.h>
 #include <WebSocketsServer.h>
 #include <FS.h>
-#include <EEPROM.h>
 #include <IRremoteESP8266.h>
 #include <TimeLib.h>
 #include <WiFiUdp.h>
 #include "GradientPalettes.h"
+#include "JsonWriter.h"
+#include "Settings.h"
 #define ARRAY_SIZE(A) (sizeof(A) / sizeof((A)[0]))
 
 #include "Field.h"
@@ -108,6 +111,9 @@ ESP8266WebServer webServer(80);
 WebSocketsServer webSocketsServer = WebSocketsServer(81);
 ESP8266HTTPUpdateServer httpUpdateServer;
 
+#include "Trace.h"
+#include "Network.h"
+#include "Assets.h"
 #include "FSBrowser.h"
 
 
@@ -188,9 +194,13 @@ typedef struct {
 } PatternAndName;
 typedef PatternAndName PatternAndNameList[];
 
+#define LAYOUT_MAX_LEDS NUM_LEDS
+#include "Layout.h"
 #include "Map.h"
 #include "Twinkles.h"
 #include "TwinkleFOX.h"
+#include "Realtime.h"
+#include "ClockSync.h"
 
 // List of patterns to cycle through.  Each is defined as a separate function below.
 
@@ -251,6 +261,8 @@ PatternAndNameList patterns = {
 const uint8_t patternCount = ARRAY_SIZE(patterns);
 
 #include "Fields.h"
+#include "Metrics.h"
+#include "Bench.h"
 
 void setup() {
   Serial.begin(115200);
@@ -265,8 +277,10 @@ void setup() {
   fill_solid(leds, NUM_LEDS, CRGB::Black);
   FastLED.show();
 
-  EEPROM.begin(512);
-  loadSettings();
+  if (beginSettings())
+    loadSettings();
+  else
+    storeSettings();
 
   FastLED.setBrightness(brightness);
 
@@ -293,6 +307,11 @@ void setup() {
     }
     Serial.printf("\n");
   }
+  buildAssetIndex();
+
+  if (!loadLayout("/layout.bin")) {
+    layoutFromMap();
+  }
 
   // Set Hostname.
   String hostname(HOSTNAME);
@@ -348,9 +367,16 @@ void setup() {
 
   httpUpdateServer.setup(&webServer);
 
+  // for the asset ETags
+  const char* headerKeys[] = { "If-None-Match" };
+  webServer.collectHeaders(headerKeys, 1);
+
   webServer.on("/all", HTTP_GET, []() {
-    String json = getFieldsJson(fields, fieldCount);
-    webServer.send(200, "text/json", json);
+    JsonWriter json(webServer);
+    json.begin("text/json");
+    writeFieldsJson(json, fields, fieldCount);
+    json.end();
+    Serial.printf("/all: %u bytes, free heap low %u\n", (unsigned) json.length, json.minFreeHeap);
   });
 
   webServer.on("/fieldValue", HTTP_GET, []() {
@@ -449,6 +475,10 @@ void setup() {
     sendInt(autoplayDuration);
   });
 
+  webServer.on("/metrics", HTTP_GET, handleMetrics);
+  webServer.on("/trace", HTTP_GET, handleTrace);
+  webServer.on("/bench", HTTP_GET, handleBench);
+
   //list directory
   webServer.on("/list", HTTP_GET, handleFileList);
   //load editor
@@ -465,7 +495,11 @@ void setup() {
     webServer.send(200, "text/plain", "");
   }, handleFileUpload);
 
-  webServer.serveStatic("/", SPIFFS, "/", "max-age=86400");
+  // static files, sent over the next frames by handleNetwork()
+  webServer.onNotFound([]() {
+    if (webServer.method() != HTTP_GET || !handleFileRead(webServer.uri(), "max-age=86400"))
+      webServer.send(404, "text/plain", "FileNotFound");
+  });
 
   webServer.begin();
   Serial.println("HTTP web server started");
@@ -474,6 +508,9 @@ void setup() {
   webSocketsServer.onEvent(webSocketEvent);
   Serial.println("Web socket server started");
 
+  udp.begin(udpLocalPort);
+  Serial.printf("Realtime UDP input on port %u\n", udpLocalPort);
+
   autoPlayTimeout = millis() + (autoplayDuration * 1000);
 }
 
@@ -500,28 +537,38 @@ void broadcastString(String name, String value)
 }
 
 void loop() {
+  beginFrame();
+
   // Add entropy to random number generator; we use a lot of it.
   random16_add_entropy(random(65535));
 
-  webSocketsServer.loop();
-  webServer.handleClient();
+  // WebSocket, HTTP and file transfers, within the frame's network budget
+  handleNetwork();
+  handleClockSync();
+  handleSettings();
+  endPhase(PhaseNetwork);
 
   // handleIrInput();
 
   if (power == 0) {
     fill_solid(leds, NUM_LEDS, CRGB::Black);
     FastLED.show();
+    endPhase(PhaseShow);
     // FastLED.delay(15);
     return;
   }
 
-  // EVERY_N_SECONDS(10) {
-  //   Serial.print( F("Heap: ") ); Serial.println(system_get_free_heap_size());
-  // }
+  // a show controller is sending pixels, the local pattern waits
+  if (handleRealtime()) {
+    endPhase(PhaseShow);
+    return;
+  }
 
-  // change to a new cpt-city gradient palette
-  EVERY_N_SECONDS( secondsPerPalette ) {
-    gCurrentPaletteNumber = addmod8( gCurrentPaletteNumber, 1, gGradientPaletteCount);
+  // change to a new cpt-city gradient palette, counted on the shared clock
+  // so that nodes change together
+  uint8_t paletteNumber = (clockMillis() / 1000 / secondsPerPalette) % gGradientPaletteCount;
+  if (paletteNumber != gCurrentPaletteNumber) {
+    gCurrentPaletteNumber = paletteNumber;
     gTargetPalette = gGradientPalettes[ gCurrentPaletteNumber ];
 
     //    paletteIndex = addmod8( paletteIndex, 1, paletteCount);
@@ -532,21 +579,28 @@ void loop() {
     // slowly blend the current palette to the next
     nblendPaletteTowardPalette( gCurrentPalette, gTargetPalette, 8);
     //    nblendPaletteTowardPalette(currentPalette, targetPalette, 16);
-    gHue++;  // slowly cycle the "base color" through the rainbow
   }
 
+  gHue = clockMillis() / 40;  // slowly cycle the "base color" through the rainbow
+
   if (autoplay && (millis() > autoPlayTimeout)) {
     adjustPattern(true);
     autoPlayTimeout = millis() + (autoplayDuration * 1000);
   }
 
   // Call the current pattern function once, updating the 'leds' array
+  TRACE_BEGIN(patterns[currentPatternIndex].name.c_str());
   patterns[currentPatternIndex].pattern();
+  TRACE_END();
+  endPhase(PhasePattern);
 
+  TRACE_BEGIN("show");
   FastLED.show();
 
   // insert a delay to keep the framerate modest
   FastLED.delay(1000 / FRAMES_PER_SECOND);
+  TRACE_END();
+  endPhase(PhaseShow);
 }
 
 void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length) {
@@ -588,17 +642,21 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length
 
 void loadSettings()
 {
-  brightness = EEPROM.read(0);
+  // the brightness can't be set to 0, so a record with it, and power 0, is
+  // one of zeros written before storeSettings(): it would boot dark
+  bool zeroed = readSetting(0) == 0;
+  if (!zeroed)
+    brightness = readSetting(0);
 
-  currentPatternIndex = EEPROM.read(1);
+  currentPatternIndex = readSetting(1);
   if (currentPatternIndex < 0)
     currentPatternIndex = 0;
   else if (currentPatternIndex >= patternCount)
     currentPatternIndex = patternCount - 1;
 
-  byte r = EEPROM.read(2);
-  byte g = EEPROM.read(3);
-  byte b = EEPROM.read(4);
+  byte r = readSetting(2);
+  byte g = readSetting(3);
+  byte b = readSetting(4);
 
   if (r == 0 && g == 0 && b == 0)
   {
@@ -608,18 +666,35 @@ void loadSettings()
     solidColor = CRGB(r, g, b);
   }
 
-  power = EEPROM.read(5);
+  if (!zeroed || readSetting(5) != 0)
+    power = readSetting(5);
+
+  autoplay = readSetting(6);
 
-  autoplay = EEPROM.read(6);
-  autoplayDuration = EEPROM.read(7);
+  // 0 would move autoplay on every frame
+  if (readSetting(7) != 0)
+    autoplayDuration = readSetting(7);
+}
+
+// Fill settings[] with the current values, for a device without a record:
+// otherwise the first writeSetting() would save them all as 0 but its own.
+void storeSettings()
+{
+  settings[0] = brightness;
+  settings[1] = currentPatternIndex;
+  settings[2] = solidColor.r;
+  settings[3] = solidColor.g;
+  settings[4] = solidColor.b;
+  settings[5] = power;
+  settings[6] = autoplay;
+  settings[7] = autoplayDuration;
 }
 
 void setPower(uint8_t value)
 {
   power = value == 0 ? 0 : 1;
 
-  EEPROM.write(5, power);
-  EEPROM.commit();
+  writeSetting(5, power);
 
   broadcastInt("power", power);
 }
@@ -628,18 +703,17 @@ void setAutoplay(uint8_t value)
 {
   autoplay = value == 0 ? 0 : 1;
 
-  EEPROM.write(6, autoplay);
-  EEPROM.commit();
+  writeSetting(6, autoplay);
 
   broadcastInt("autoplay", autoplay);
 }
 
 void setAutoplayDuration(uint8_t value)
 {
-  autoplayDuration = value;
+  // 0 would move autoplay on every frame
+  autoplayDuration = max(value, (uint8_t) 1);
 
-  EEPROM.write(7, autoplayDuration);
-  EEPROM.commit();
+  writeSetting(7, autoplayDuration);
 
   autoPlayTimeout = millis() + (autoplayDuration * 1000);
 
@@ -655,10 +729,9 @@ void setSolidColor(uint8_t r, uint8_t g, uint8_t b)
 {
   solidColor = CRGB(r, g, b);
 
-  EEPROM.write(2, r);
-  EEPROM.write(3, g);
-  EEPROM.write(4, b);
-  EEPROM.commit();
+  writeSetting(2, r);
+  writeSetting(3, g);
+  writeSetting(4, b);
 
   setPattern(patternCount - 1);
 
@@ -680,8 +753,7 @@ void adjustPattern(bool up)
     currentPatternIndex = 0;
 
   if (autoplay == 0) {
-    EEPROM.write(1, currentPatternIndex);
-    EEPROM.commit();
+    writeSetting(1, currentPatternIndex);
   }
 
   broadcastInt("pattern", currentPatternIndex);
@@ -695,8 +767,7 @@ void setPattern(uint8_t value)
   currentPatternIndex = value;
 
   if (autoplay == 0) {
-    EEPROM.write(1, currentPatternIndex);
-    EEPROM.commit();
+    writeSetting(1, currentPatternIndex);
   }
 
   broadcastInt("pattern", currentPatternIndex);
@@ -723,8 +794,7 @@ void adjustBrightness(bool up)
 
   FastLED.setBrightness(brightness);
 
-  EEPROM.write(0, brightness);
-  EEPROM.commit();
+  writeSetting(0, brightness);
 
   broadcastInt("brightness", brightness);
 }
@@ -739,8 +809,7 @@ void setBrightness(uint8_t value)
 
   FastLED.setBrightness(brightness);
 
-  EEPROM.write(0, brightness);
-  EEPROM.commit();
+  writeSetting(0, brightness);
 
   broadcastInt("brightness", brightness);
 }
@@ -831,7 +900,7 @@ void juggle()
   static uint8_t   basebeat =   5; // Higher = faster movement.
 
   static uint8_t lastSecond =  99;  // Static variable, means it's only defined once. This is our 'debounce' variable.
-  uint8_t secondHand = (millis() / 1000) % 30; // IMPORTANT!!! Change '30' to a different value to change duration of the loop.
+  uint8_t secondHand = (GET_MILLIS() / 1000) % 30; // IMPORTANT!!! Change '30' to a different value to change duration of the loop.
 
   if (lastSecond != secondHand) { // Debounce to make sure we're not repeating an assignment.
     lastSecond = secondHand;
@@ -848,7 +917,7 @@ void juggle()
   fadeToBlackBy(leds, NUM_LEDS, faderate);
   for ( int i = 0; i < numdots; i++) {
     //beat16 is a FastLED 3.1 function
-    leds[beatsin16(basebeat + i + numdots, 0, NUM_LEDS)] += CHSV(gHue + curhue, thissat, thisbright);
+    leds[beatsin16(basebeat + i + numdots, 0, NUM_LEDS - 1)] += CHSV(gHue + curhue, thissat, thisbright);
     curhue += hueinc;
   }
 }
@@ -909,10 +978,11 @@ void pride()
 
 void radialPaletteShift()
 {
-  for (uint8_t i = 0; i < NUM_LEDS; i++) {
+  for (uint16_t i = 0; i < layoutCount; i++) {
     // leds[i] = ColorFromPalette( gCurrentPalette, gHue + sin8(i*16), brightness);
-    leds[i] = ColorFromPalette(gCurrentPalette, i + gHue, 255, LINEARBLEND);
+    leds[i] = ColorFromPalette(gCurrentPalette, layoutRadius[i] + gHue, 255, LINEARBLEND);
   }
+  layoutClearRest(leds, NUM_LEDS);
 }
 
 // based on FastLED example Fire2012WithPalette: https://github.com/FastLED/FastLED/blob/master/examples/Fire2012WithPalette/Fire2012WithPalette.ino
@@ -1094,61 +1164,46 @@ void welcome() {
   delay(500);
 }
 
+// radiate() keeps its state in rings rather than in leds[]: ring 0 is the
+// centre, each channel moves outward at its own rate, and every LED shows the
+// ring at its precomputed radius, so it works for any layout.
+#define RADIATE_RINGS (NUM_LEDS / 2)
+CRGB radiateRings[RADIATE_RINGS];
+
 void radiate() {
   READ_AUDIO();
   //int SPEED = mono[0] * 0.004;
-  //HALF_POS = beatsin8(40, 30 + SPEED, 80 + SPEED);
   MILLISECONDS  = 0;
   //lowPass_audio = 0.10;
   //filter_min    = 100;
 
-  //  EVERY_N_MILLISECONDS(50) {
-  //    hue++;
-  //    if ( hue > 255) hue = 0;
-  //  }
-
-
   zero_l  = left[0];
   three_l = left[3];
   six_l   = left[6];
 
-  zero_r  = left[0];
-  three_r = left[3];
-  six_r   = left[6];
-
-  leds[HALF_POS] = CRGB(zero_l, three_l, six_l);
-  leds[HALF_POS + 1] = CRGB(zero_r, three_r, six_r);
-  leds[HALF_POS].fadeToBlackBy(30);
-
+  radiateRings[0] = CRGB(zero_l, three_l, six_l);
+  radiateRings[0].fadeToBlackBy(30);
 
   EVERY_N_MILLISECONDS(11) {
-    for (int i = NUM_LEDS - 1; i > HALF_POS + 1; i--) {
-      leds[i].blue = leds[i - 1].blue;
-    }
-    for (int i = 0; i < HALF_POS; i++) {
-      leds[i].blue = leds[i + 1].blue;
+    for (int i = RADIATE_RINGS - 1; i > 0; i--) {
+      radiateRings[i].blue = radiateRings[i - 1].blue;
     }
   }
   EVERY_N_MILLISECONDS(27) {
-    for (int i = NUM_LEDS - 1; i > HALF_POS + 1; i--) {
-      leds[i].green = leds[i - 1].green;
-    }
-    for (int i = 0; i < HALF_POS; i++) {
-      leds[i].green = leds[i + 1].green;
+    for (int i = RADIATE_RINGS - 1; i > 0; i--) {
+      radiateRings[i].green = radiateRings[i - 1].green;
     }
   }
   EVERY_N_MILLISECONDS(52) {
-    for (int i = NUM_LEDS - 1; i > HALF_POS + 1; i--) {
-      leds[i].red = leds[i - 1].red;
-    }
-    for (int i = 0; i < HALF_POS; i++) {
-      leds[i].red = leds[i + 1].red;
+    for (int i = RADIATE_RINGS - 1; i > 0; i--) {
+      radiateRings[i].red = radiateRings[i - 1].red;
     }
   }
 
-  EVERY_N_MILLISECONDS(2) {
-    //blur1d(leds, NUM_LEDS, 1);
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    leds[i] = radiateRings[scale8(layoutRadius[i], RADIATE_RINGS - 1)];
   }
+  layoutClearRest(leds, NUM_LEDS);
   FastLED.show();
 }
 
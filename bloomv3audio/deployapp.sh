@@ -7,6 +7,12 @@
 ip=${1:-"192.168.0.127"}
 url="http://$ip/edit"
 
+# the whole app goes up as one gzipped bundle, see tools/mkbundle.py;
+# pass --inline to put the pages' CSS and JS into the pages as well
+python3 ../tools/mkbundle.py data -o build/assets.bin $2
+
+# files uploaded one at a time before the bundle would be served instead
+# of it, so remove them
 declare -a filenames=("css/styles.css"
                      "js/app.js"
                      "index.htm"
@@ -14,17 +20,11 @@ declare -a filenames=("css/styles.css"
                      "js/simple.js"
                      "simple.htm")
 
-# "images/atom196.png"
-# "favicon.ico"
-
 for filename in "${filenames[@]}"
 do
-  # add --trace-ascii curl.log for logging
-
-  gzip -kf data/$filename
+  curl -s -X DELETE "$url?path=/$filename.gz" > /dev/null
+done
 
-  echo $filename
-  curl --form "file=@data/$filename.gz;filename=$filename.gz" $url
+# add --trace-ascii curl.log for logging
 
-  rm -f data/$filename.gz
-done
+curl --form "file=@build/assets.bin;filename=assets.bin" $url
@@ -11,25 +11,187 @@ var postValueTimer = {};
 
 var ignoreColorChange = false;
 
+// binary WebSocket protocol, see Protocol.h
+// a field's id is its index in the /all array
+var protocol = {
+  get: 0x01, set: 0x02, subscribe: 0x03, unsubscribe: 0x04,
+  previewSubscribe: 0x05, previewUnsubscribe: 0x06, previewAck: 0x07,
+  value: 0x81, previewFrame: 0x82, error: 0xFF
+};
+
+// live preview, see Preview.h
+var previewFps = 0;
+var previewPixels = null;
+
+var fields = [];
+var fieldIds = {};
+
 var ws = new ReconnectingWebSocket('ws://' + address + ':81/', ['arduino']);
 ws.debug = true;
 
+ws.onopen = function() {
+  subscribe();
+  subscribePreview();
+}
+
 ws.onmessage = function(evt) {
-  if(evt.data != null)
-  {
-    var data = JSON.parse(evt.data);
-    if(data == null) return;
-    updateFieldValue(data.name, data.value);
+  if(evt.data == null) return;
+
+  if(evt.data instanceof Blob) {
+    var reader = new FileReader();
+    reader.onload = function() {
+      handleBinaryMessage(new Uint8Array(reader.result));
+    };
+    reader.readAsArrayBuffer(evt.data);
+    return;
+  }
+
+  // an array of every field that changed in a frame
+  var data = JSON.parse(evt.data);
+  if(data == null) return;
+  if(!Array.isArray(data)) data = [data];
+  data.forEach(function(item) {
+    updateFieldValue(item.name, item.value);
+  });
+}
+
+function subscribe() {
+  // wait until /all has told us the field ids
+  if (fields.length == 0 || ws.readyState != WebSocket.OPEN) return;
+
+  ws.send(new Uint8Array([protocol.subscribe]));
+}
+
+function handleBinaryMessage(message) {
+  if (message.length < 2) return;
+
+  if (message[0] == protocol.error) {
+    console.log("protocol error: opcode " + message[1] + ", field " + message[2]);
+    return;
+  }
+
+  if (message[0] == protocol.previewFrame) {
+    drawPreviewFrame(message);
+    return;
+  }
+
+  if (message[0] != protocol.value) return;
+
+  // one or more id, value pairs
+  var offset = 1;
+  while (offset + 1 < message.length) {
+    var field = fields[message[offset]];
+    if (field == null) return;
+
+    if (field.type == "Color") {
+      field.value = message[offset + 1] + "," + message[offset + 2] + "," + message[offset + 3];
+      offset += 4;
+    } else {
+      field.value = message[offset + 1];
+      offset += 2;
+    }
+
+    updateFieldValue(field.name, field.value);
+  }
+}
+
+function subscribePreview() {
+  if (ws.readyState != WebSocket.OPEN) return;
+
+  if (previewFps > 0) {
+    ws.send(new Uint8Array([protocol.previewSubscribe, previewFps]));
+  } else {
+    ws.send(new Uint8Array([protocol.previewUnsubscribe]));
+  }
+}
+
+// decode a frame into previewPixels (see Preview.h for the encoding), draw it
+// and ack it so the device sends the next one
+function drawPreviewFrame(message) {
+  var sequence = message[1];
+  var keyFrame = message[2] & 1;
+  var width = message[3];
+  var height = message[4];
+  var count = width * height;
+
+  if (previewPixels == null || previewPixels.length != count * 3) {
+    if (!keyFrame) return;
+    previewPixels = new Uint8Array(count * 3);
+  }
+
+  var pixel = 0;
+  var i = 5;
+  while (i < message.length && pixel < count) {
+    var op = message[i++];
+    var n;
+    if (op & 0x80) {
+      n = (op & 0x7F) + 1;
+      previewPixels.set(message.subarray(i, i + n * 3), pixel * 3);
+      i += n * 3;
+    } else if (op & 0x40) {
+      n = (op & 0x3F) + 1;
+      for (var j = 0; j < n; j++) {
+        previewPixels.set(message.subarray(i, i + 3), (pixel + j) * 3);
+      }
+      i += 3;
+    } else {
+      n = op + 1;
+    }
+    pixel += n;
   }
+
+  var canvas = document.getElementById("preview");
+  if (canvas.width != width || canvas.height != height) {
+    canvas.width = width;
+    canvas.height = height;
+  }
+
+  var context = canvas.getContext("2d");
+  var image = context.createImageData(width, height);
+  for (var p = 0; p < count; p++) {
+    image.data[p * 4] = previewPixels[p * 3];
+    image.data[p * 4 + 1] = previewPixels[p * 3 + 1];
+    image.data[p * 4 + 2] = previewPixels[p * 3 + 2];
+    image.data[p * 4 + 3] = 255;
+  }
+  context.putImageData(image, 0, 0);
+
+  ws.send(new Uint8Array([protocol.previewAck, sequence]));
+}
+
+function sendField(name, value) {
+  var id = fieldIds[name];
+  if (id == null || ws.readyState != WebSocket.OPEN) return false;
+
+  if (fields[id].type == "Color") {
+    ws.send(new Uint8Array([protocol.set, id, value.r, value.g, value.b]));
+  } else {
+    ws.send(new Uint8Array([protocol.set, id, parseInt(value)]));
+  }
+
+  return true;
 }
 
 $(document).ready(function() {
   $("#status").html("Connecting, please wait...");
 
+  $("#input-preview").change(function() {
+    previewFps = parseInt($(this).val());
+    previewPixels = null;
+    $("#preview").toggle(previewFps > 0);
+    subscribePreview();
+  });
+
   $.get(urlBase + "all", function(data) {
       $("#status").html("Loading, please wait...");
 
+      fields = data;
+
       $.each(data, function(index, field) {
+        if (field.type != "Section") {
+          fieldIds[field.name] = index;
+        }
+
         if (field.type == "Number") {
           addNumberField(field);
         } else if (field.type == "Boolean") {
@@ -53,6 +215,8 @@ $(document).ready(function() {
       });
 
       $("#status").html("Ready");
+
+      subscribe();
     })
     .fail(function(errorThrown) {
       console.log("error: " + errorThrown);
@@ -370,6 +534,10 @@ function addSectionField(field) {
 }
 
 function updateFieldValue(name, value) {
+  if (name == "pattern") {
+    refreshPatternParams();
+  }
+
   var group = $("#form-group-" + name);
 
   var type = group.attr("data-field-type");
@@ -393,6 +561,32 @@ function updateFieldValue(name, value) {
   }
 };
 
+// The param fields are the current pattern's settings, so their labels,
+// types and ranges change with the pattern (see PatternParams.h): get them
+// again and rebuild them in place.
+function refreshPatternParams() {
+  $.get(urlBase + "all", function(data) {
+    var previous = $("#form-group-section-params");
+
+    $.each(data, function(index, field) {
+      if (!/^param\d+$/.test(field.name)) return;
+
+      fields[index] = field;
+      $("#form-group-" + field.name).remove();
+
+      if (field.type == "Number") {
+        addNumberField(field);
+      } else if (field.type == "Boolean") {
+        addBooleanField(field);
+      } else {
+        return;
+      }
+
+      previous = $("#form-group-" + field.name).insertAfter(previous);
+    });
+  });
+}
+
 function setBooleanFieldValue(field, btnOn, btnOff, value) {
   field.value = value;
 
@@ -403,6 +597,11 @@ function setBooleanFieldValue(field, btnOn, btnOff, value) {
 }
 
 function postValue(name, value) {
+  if (sendField(name, value)) {
+    $("#status").html("Set " + name + ": " + value);
+    return;
+  }
+
   $("#status").html("Setting " + name + ": " + value + ", please wait...");
 
   var body = { name: name, value: value };
@@ -424,6 +623,11 @@ function delayPostValue(name, value) {
 }
 
 function postColor(name, value) {
+  if (sendField(name, value)) {
+    $("#status").html("Set " + name + ": " + value.r + "," + value.g + "," + value.b);
+    return;
+  }
+
   $("#status").html("Setting " + name + ": " + value.r + "," + value.g + "," + value.b + ", please wait...");
 
   var body = { name: name, r: value.r, g: value.g, b: value.b };
@@ -52,24 +52,30 @@ ws.debug = true;
 ws.onmessage = function(evt) {
   if(evt.data != null)
   {
+    // an array of every field that changed in a frame
     var data = JSON.parse(evt.data);
     if(data == null) return;
-    switch(data.name) {
-      case "power":
-        if(data.value == 1) {
-          $("#btnOn").attr("class", "btn btn-primary");
-          $("#btnOff").attr("class", "btn btn-default");
-        } else {
-          $("#btnOff").attr("class", "btn btn-primary");
-          $("#btnOn").attr("class", "btn btn-default");
-        }
-        break;
-
-      case "pattern":
-        $(".grid-item-pattern").attr("class", "grid-item-pattern btn btn-default");
-        $("#pattern-button-" + data.value).attr("class", "grid-item-pattern btn btn-primary");
-        break;
-    }
+    if(!Array.isArray(data)) data = [data];
+    data.forEach(updateField);
+  }
+}
+
+function updateField(data) {
+  switch(data.name) {
+    case "power":
+      if(data.value == 1) {
+        $("#btnOn").attr("class", "btn btn-primary");
+        $("#btnOff").attr("class", "btn btn-default");
+      } else {
+        $("#btnOff").attr("class", "btn btn-primary");
+        $("#btnOn").attr("class", "btn btn-default");
+      }
+      break;
+
+    case "pattern":
+      $(".grid-item-pattern").attr("class", "grid-item-pattern btn btn-default");
+      $("#pattern-button-" + data.value).attr("class", "grid-item-pattern btn btn-primary");
+      break;
   }
 }
 
@@ -19,6 +19,8 @@
 
 //#define FASTLED_ALLOW_INTERRUPTS 0
 #define FASTLED_INTERRUPT_RETRY_COUNT 0
+// patterns run on the shared clock from ClockSync.h
+#define USE_GET_MILLISECOND_TIMER
 #include <FastLED.h>
 FASTLED_USING_NAMESPACE
 
@@ -32,9 +34,11 @@ extern "C" {
 #include <ESP8266HTTPUpdateServer.h>
 #include <WebSocketsServer.h>
 #include <FS.h>
-#include <EEPROM.h>
+#include <WiFiUdp.h>
 //#include <IRremoteESP8266.h>
 #include "GradientPalettes.h"
+#include "JsonWriter.h"
+#include "Settings.h"
 
 #define ARRAY_SIZE(A) (sizeof(A) / sizeof((A)[0]))
 
@@ -60,6 +64,9 @@ ESP8266WebServer webServer(80);
 WebSocketsServer webSocketsServer = WebSocketsServer(81);
 ESP8266HTTPUpdateServer httpUpdateServer;
 
+#include "Trace.h"
+#include "Network.h"
+#include "Assets.h"
 #include "FSBrowser.h"
 
 #define DATA_PIN      D7
@@ -72,11 +79,6 @@ ESP8266HTTPUpdateServer httpUpdateServer;
 #define MILLI_AMPS         2000     // IMPORTANT: set the max milli-Amps of your power supply (4A = 4000mA)
 #define FRAMES_PER_SECOND  120 // here you can control the speed. With the Access Point / Web Server the animations run a bit slower.
 
-CRGB leds[NUM_LEDS];
-
-const uint8_t brightnessCount = 5;
-uint8_t brightnessMap[brightnessCount] = { 16, 32, 64, 128, 255 };
-uint8_t brightnessIndex = 0;
 ///////////////////////////
 //matrix
 ///////
@@ -84,26 +86,37 @@ const bool    kMatrixSerpentineLayout = false;
 const uint8_t kMatrixWidth = 38;
 const uint8_t kMatrixHeight = 8;
 #define MATRIX (kMatrixWidth * kMatrixHeight)
+
+// sized for the whole matrix: 1D patterns only draw the first NUM_LEDS,
+// but XY() and FastLED.show() address all MATRIX pixels
+CRGB leds[MATRIX];
+
+#define LAYOUT_MAX_LEDS MATRIX
+#include "Layout.h"
+
+const uint8_t brightnessCount = 5;
+uint8_t brightnessMap[brightnessCount] = { 16, 32, 64, 128, 255 };
+uint8_t brightnessIndex = 0;
+
+// LED index of every matrix cell, built from the layout at boot
+uint16_t xyMap[MATRIX];
+
 uint16_t XY( uint8_t x, uint8_t y)
 {
-  uint16_t i;
-  
-  if( kMatrixSerpentineLayout == false) {
-    i = (y * kMatrixWidth) + x;
+  return xyMap[(y * kMatrixWidth) + x];
+}
+
+// Cells the layout doesn't cover keep their row-major index.
+void initializeXY()
+{
+  for (uint16_t i = 0; i < MATRIX; i++) {
+    xyMap[i] = i;
   }
 
-  if( kMatrixSerpentineLayout == true) {
-    if( y & 0x01) {
-      // Odd rows run backwards
-      uint8_t reverseX = (kMatrixWidth - 1) - x;
-      i = (y * kMatrixWidth) + reverseX;
-    } else {
-      // Even rows run forwards
-      i = (y * kMatrixWidth) + x;
-    }
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    if (layoutX[i] < kMatrixWidth && layoutY[i] < kMatrixHeight)
+      xyMap[(layoutY[i] * kMatrixWidth) + layoutX[i]] = i;
   }
-  
-  return i;
 }
 
 
@@ -203,6 +216,12 @@ typedef PatternAndName PatternAndNameList[];
 #include "Noise.h"
 #include "Effects.h"
 #include "Audio.h"
+#include "NoiseVariants.h"
+#include "AudioSync.h"
+#include "ClockSync.h"
+#include "Fire.h"
+#include "Particles.h"
+#include "ParticlePatterns.h"
 
 
 
@@ -234,6 +253,7 @@ PatternAndNameList patterns = {
  
  
  {  audioFire,                   "audioFire" },
+ {  audioFire2D,                   "audioFire2D" },
   {  rainbowAudioNoise,                   "rainbowAudioNoise" },
   {  rainbowStripeAudioNoise,                   "rainbowStripeAudioNoise" },
   {  partyAudioNoise,                   "partyAudioNoise" },
@@ -274,6 +294,13 @@ PatternAndNameList patterns = {
   { sinelon,                "Sinelon" },
   { bpm,                    "Beat" },
   { juggle,                 "Juggle" },
+  { radialPaletteShift,     "Radial Palette Shift" },
+  { rotatingPalette,        "Rotating Palette" },
+
+  // particle patterns
+  { particleFountain,       "Particle Fountain" },
+  { particleSparks,         "Particle Sparks" },
+  { particleConfetti,       "Particle Confetti" },
 
 
   { showSolidColor,         "Solid Color" }
@@ -281,6 +308,14 @@ PatternAndNameList patterns = {
 const uint8_t patternCount = ARRAY_SIZE(patterns);
 
 #include "Fields.h"
+#include "Preview.h"
+#include "Telemetry.h"
+#include "Metrics.h"
+#include "Bench.h"
+#include "CommandQueue.h"
+#include "Protocol.h"
+#include "PatternParams.h"
+#include "Scenes.h"
 
 void setup() {
   WiFi.setSleepMode(WIFI_NONE_SLEEP);
@@ -300,8 +335,10 @@ void setup() {
   fill_solid(leds, NUM_LEDS, CRGB::Black);
   FastLED.show();
 
-  EEPROM.begin(512);
-  //loadSettings();
+  if (beginSettings())
+    loadSettings();
+  else
+    storeSettings();
 
   FastLED.setBrightness(brightness);
 
@@ -328,6 +365,15 @@ void setup() {
     }
     Serial.printf("\n");
   }
+  buildAssetIndex();
+
+  if (!loadLayout("/layout.bin")) {
+    layoutFromGrid(kMatrixWidth, kMatrixHeight, kMatrixSerpentineLayout);
+  }
+  initializeXY();
+  loadNoiseVariants("/noise.bin");
+  loadPatternParams();
+  loadScenes();
 
   // Set Hostname.
   String hostname(HOSTNAME);
@@ -383,100 +429,41 @@ void setup() {
 
   httpUpdateServer.setup(&webServer);
 
+  // for the asset ETags
+  const char* headerKeys[] = { "If-None-Match" };
+  webServer.collectHeaders(headerKeys, 1);
+
   webServer.on("/all", HTTP_GET, []() {
-    String json = getFieldsJson(fields, fieldCount);
-    webServer.send(200, "text/json", json);
+    JsonWriter json(webServer);
+    json.begin("text/json");
+    writeFieldsJson(json, fields, fieldCount);
+    json.end();
+    Serial.printf("/all: %u bytes, free heap low %u\n", (unsigned) json.length, json.minFreeHeap);
   });
 
   webServer.on("/fieldValue", HTTP_GET, []() {
-    String name = webServer.arg("name");
-    String value = getFieldValue(name, fields, fieldCount);
+    uint8_t id = findField(webServer.arg("name").c_str());
+    if (id >= fieldCount) {
+      webServer.send(404, "text/plain", "FieldNotFound");
+      return;
+    }
+    char value[12];
+    formatFieldValue(value, sizeof(value), fields[id]);
     webServer.send(200, "text/json", value);
   });
 
   webServer.on("/fieldValue", HTTP_POST, []() {
-    String name = webServer.arg("name");
-    String value = webServer.arg("value");
-    String newValue = setFieldValue(name, value, fields, fieldCount);
-    webServer.send(200, "text/json", newValue);
-  });
-
-  webServer.on("/power", HTTP_POST, []() {
-    String value = webServer.arg("value");
-    setPower(value.toInt());
-    sendInt(power);
-  });
-
-  webServer.on("/cooling", HTTP_POST, []() {
-    String value = webServer.arg("value");
-    cooling = value.toInt();
-    broadcastInt("cooling", cooling);
-    sendInt(cooling);
-  });
-
-  webServer.on("/sparking", HTTP_POST, []() {
-    String value = webServer.arg("value");
-    sparking = value.toInt();
-    broadcastInt("sparking", sparking);
-    sendInt(sparking);
-  });
-
-  webServer.on("/speed", HTTP_POST, []() {
-    String value = webServer.arg("value");
-    speed = value.toInt();
-    broadcastInt("speed", speed);
-    sendInt(speed);
+    handleFieldPost(findField(webServer.arg("name").c_str()), "text/json");
   });
 
-//webServer.on("/speedx", HTTP_POST, []() {
-//    String value = webServer.arg("value");
-//    speed = value.toInt();
-//    broadcastInt("speedx", speedx);
-//    sendInt(speedx);
-//  });
-//  webServer.on("/speedy", HTTP_POST, []() {
-//    String value = webServer.arg("value");
-//    speed = value.toInt();
-//    broadcastInt("speedy", speedy);
-//    sendInt(speedy);
-//  });
-//  webServer.on("/speedz", HTTP_POST, []() {
-//    String value = webServer.arg("value");
-//    speed = value.toInt();
-//    broadcastInt("speedz", speedz);
-//    sendInt(speedz);
-//  });
-  webServer.on("/twinkleSpeed", HTTP_POST, []() {
-    String value = webServer.arg("value");
-    twinkleSpeed = value.toInt();
-    if (twinkleSpeed < 0) twinkleSpeed = 0;
-    else if (twinkleSpeed > 8) twinkleSpeed = 8;
-    broadcastInt("twinkleSpeed", twinkleSpeed);
-    sendInt(twinkleSpeed);
-  });
-
-  webServer.on("/twinkleDensity", HTTP_POST, []() {
-    String value = webServer.arg("value");
-    twinkleDensity = value.toInt();
-    if (twinkleDensity < 0) twinkleDensity = 0;
-    else if (twinkleDensity > 8) twinkleDensity = 8;
-    broadcastInt("twinkleDensity", twinkleDensity);
-    sendInt(twinkleDensity);
-  });
-
-  webServer.on("/solidColor", HTTP_POST, []() {
-    String r = webServer.arg("r");
-    String g = webServer.arg("g");
-    String b = webServer.arg("b");
-    setSolidColor(r.toInt(), g.toInt(), b.toInt());
-    sendString(String(solidColor.r) + "," + String(solidColor.g) + "," + String(solidColor.b));
-  });
-
-  webServer.on("/pattern", HTTP_POST, []() {
-    String value = webServer.arg("value");
-    setPattern(value.toInt());
-    sendInt(currentPatternIndex);
-  });
+  // POST /<field name>?value=n, or ?r=&g=&b= for a color, for every field
+  for (uint8_t i = 0; i < fieldCount; i++) {
+    if (fields[i].set) {
+      webServer.on(("/" + fields[i].name).c_str(), HTTP_POST, [i]() {
+        handleFieldPost(i, "text/plain");
+      });
+    }
+  }
 
   webServer.on("/patternName", HTTP_POST, []() {
     String value = webServer.arg("value");
@@ -484,35 +471,16 @@ void setup() {
     sendInt(currentPatternIndex);
   });
 
-  webServer.on("/palette", HTTP_POST, []() {
-    String value = webServer.arg("value");
-    setPalette(value.toInt());
-    sendInt(currentPaletteIndex);
-  });
-
   webServer.on("/paletteName", HTTP_POST, []() {
     String value = webServer.arg("value");
     setPaletteName(value);
     sendInt(currentPaletteIndex);
   });
 
-  webServer.on("/brightness", HTTP_POST, []() {
-    String value = webServer.arg("value");
-    setBrightness(value.toInt());
-    sendInt(brightness);
-  });
-
-  webServer.on("/autoplay", HTTP_POST, []() {
-    String value = webServer.arg("value");
-    setAutoplay(value.toInt());
-    sendInt(autoplay);
-  });
-
-  webServer.on("/autoplayDuration", HTTP_POST, []() {
-    String value = webServer.arg("value");
-    setAutoplayDuration(value.toInt());
-    sendInt(autoplayDuration);
-  });
+  webServer.on("/metrics", HTTP_GET, handleMetrics);
+  webServer.on("/trace", HTTP_GET, handleTrace);
+  webServer.on("/bench", HTTP_GET, handleBench);
+  webServer.on("/scenes", HTTP_GET, handleSceneList);
 
   //list directory
   webServer.on("/list", HTTP_GET, handleFileList);
@@ -530,7 +498,11 @@ void setup() {
     webServer.send(200, "text/plain", "");
   }, handleFileUpload);
 
-  webServer.serveStatic("/", SPIFFS, "/", "max-age=86400");
+  // static files, sent over the next frames by handleNetwork()
+  webServer.onNotFound([]() {
+    if (webServer.method() != HTTP_GET || !handleFileRead(webServer.uri(), "max-age=86400"))
+      webServer.send(404, "text/plain", "FileNotFound");
+  });
 
   webServer.begin();
   Serial.println("HTTP web server started");
@@ -542,34 +514,77 @@ void setup() {
   autoPlayTimeout = millis() + (autoplayDuration * 1000);
 }
 
-void sendInt(uint8_t value)
+// Queue the posted value, to be applied next frame (see CommandQueue.h),
+// and reply with it.
+void handleFieldPost(uint8_t id, const char* contentType)
 {
-  sendString(String(value));
-}
+  if (id >= fieldCount || !fields[id].set) {
+    webServer.send(404, "text/plain", "FieldNotFound");
+    return;
+  }
 
-void sendString(String value)
-{
-  webServer.send(200, "text/plain", value);
+  const Field& field = fields[id];
+
+  uint8_t value[3];
+  if (field.type == ColorFieldType) {
+    if (webServer.hasArg("value")) {
+      unsigned int r = 0, g = 0, b = 0;
+      sscanf(webServer.arg("value").c_str(), "%u,%u,%u", &r, &g, &b);
+      value[0] = min(r, 255u);
+      value[1] = min(g, 255u);
+      value[2] = min(b, 255u);
+    }
+    else {
+      value[0] = constrain(webServer.arg("r").toInt(), 0, 255);
+      value[1] = constrain(webServer.arg("g").toInt(), 0, 255);
+      value[2] = constrain(webServer.arg("b").toInt(), 0, 255);
+    }
+  }
+  else {
+    value[0] = constrain(webServer.arg("value").toInt(), 0, 255);
+  }
+
+  clampFieldValue(field, value);
+  if (!postCommand(id, value)) {
+    webServer.send(503, "text/plain", "Busy");
+    return;
+  }
+
+  char text[12];
+  formatFieldValue(text, sizeof(text), field, value);
+  webServer.send(200, contentType, text);
 }
 
-void broadcastInt(String name, uint8_t value)
+void sendInt(uint8_t value)
 {
-  String json = "{\"name\":\"" + name + "\",\"value\":" + String(value) + "}";
-  webSocketsServer.broadcastTXT(json);
+  sendString(String(value));
 }
 
-void broadcastString(String name, String value)
+void sendString(String value)
 {
-  String json = "{\"name\":\"" + name + "\",\"value\":\"" + String(value) + "\"}";
-  webSocketsServer.broadcastTXT(json);
+  webServer.send(200, "text/plain", value);
 }
 
 void loop() {
+  beginFrame();
   currentMillis = millis(); // save the current timer value
 
   // analyze the audio input
 
-  readAudio();
+  if (audioSyncMode == AudioSyncSlave) {
+    TRACE_SCOPE("receiveAudioSync");
+    receiveAudioSync();
+  }
+  else {
+    TRACE_SCOPE("readAudio");
+    readAudio();
+    audioBeat = beatDetect();
+    if (audioSyncMode == AudioSyncMaster)
+      sendAudioSync();
+  }
+  recordTelemetry();
+  endPhase(PhaseAudio);
+
   uint32_t ms = millis();
   int32_t yHueDelta32 = ((int32_t)cos16( ms * 27 ) * (350 / kMatrixWidth));
   int32_t xHueDelta32 = ((int32_t)cos16( ms * 39 ) * (310 / kMatrixHeight));
@@ -577,43 +592,69 @@ void loop() {
   // Add entropy to random number generator; we use a lot of it.
   random16_add_entropy(analogRead(MSGEQ7_AUDIO_PIN));
 
-  webSocketsServer.loop();
-  webServer.handleClient();
+  // WebSocket, HTTP and file transfers, within the frame's network budget
+  handleNetwork();
+  handleClockSync();
+  handleSettings();
+
+  // what the web server and WebSocket posted, then one broadcast of it all
+  TRACE_BEGIN("commands");
+  applyCommands();
+  sendBroadcasts();
+  TRACE_END();
+  endPhase(PhaseNetwork);
 
   //  handleIrInput();
 
   if (power == 0) {
-    fill_solid(leds, NUM_LEDS, CRGB::Black);
+    fill_solid(leds, MATRIX, CRGB::Black);
+    TRACE_BEGIN("show");
     FastLED.show();
+    TRACE_END();
+    endPhase(PhaseShow);
+    sendPreview();
+    endPhase(PhaseNetwork);
     // FastLED.delay(15);
     return;
   }
 
-  // EVERY_N_SECONDS(10) {
-  //   Serial.print( F("Heap: ") ); Serial.println(system_get_free_heap_size());
-  // }
-
-  // change to a new cpt-city gradient palette
-  EVERY_N_SECONDS( secondsPerPalette ) {
-    gCurrentPaletteNumber = addmod8( gCurrentPaletteNumber, 1, gGradientPaletteCount);
+  // change to a new cpt-city gradient palette, counted on the shared clock
+  // so that nodes change together
+  uint8_t paletteNumber = (clockMillis() / 1000 / secondsPerPalette) % gGradientPaletteCount;
+  if (paletteNumber != gCurrentPaletteNumber) {
+    gCurrentPaletteNumber = paletteNumber;
     gTargetPalette = gGradientPalettes[ gCurrentPaletteNumber ];
   }
 
   EVERY_N_MILLISECONDS(40) {
     // slowly blend the current palette to the next
     nblendPaletteTowardPalette( gCurrentPalette, gTargetPalette, 8);
-    gHue++;  // slowly cycle the "base color" through the rainbow
   }
 
-  if (autoplay && (millis() > autoPlayTimeout)) {
-    adjustPattern(true);
-    autoPlayTimeout = millis() + (autoplayDuration * 1000);
-  }
+  gHue = clockMillis() / 40;  // slowly cycle the "base color" through the rainbow
+
+  // autoplay: the next scene of the playlist, when it's time
+  handleScenes();
+
+  // the new pattern's params, if it has changed
+  handlePatternParams();
 
   // Call the current pattern function once, updating the 'leds' array
+  TRACE_BEGIN(patterns[currentPatternIndex].name.c_str());
   patterns[currentPatternIndex].pattern();
+  TRACE_END();
+  endPhase(PhasePattern);
 
+  TRACE_BEGIN("show");
   FastLED.show();
+  TRACE_END();
+  endPhase(PhaseShow);
+
+  // stream the frame to any web app that is watching
+  TRACE_BEGIN("sendPreview");
+  sendPreview();
+  TRACE_END();
+  endPhase(PhaseNetwork);
 
   // insert a delay to keep the framerate modest
   // FastLED.delay(1000 / FRAMES_PER_SECOND);
@@ -624,12 +665,14 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length
   switch (type) {
     case WStype_DISCONNECTED:
       Serial.printf("[%u] Disconnected!\n", num);
+      handleProtocolDisconnect(num);
       break;
 
     case WStype_CONNECTED:
       {
         IPAddress ip = webSocketsServer.remoteIP(num);
         Serial.printf("[%u] Connected from %d.%d.%d.%d url: %s\n", num, ip[0], ip[1], ip[2], ip[3], payload);
+        handleProtocolConnect(num);
 
         // send message to client
         // webSocketsServer.sendTXT(num, "Connected");
@@ -647,11 +690,7 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length
       break;
 
     case WStype_BIN:
-      Serial.printf("[%u] get binary length: %u\n", num, length);
-      hexdump(payload, length);
-
-      // send message to client
-      // webSocketsServer.sendBIN(num, payload, lenght);
+      handleProtocolMessage(num, payload, length);
       break;
   }
 }
@@ -865,17 +904,21 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length
 
 void loadSettings()
 {
-  brightness = EEPROM.read(0);
+  // the brightness can't be set to 0, so a record with it, and power 0, is
+  // one of zeros written before storeSettings(): it would boot dark
+  bool zeroed = readSetting(0) == 0;
+  if (!zeroed)
+    brightness = readSetting(0);
 
-  currentPatternIndex = EEPROM.read(1);
+  currentPatternIndex = readSetting(1);
   if (currentPatternIndex < 0)
     currentPatternIndex = 0;
   else if (currentPatternIndex >= patternCount)
     currentPatternIndex = patternCount - 1;
 
-  byte r = EEPROM.read(2);
-  byte g = EEPROM.read(3);
-  byte b = EEPROM.read(4);
+  byte r = readSetting(2);
+  byte g = readSetting(3);
+  byte b = readSetting(4);
 
   if (r == 0 && g == 0 && b == 0)
   {
@@ -885,48 +928,80 @@ void loadSettings()
     solidColor = CRGB(r, g, b);
   }
 
-  power = EEPROM.read(5);
+  if (!zeroed || readSetting(5) != 0)
+    power = readSetting(5);
+
+  autoplay = readSetting(6);
 
-  autoplay = EEPROM.read(6);
-  autoplayDuration = EEPROM.read(7);
+  // 0 would move autoplay on every frame
+  if (readSetting(7) != 0)
+    autoplayDuration = readSetting(7);
 
-  currentPaletteIndex = EEPROM.read(8);
+  currentPaletteIndex = readSetting(8);
   if (currentPaletteIndex < 0)
     currentPaletteIndex = 0;
   else if (currentPaletteIndex >= paletteCount)
     currentPaletteIndex = paletteCount - 1;
+
+  noiseFloor = readSetting(9);
+
+  // 0 would freeze the AGC
+  agcSmoothThousandths = readSetting(10);
+  if (agcSmoothThousandths == 0)
+    agcSmoothThousandths = AGCSMOOTH * 1000;
+  agcSmooth = agcSmoothThousandths / 1000.0;
+
+  audioSyncMode = readSetting(11);
+  if (audioSyncMode >= AudioSyncModeCount)
+    audioSyncMode = AudioSyncOff;
+}
+
+// Fill settings[] with the current values, for a device without a record:
+// otherwise the first writeSetting() would save them all as 0 but its own.
+void storeSettings()
+{
+  settings[0] = brightness;
+  settings[1] = currentPatternIndex;
+  settings[2] = solidColor.r;
+  settings[3] = solidColor.g;
+  settings[4] = solidColor.b;
+  settings[5] = power;
+  settings[6] = autoplay;
+  settings[7] = autoplayDuration;
+  settings[8] = currentPaletteIndex;
+  settings[9] = noiseFloor;
+  settings[10] = agcSmoothThousandths;
+  settings[11] = audioSyncMode;
 }
 
 void setPower(uint8_t value)
 {
   power = value == 0 ? 0 : 1;
 
-  EEPROM.write(5, power);
-  EEPROM.commit();
+  writeSetting(5, power);
 
-  broadcastInt("power", power);
+  broadcastField(PowerField);
 }
 
 void setAutoplay(uint8_t value)
 {
   autoplay = value == 0 ? 0 : 1;
 
-  EEPROM.write(6, autoplay);
-  EEPROM.commit();
+  writeSetting(6, autoplay);
 
-  broadcastInt("autoplay", autoplay);
+  broadcastField(AutoplayField);
 }
 
 void setAutoplayDuration(uint8_t value)
 {
-  autoplayDuration = value;
+  // 0 would move autoplay on every frame
+  autoplayDuration = max(value, (uint8_t) 1);
 
-  EEPROM.write(7, autoplayDuration);
-  EEPROM.commit();
+  writeSetting(7, autoplayDuration);
 
   autoPlayTimeout = millis() + (autoplayDuration * 1000);
 
-  broadcastInt("autoplayDuration", autoplayDuration);
+  broadcastField(AutoplayDurationField);
 }
 
 void setSolidColor(CRGB color)
@@ -938,14 +1013,13 @@ void setSolidColor(uint8_t r, uint8_t g, uint8_t b)
 {
   solidColor = CRGB(r, g, b);
 
-  EEPROM.write(2, r);
-  EEPROM.write(3, g);
-  EEPROM.write(4, b);
-  EEPROM.commit();
+  writeSetting(2, r);
+  writeSetting(3, g);
+  writeSetting(4, b);
 
   setPattern(patternCount - 1);
 
-  broadcastString("color", String(solidColor.r) + "," + String(solidColor.g) + "," + String(solidColor.b));
+  broadcastField(SolidColorField);
 }
 
 // increase or decrease the current pattern number, and wrap around at the ends
@@ -963,11 +1037,10 @@ void adjustPattern(bool up)
     currentPatternIndex = 0;
 
   if (autoplay == 0) {
-    EEPROM.write(1, currentPatternIndex);
-    EEPROM.commit();
+    writeSetting(1, currentPatternIndex);
   }
 
-  broadcastInt("pattern", currentPatternIndex);
+  broadcastField(PatternField);
 }
 
 void setPattern(uint8_t value)
@@ -978,11 +1051,10 @@ void setPattern(uint8_t value)
   currentPatternIndex = value;
 
   if (autoplay == 0) {
-    EEPROM.write(1, currentPatternIndex);
-    EEPROM.commit();
+    writeSetting(1, currentPatternIndex);
   }
 
-  broadcastInt("pattern", currentPatternIndex);
+  broadcastField(PatternField);
 }
 
 void setPatternName(String name)
@@ -1002,10 +1074,9 @@ void setPalette(uint8_t value)
 
   currentPaletteIndex = value;
 
-  EEPROM.write(8, currentPaletteIndex);
-  EEPROM.commit();
+  writeSetting(8, currentPaletteIndex);
 
-  broadcastInt("palette", currentPaletteIndex);
+  broadcastField(PaletteField);
 }
 
 void setPaletteName(String name)
@@ -1029,10 +1100,9 @@ void adjustBrightness(bool up)
 
   FastLED.setBrightness(brightness);
 
-  EEPROM.write(0, brightness);
-  EEPROM.commit();
+  writeSetting(0, brightness);
 
-  broadcastInt("brightness", brightness);
+  broadcastField(BrightnessField);
 }
 
 void setBrightness(uint8_t value)
@@ -1045,10 +1115,95 @@ void setBrightness(uint8_t value)
 
   FastLED.setBrightness(brightness);
 
-  EEPROM.write(0, brightness);
-  EEPROM.commit();
+  writeSetting(0, brightness);
+
+  broadcastField(BrightnessField);
+}
+
+void setSpeed(uint8_t value)
+{
+  speed = value;
+
+  broadcastField(SpeedField);
+}
+
+void setCooling(uint8_t value)
+{
+  cooling = value;
+
+  broadcastField(CoolingField);
+}
+
+void setSparking(uint8_t value)
+{
+  sparking = value;
+
+  broadcastField(SparkingField);
+}
+
+void setTwinkleSpeed(uint8_t value)
+{
+  twinkleSpeed = value > 8 ? 8 : value;
+
+  broadcastField(TwinkleSpeedField);
+}
+
+void setTwinkleDensity(uint8_t value)
+{
+  twinkleDensity = value > 8 ? 8 : value;
+
+  broadcastField(TwinkleDensityField);
+}
+
+void setNoiseFloor(uint8_t value)
+{
+  noiseFloor = value;
+
+  writeSetting(9, noiseFloor);
+
+  broadcastField(NoiseFloorField);
+}
+
+void setAgcSmooth(uint8_t value)
+{
+  agcSmoothThousandths = value == 0 ? 1 : value;
+  agcSmooth = agcSmoothThousandths / 1000.0;
+
+  writeSetting(10, agcSmoothThousandths);
+
+  broadcastField(AgcSmoothField);
+}
+
+void setAudioSync(uint8_t value)
+{
+  if (value >= AudioSyncModeCount)
+    value = AudioSyncModeCount - 1;
+
+  audioSyncMode = value;
+
+  // now rather than from loop(), which only calls it for Master and Slave:
+  // switching to Off has to close the socket too, or a Slave's stays in the
+  // multicast group with packets piling up in lwIP
+  startAudioSync();
+
+  writeSetting(11, audioSyncMode);
 
-  broadcastInt("brightness", brightness);
+  broadcastField(AudioSyncField);
+}
+
+// slot is which of the current pattern's params, see PatternParams.h
+void setPatternParam(uint8_t slot, uint8_t value)
+{
+  // until handlePatternParams() has caught up with a new pattern, the slots
+  // are still the old one's
+  if (slot >= paramSlotCount || paramsPatternIndex != currentPatternIndex)
+    return;
+
+  *paramInfo[paramSlots[slot]].value = value;
+
+  storePatternParam(paramSlots[slot], value);
+
+  broadcastField(Param0Field + slot);
 }
 
 void strandTest()
@@ -1138,7 +1293,7 @@ void juggle()
   static uint8_t   basebeat =   5; // Higher = faster movement.
 
   static uint8_t lastSecond =  99;  // Static variable, means it's only defined once. This is our 'debounce' variable.
-  uint8_t secondHand = (millis() / 1000) % 30; // IMPORTANT!!! Change '30' to a different value to change duration of the loop.
+  uint8_t secondHand = (GET_MILLIS() / 1000) % 30; // IMPORTANT!!! Change '30' to a different value to change duration of the loop.
 
   if (lastSecond != secondHand) { // Debounce to make sure we're not repeating an assignment.
     lastSecond = secondHand;
@@ -1208,10 +1363,19 @@ void pride()
 
 void radialPaletteShift()
 {
-  for (uint8_t i = 0; i < NUM_LEDS; i++) {
+  for (uint16_t i = 0; i < layoutCount; i++) {
     // leds[i] = ColorFromPalette( gCurrentPalette, gHue + sin8(i*16), brightness);
-    leds[i] = ColorFromPalette(gCurrentPalette, i + gHue, 255, LINEARBLEND);
+    leds[i] = ColorFromPalette(gCurrentPalette, layoutRadius[i] + gHue, 255, LINEARBLEND);
+  }
+  layoutClearRest(leds, MATRIX);
+}
+
+void rotatingPalette()
+{
+  for (uint16_t i = 0; i < layoutCount; i++) {
+    leds[i] = ColorFromPalette(gCurrentPalette, layoutAngle[i] + beat8(speed));
   }
+  layoutClearRest(leds, MATRIX);
 }
 
 // based on FastLED example Fire2012WithPalette: https://github.com/FastLED/FastLED/blob/master/examples/Fire2012WithPalette/Fire2012WithPalette.ino
@@ -0,0 +1,155 @@
+// Host stand-in for the MSGEQ7 seven band graphic equalizer, and the audio
+// that feeds it.
+//
+// The sketches read the chip the way its data sheet says: a pulse on RESET,
+// then for each band STROBE low, analogRead(), STROBE high.  Msgeq7 watches
+// those pins through hostDigitalWriteHook and answers every analogRead()
+// with the band the last falling edge of STROBE selected (the bloom sketch
+// reads two chips, left and right, and both get the same levels).
+//
+// Levels are what analogRead() returns, 0-1023, one set per frame, from an
+// AudioSource:
+//
+//   BeatAudio      a made up 120 bpm beat: a kick in the bass bands, a snare
+//                  on the off beats, hats on the eighths, over a noise floor
+//   ReplayAudio    a text file of seven levels per line, one line a frame,
+//                  played in a loop: the raw analogRead() values, before
+//                  the noise floor and AGC
+//   SilentAudio    nothing but 0
+//   WavAudio       a WAV file, through a model of the chip (WavAudio.h)
+
+#pragma once
+
+#include <Arduino.h>
+
+#include <cstdio>
+#include <cstring>
+
+#define MSGEQ7_BANDS 7
+
+class AudioSource {
+  public:
+    virtual ~AudioSource() {}
+    // Fill in the next frame's levels.  Returns false once there are no
+    // more.
+    virtual bool next(uint16_t levels[MSGEQ7_BANDS]) = 0;
+};
+
+class SilentAudio : public AudioSource {
+  public:
+    bool next(uint16_t levels[MSGEQ7_BANDS]) override
+    {
+      memset(levels, 0, MSGEQ7_BANDS * sizeof(uint16_t));
+      return true;
+    }
+};
+
+class BeatAudio : public AudioSource {
+  public:
+    BeatAudio(int fps, int bpm = 120) : fps(fps), bpm(bpm) {}
+
+    bool next(uint16_t levels[MSGEQ7_BANDS]) override
+    {
+      // time within the beat, 0-999
+      uint32_t beat = (uint32_t) ((uint64_t) frame * bpm * 1000 / (60 * fps)) % 1000;
+      uint32_t count = (uint32_t) ((uint64_t) frame * bpm / (60 * fps));
+      frame++;
+
+      uint16_t kick = decay(beat, 900, 250);
+      uint16_t snare = count % 2 ? decay(beat, 700, 180) : 0;
+      uint16_t hats = decay(beat % 500, 500, 80);
+
+      const uint16_t kickBands[MSGEQ7_BANDS] = { 100, 80, 25, 5, 0, 0, 0 };
+      const uint16_t snareBands[MSGEQ7_BANDS] = { 10, 25, 70, 100, 60, 30, 10 };
+      const uint16_t hatBands[MSGEQ7_BANDS] = { 0, 0, 0, 10, 40, 90, 100 };
+
+      for (uint8_t i = 0; i < MSGEQ7_BANDS; i++) {
+        uint32_t level = 90 + noise() % 40;
+        level += (kick * kickBands[i] + snare * snareBands[i] + hats * hatBands[i]) / 100;
+        levels[i] = level > 1023 ? 1023 : level;
+      }
+      return true;
+    }
+
+  private:
+    int fps;
+    int bpm;
+    uint32_t frame = 0;
+    uint32_t seed = 1;
+
+    // peak at the start of the beat, down to 0 after length ms-ish
+    static uint16_t decay(uint32_t beat, uint16_t peak, uint16_t length)
+    {
+      return beat >= length ? 0 : peak * (length - beat) / length;
+    }
+
+    uint32_t noise()
+    {
+      seed = seed * 1103515245 + 12345;
+      return seed >> 16;
+    }
+};
+
+class ReplayAudio : public AudioSource {
+  public:
+    ReplayAudio(const char* path) : file(fopen(path, "r")) {}
+    ~ReplayAudio() { if (file) fclose(file); }
+
+    bool ok() const { return file != NULL; }
+
+    bool next(uint16_t levels[MSGEQ7_BANDS]) override
+    {
+      for (int attempt = 0; attempt < 2; attempt++) {
+        unsigned int v[MSGEQ7_BANDS];
+        char line[128];
+        while (fgets(line, sizeof(line), file)) {
+          if (sscanf(line, "%u %u %u %u %u %u %u", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]) == MSGEQ7_BANDS) {
+            for (uint8_t i = 0; i < MSGEQ7_BANDS; i++)
+              levels[i] = v[i] > 1023 ? 1023 : v[i];
+            return true;
+          }
+        }
+        rewind(file); // from the top
+      }
+      return false;
+    }
+
+  private:
+    FILE* file;
+};
+
+class Msgeq7 {
+  public:
+    Msgeq7(uint8_t strobePin, uint8_t resetPin) : strobePin(strobePin), resetPin(resetPin) {}
+
+    void attach()
+    {
+      hostDigitalWriteHook = [this](uint8_t pin, uint8_t value) { write(pin, value); };
+      hostAnalogReadHook = [this](uint8_t pin) { return (int) levels[band < 0 ? 0 : band]; };
+    }
+
+    void setLevels(const uint16_t next[MSGEQ7_BANDS])
+    {
+      memcpy(levels, next, sizeof(levels));
+    }
+
+  private:
+    uint8_t strobePin;
+    uint8_t resetPin;
+    bool strobe = false;
+    int8_t band = -1; // none selected since the reset
+    uint16_t levels[MSGEQ7_BANDS] = {};
+
+    void write(uint8_t pin, uint8_t value)
+    {
+      if (pin == resetPin && value == HIGH) {
+        band = -1;
+      }
+      else if (pin == strobePin) {
+        // each falling edge moves the output on to the next band
+        if (strobe && value == LOW)
+          band = (band + 1) % MSGEQ7_BANDS;
+        strobe = value == HIGH;
+      }
+    }
+};
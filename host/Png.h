@@ -0,0 +1,105 @@
+// Writes a frame of LEDs as a PNG, one pixel an LED, in a row; for the host
+// runner's --png.  The image data is stored, not compressed, so there is
+// nothing to link: a strip of 300 LEDs is under a kB either way.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+class PngWriter {
+  public:
+    // rows copies of the strip, one under another, to make it easier to see
+    static bool write(const char* path, const uint8_t* rgb, uint32_t width, uint32_t rows)
+    {
+      // each row: filter type 0, then the pixels
+      std::vector<uint8_t> raw;
+      raw.reserve((width * 3 + 1) * rows);
+      for (uint32_t y = 0; y < rows; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb, rgb + width * 3);
+      }
+
+      // zlib stream of stored deflate blocks
+      std::vector<uint8_t> zlib = { 0x78, 0x01 };
+      for (size_t offset = 0; offset < raw.size() || offset == 0; offset += 65535) {
+        uint16_t length = raw.size() - offset > 65535 ? 65535 : raw.size() - offset;
+        bool last = offset + length >= raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(length & 0xFF);
+        zlib.push_back(length >> 8);
+        zlib.push_back(~length & 0xFF);
+        zlib.push_back((~length >> 8) & 0xFF);
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+        if (last)
+          break;
+      }
+      uint32_t adler = adler32(raw.data(), raw.size());
+      for (int shift = 24; shift >= 0; shift -= 8)
+        zlib.push_back(adler >> shift);
+
+      FILE* file = fopen(path, "wb");
+      if (!file)
+        return false;
+
+      static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+      fwrite(signature, 1, sizeof(signature), file);
+
+      uint8_t header[13] = {};
+      bigEndian(header, width);
+      bigEndian(header + 4, rows);
+      header[8] = 8; // bits per channel
+      header[9] = 2; // RGB
+      chunk(file, "IHDR", header, sizeof(header));
+      chunk(file, "IDAT", zlib.data(), zlib.size());
+      chunk(file, "IEND", NULL, 0);
+
+      return fclose(file) == 0;
+    }
+
+  private:
+    static void bigEndian(uint8_t* bytes, uint32_t value)
+    {
+      bytes[0] = value >> 24;
+      bytes[1] = value >> 16;
+      bytes[2] = value >> 8;
+      bytes[3] = value;
+    }
+
+    static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t length)
+    {
+      crc = ~crc;
+      for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+          crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+      }
+      return ~crc;
+    }
+
+    static uint32_t adler32(const uint8_t* data, size_t length)
+    {
+      uint32_t a = 1, b = 0;
+      for (size_t i = 0; i < length; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+      }
+      return (b << 16) | a;
+    }
+
+    static void chunk(FILE* file, const char* type, const uint8_t* data, uint32_t length)
+    {
+      uint8_t bytes[4];
+      bigEndian(bytes, length);
+      fwrite(bytes, 1, 4, file);
+      fwrite(type, 1, 4, file);
+      if (length)
+        fwrite(data, 1, length, file);
+
+      uint32_t crc = crc32(0, (const uint8_t*) type, 4);
+      crc = crc32(crc, data, length);
+      bigEndian(bytes, crc);
+      fwrite(bytes, 1, 4, file);
+    }
+};
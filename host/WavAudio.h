@@ -0,0 +1,206 @@
+// A model of the MSGEQ7 listening to a WAV file, for the host runner.
+//
+// The chip splits its input into seven bands, 63, 160, 400, 1k, 2.5k, 6.25k
+// and 16k Hz, each a bandpass filter followed by a peak detector, and puts
+// the peaks out one at a time through the multiplexer that RESET and STROBE
+// step through (see Msgeq7.h).  Here each band is a second order bandpass
+// (the RBJ cookbook's, 0 dB at the centre) with the chip's Q, and each peak
+// detector rises at once and falls off with a time constant.  A frame's
+// levels are the peaks at the end of that frame's samples, on the chip's DC
+// offset, scaled so a full scale sine at a band's centre reads 1023.
+//
+// The file is read a frame's worth of samples at a time, so a DJ set
+// doesn't have to fit in memory, and the filters are cheap enough that it
+// renders a lot faster than it plays.  PCM 8, 16, 24 or 32 bit, or 32 bit
+// float; channels are mixed down to one, so the bloom sketch's left and
+// right chips hear the same.
+
+#pragma once
+
+#include "Msgeq7.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define MSGEQ7_Q 1.7 // the bands are about 1.3 octaves apart
+#define MSGEQ7_DECAY_SECONDS 0.015
+#define MSGEQ7_DC_OFFSET 90 // what it reads with no input
+
+class WavAudio : public AudioSource {
+  public:
+    WavAudio(const char* path, int fps) : file(fopen(path, "rb")), fps(fps)
+    {
+      if (file && !readHeader()) {
+        fclose(file);
+        file = NULL;
+      }
+      if (!file)
+        return;
+
+      const double centres[MSGEQ7_BANDS] = { 63, 160, 400, 1000, 2500, 6250, 16000 };
+      for (uint8_t i = 0; i < MSGEQ7_BANDS; i++)
+        bands[i].setup(centres[i], rate);
+      decay = exp(-1.0 / (MSGEQ7_DECAY_SECONDS * rate));
+    }
+
+    ~WavAudio() { if (file) fclose(file); }
+
+    bool ok() const { return file != NULL; }
+    uint32_t sampleRate() const { return rate; }
+    double seconds() const { return (double) samplesRead / rate; }
+
+    bool next(uint16_t levels[MSGEQ7_BANDS]) override
+    {
+      // samples up to the end of the next frame, so frames don't drift
+      uint64_t end = (frame + 1) * (uint64_t) rate / fps;
+      frame++;
+
+      bool any = false;
+      while (samplesRead < end) {
+        float sample;
+        if (!readSample(sample))
+          break;
+        samplesRead++;
+        any = true;
+
+        for (uint8_t i = 0; i < MSGEQ7_BANDS; i++) {
+          Band& band = bands[i];
+          double level = fabs(band.filter(sample));
+          band.peak = level > band.peak ? level : band.peak * decay;
+        }
+      }
+
+      for (uint8_t i = 0; i < MSGEQ7_BANDS; i++) {
+        double level = MSGEQ7_DC_OFFSET + bands[i].peak * (1023 - MSGEQ7_DC_OFFSET);
+        levels[i] = level > 1023 ? 1023 : (uint16_t) level;
+      }
+      return any;
+    }
+
+  private:
+    struct Band {
+      double b0 = 0, b2 = 0, a1 = 0, a2 = 0;
+      double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+      double peak = 0;
+      bool on = false;
+
+      void setup(double centre, uint32_t rate)
+      {
+        on = centre < rate * 0.45; // 16 kHz isn't there at 22 kHz
+        if (!on)
+          return;
+        double w0 = 2 * M_PI * centre / rate;
+        double alpha = sin(w0) / (2 * MSGEQ7_Q);
+        double a0 = 1 + alpha;
+        b0 = alpha / a0;
+        b2 = -alpha / a0;
+        a1 = -2 * cos(w0) / a0;
+        a2 = (1 - alpha) / a0;
+      }
+
+      double filter(double x)
+      {
+        if (!on)
+          return 0;
+        double y = b0 * x + b2 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        return y;
+      }
+    };
+
+    FILE* file;
+    int fps;
+    uint16_t format = 0;
+    uint16_t channels = 0;
+    uint32_t rate = 0;
+    uint16_t bits = 0;
+    uint32_t dataLeft = 0; // bytes
+    uint64_t frame = 0;
+    uint64_t samplesRead = 0; // per channel
+    double decay = 0;
+    Band bands[MSGEQ7_BANDS];
+
+    static uint32_t word(const uint8_t* bytes, uint8_t size)
+    {
+      uint32_t value = 0;
+      for (uint8_t i = 0; i < size; i++)
+        value |= (uint32_t) bytes[i] << (8 * i);
+      return value;
+    }
+
+    // RIFF, WAVE, then chunks: fmt before data
+    bool readHeader()
+    {
+      uint8_t header[12];
+      if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+          memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+        return false;
+
+      uint8_t chunk[8];
+      while (fread(chunk, 1, sizeof(chunk), file) == sizeof(chunk)) {
+        uint32_t size = word(chunk + 4, 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+          uint8_t fmt[40] = {};
+          if (size < 16 || fread(fmt, 1, size < sizeof(fmt) ? size : sizeof(fmt), file) < 16)
+            return false;
+          if (size > sizeof(fmt))
+            fseek(file, size - sizeof(fmt), SEEK_CUR);
+          format = word(fmt, 2);
+          channels = word(fmt + 2, 2);
+          rate = word(fmt + 4, 4);
+          bits = word(fmt + 14, 2);
+          if (format == 0xFFFE && size >= 26)
+            format = word(fmt + 24, 2); // WAVE_FORMAT_EXTENSIBLE, the sub format
+        }
+        else if (memcmp(chunk, "data", 4) == 0) {
+          dataLeft = size;
+          bool pcm = format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32);
+          bool floats = format == 3 && bits == 32;
+          return (pcm || floats) && channels > 0 && rate > 0;
+        }
+        else {
+          fseek(file, size + (size & 1), SEEK_CUR);
+        }
+      }
+      return false;
+    }
+
+    // the next sample of every channel, mixed, -1 to 1
+    bool readSample(float& sample)
+    {
+      uint8_t bytes = bits / 8;
+      if (dataLeft < (uint32_t) bytes * channels)
+        return false;
+
+      uint8_t buffer[4];
+      double sum = 0;
+      for (uint16_t c = 0; c < channels; c++) {
+        if (fread(buffer, 1, bytes, file) != bytes)
+          return false;
+        dataLeft -= bytes;
+
+        uint32_t raw = word(buffer, bytes);
+        if (format == 3) {
+          float value;
+          memcpy(&value, &raw, sizeof(value));
+          sum += value;
+        }
+        else if (bits == 8) {
+          sum += ((int) raw - 128) / 128.0; // unsigned
+        }
+        else {
+          // sign extend from the top bit
+          int32_t value = (int32_t) (raw << (32 - bits));
+          sum += value / 2147483648.0;
+        }
+      }
+      sample = sum / channels;
+      return true;
+    }
+};
@@ -0,0 +1,165 @@
+// Checks that GET /all, streamed through JsonWriter by writeFieldsJson(),
+// is byte for byte what the String-built getFieldsJson() it replaced made
+// of the same field table.  The old builder is kept here as the reference.
+//
+//   esp8266-fastled-audio_fields_json
+//
+// Like runner.cpp, it includes the sketch (HOST_SKETCH) to reach its
+// fields[].  The main sketch's /all is checked with every pattern, as the
+// param fields change with it (see PatternParams.h).
+
+#include HOST_SKETCH
+
+#include <cstdio>
+#include <string>
+
+static String quotedList(const String* names, uint8_t count)
+{
+  String list = "";
+  for (uint8_t i = 0; i < count; i++) {
+    list += "\"" + names[i] + "\"";
+    if (i < count - 1)
+      list += ",";
+  }
+  return list;
+}
+
+#ifdef PARAM_SLOTS
+// the main sketch's palette and audio sync mode names
+static String quotedList(const char* const* names, uint8_t count)
+{
+  String list = "";
+  for (uint8_t i = 0; i < count; i++) {
+    list += "\"" + String(names[i]) + "\"";
+    if (i < count - 1)
+      list += ",";
+  }
+  return list;
+}
+#endif
+
+// What the getPatterns() and friends that writeOptions replaced returned.
+static bool oldOptions(const Field& field, String& options)
+{
+  if (field.writeOptions == writePatterns) {
+    String names[patternCount];
+    for (uint8_t i = 0; i < patternCount; i++)
+      names[i] = patterns[i].name;
+    options = quotedList(names, patternCount);
+    return true;
+  }
+#ifdef PARAM_SLOTS
+  // the main sketch's
+  if (field.writeOptions == writePalettes) {
+    options = quotedList(paletteNames, paletteCount);
+    return true;
+  }
+  if (field.writeOptions == writeAudioSyncModes) {
+    options = quotedList(audioSyncModeNames, AudioSyncModeCount);
+    return true;
+  }
+#endif
+  return false;
+}
+
+// getFieldsJson() as it was.  Fields added since, that have a value but no
+// getter, get it the way the getters made theirs: String(value).
+static bool oldFieldsJson(FieldList fields, uint8_t count, String& json)
+{
+  json = "[";
+
+  for (uint8_t i = 0; i < count; i++) {
+    Field field = fields[i];
+
+    json += "{\"name\":\"" + field.name + "\",\"label\":\"" + field.label + "\",\"type\":\"" + field.type + "\"";
+
+    String value;
+    bool hasValue = true;
+    if (field.getValue)
+      value = field.getValue();
+#ifdef PARAM_SLOTS
+    else if (field.value)
+      value = String(field.value[0]);
+#endif
+    else
+      hasValue = false;
+
+    if (hasValue) {
+      if (field.type == ColorFieldType || field.type == "String") {
+        json += ",\"value\":\"" + value + "\"";
+      }
+      else {
+        json += ",\"value\":" + value;
+      }
+    }
+
+    if (field.type == NumberFieldType) {
+      json += ",\"min\":" + String(field.min);
+      json += ",\"max\":" + String(field.max);
+    }
+
+    if (field.writeOptions) {
+      String options;
+      if (!oldOptions(field, options)) {
+        fprintf(stderr, "%s: no reference for its options\n", field.name.c_str());
+        return false;
+      }
+      json += ",\"options\":[";
+      json += options;
+      json += "]";
+    }
+
+    json += "}";
+
+    if (i < count - 1)
+      json += ",";
+  }
+
+  json += "]";
+  return true;
+}
+
+static bool checkAll(const char* when)
+{
+  String expected;
+  if (!oldFieldsJson(fields, fieldCount, expected))
+    return false;
+
+  HostResponse response = webServer.hostRequest(HTTP_GET, "/all");
+  std::string want = expected.c_str();
+  if (response.code == 200 && response.complete && response.body == want)
+    return true;
+
+  size_t at = 0;
+  while (at < want.size() && at < response.body.size() && want[at] == response.body[at])
+    at++;
+  fprintf(stderr, "/all %s: %d, %u bytes, expected %u, first difference at %u\n  got      %.60s\n  expected %.60s\n",
+          when, response.code, (unsigned) response.body.size(), (unsigned) want.size(), (unsigned) at,
+          response.body.c_str() + at, want.c_str() + at);
+  return false;
+}
+
+int main()
+{
+  Serial.quiet = true;
+  hostSetVirtualTime(true);
+  setup();
+
+  int failed = 0;
+  if (!checkAll("after setup()"))
+    failed++;
+
+#ifdef PARAM_SLOTS
+  for (uint8_t i = 0; i < patternCount; i++) {
+    currentPatternIndex = i;
+    applyPatternParams();
+    char when[64];
+    snprintf(when, sizeof(when), "with pattern %u", i);
+    if (!checkAll(when))
+      failed++;
+  }
+#endif
+
+  printf("/all: %s\n", failed ? "differs" : "as the String builder made it");
+  return failed ? 1 : 0;
+}
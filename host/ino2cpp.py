@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Turn an Arduino .ino into a C++ translation unit, the way the Arduino
+builder does: include Arduino.h and declare every top-level function right
+before the first function definition, so functions may be used before they
+are defined.  Functions with default arguments are left alone, as their
+definition already has to come before any use.
+
+usage: ino2cpp.py sketch.ino output.cpp
+"""
+
+import re
+import sys
+
+SIGNATURE = re.compile(r'^\s*((?:[\w:<>*&]+\s+)+?[\w:<>*&\s]*?)\b(\w+)\s*\(([^()]*)\)\s*$', re.S)
+NOT_FUNCTIONS = ('if', 'for', 'while', 'switch', 'return', 'else', 'do', 'sizeof')
+
+
+def strip(source):
+    """Blank out comments, strings and preprocessor lines, keeping offsets."""
+    out = list(source)
+    i, n = 0, len(source)
+    line_start = True
+    while i < n:
+        c = source[i]
+        if line_start and c == '#':
+            j = i
+            while j < n and source[j] != '\n':
+                if source[j] == '\\' and j + 1 < n and source[j + 1] in '\r\n':
+                    j += 1
+                j += 1
+            for k in range(i, j):
+                if out[k] not in '\r\n':
+                    out[k] = ' '
+            i = j
+            continue
+        if c == '\n':
+            line_start = True
+            i += 1
+            continue
+        if not c.isspace():
+            line_start = False
+        if source.startswith('//', i):
+            j = source.find('\n', i)
+            j = n if j < 0 else j
+            for k in range(i, j):
+                out[k] = ' '
+            i = j
+        elif source.startswith('/*', i):
+            j = source.find('*/', i + 2)
+            j = n if j < 0 else j + 2
+            for k in range(i, j):
+                if out[k] not in '\r\n':
+                    out[k] = ' '
+            i = j
+        elif c in '"\'':
+            j = i + 1
+            while j < n and source[j] != c:
+                j += 2 if source[j] == '\\' else 1
+            for k in range(i + 1, min(j, n)):
+                if out[k] not in '\r\n':
+                    out[k] = ' '
+            i = j + 1
+        else:
+            i += 1
+    return ''.join(out)
+
+
+def functions(source):
+    """Yield (offset, prototype) for each top-level function definition."""
+    code = strip(source)
+    depth = 0
+    start = 0
+    for i, c in enumerate(code):
+        if c == '{':
+            if depth == 0:
+                head = code[start:i]
+                m = SIGNATURE.match(head)
+                if m and m.group(2) not in NOT_FUNCTIONS and '=' not in head \
+                        and not re.search(r'\b(struct|class|enum|union|namespace|typedef)\b', head):
+                    ret = ' '.join(m.group(1).split())
+                    args = ' '.join(m.group(3).split())
+                    offset = start + len(head) - len(head.lstrip())
+                    yield offset, '%s %s(%s);' % (ret, m.group(2), args)
+            depth += 1
+        elif c == '}':
+            depth -= 1
+            if depth == 0:
+                start = i + 1
+        elif c == ';' and depth == 0:
+            start = i + 1
+
+
+def main():
+    ino, cpp = sys.argv[1], sys.argv[2]
+    with open(ino, newline='') as f:
+        source = f.read().replace('\r\n', '\n')
+
+    found = list(functions(source))
+    prototypes = []
+    for _, proto in found:
+        if proto not in prototypes:
+            prototypes.append(proto)
+
+    path = ino.replace('\\', '\\\\')
+    if found:
+        first = found[0][0]
+        first = source.rfind('\n', 0, first) + 1
+        line = source.count('\n', 0, first) + 1
+        body = (source[:first] + '\n'.join(prototypes) + '\n#line %d "%s"\n' % (line, path) + source[first:])
+    else:
+        body = source
+
+    with open(cpp, 'w') as f:
+        f.write('#include <Arduino.h>\n#line 1 "%s"\n' % path)
+        f.write(body)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,111 @@
+// Times the particle pool in Particles.h on 300 LEDs with all 64 particles
+// alive, on a strip and on a 20x15 grid, against the usual way of drawing
+// dots: fade the whole strip and stamp each dot onto it.  The particles are
+// erased and redrawn, as the patterns in ParticlePatterns.h do, so they cost
+// what the particles do, not the strip; the strip is timed with 16 as well.
+//
+//   particles_bench                 100000 frames of each
+//   particles_bench --frames 1000
+//
+// Prints the time per frame.  Only the ratios mean much for the ESP8266.
+
+#include <FastLED.h>
+
+#include "Particles.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define BENCH_LEDS 300
+#define BENCH_WIDTH 20
+#define BENCH_HEIGHT 15
+
+CRGB benchLeds[BENCH_LEDS];
+uint16_t benchMap[BENCH_LEDS];
+uint32_t benchSum = 0; // so the compiler keeps the drawing
+
+// Keeps the pool full: particles that died come back from the middle.
+void refillParticles(uint16_t width, uint16_t height)
+{
+  while (particleCount < PARTICLES_MAX) {
+    emitParticle((width << PARTICLE_SHIFT) / 2, (height << PARTICLE_SHIFT) / 2,
+                 (int16_t) random8(64) - 32, (int16_t) random8(64) - 32, random8(), 1 + random8(4));
+  }
+}
+
+template <typename Frame>
+double nanosPerFrame(int frames, Frame frame)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < frames; i++) {
+    frame();
+    benchSum += benchLeds[i % BENCH_LEDS].r;
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / frames;
+}
+
+int main(int argc, char** argv)
+{
+  int frames = 100000;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frames = atoi(argv[++i]);
+    }
+    else {
+      fprintf(stderr, "usage: %s [--frames N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (frames < 1)
+    frames = 1;
+
+  for (uint16_t i = 0; i < BENCH_LEDS; i++)
+    benchMap[i] = i;
+
+  const CRGBPalette16 palette = RainbowColors_p;
+  random16_set_seed(1);
+
+  double stamped = nanosPerFrame(frames, [&] {
+    fadeToBlackBy(benchLeds, BENCH_LEDS, 20);
+    for (uint8_t i = 0; i < PARTICLES_MAX; i++)
+      benchLeds[random16(BENCH_LEDS)] += ColorFromPalette(palette, random8());
+  });
+
+  fill_solid(benchLeds, BENCH_LEDS, CRGB::Black);
+  clearParticles();
+  double strip = nanosPerFrame(frames, [&] {
+    eraseParticles1D(benchLeds, BENCH_LEDS);
+    updateParticles(BENCH_LEDS, 1);
+    refillParticles(BENCH_LEDS, 1);
+    renderParticles1D(benchLeds, BENCH_LEDS, palette);
+  });
+
+  clearParticles();
+  double few = nanosPerFrame(frames, [&] {
+    eraseParticles1D(benchLeds, BENCH_LEDS);
+    updateParticles(BENCH_LEDS, 1);
+    while (particleCount < PARTICLES_MAX / 4)
+      emitParticle((BENCH_LEDS << PARTICLE_SHIFT) / 2, 0, (int16_t) random8(64) - 32, 0, random8(), 1 + random8(4));
+    renderParticles1D(benchLeds, BENCH_LEDS, palette);
+  });
+
+  fill_solid(benchLeds, BENCH_LEDS, CRGB::Black);
+  clearParticles();
+  particleGravityY = 1;
+  double grid = nanosPerFrame(frames, [&] {
+    eraseParticles2D(benchLeds, benchMap, BENCH_WIDTH, BENCH_HEIGHT);
+    updateParticles(BENCH_WIDTH, BENCH_HEIGHT);
+    refillParticles(BENCH_WIDTH, BENCH_HEIGHT);
+    renderParticles2D(benchLeds, benchMap, BENCH_WIDTH, BENCH_HEIGHT, palette);
+  });
+
+  printf("%d LEDs, %d particles, %d frames\n", BENCH_LEDS, PARTICLES_MAX, frames);
+  printf("fade and stamp   %8.0f ns/frame\n", stamped);
+  printf("particles, strip %8.0f ns/frame\n", strip);
+  printf("16 of them, strip %7.0f ns/frame\n", few);
+  printf("particles, grid  %8.0f ns/frame\n", grid);
+  return benchSum == 0xFFFFFFFF;
+}
@@ -0,0 +1,430 @@
+// The host build's main(): runs a sketch's setup(), then loop() once per
+// frame on virtual time, and keeps what each frame gave FastLED.show().
+//
+//   esp8266-fastled-audio                 the current pattern, 120 frames
+//   esp8266-fastled-audio --all           every pattern in patterns[]
+//   esp8266-fastled-audio --pattern 3 --frames 600 --out frames.rgb
+//   esp8266-fastled-audio --bench --frames 1000 > bench.json
+//   esp8266-fastled-audio --pattern 21 --audio set.wav --frames 0 --png frames
+//   esp8266-fastled-audio --list
+//   esp8266-fastled-audio --audio-sync slave --frames 600
+//
+//   --frames N       frames per pattern; 0 for as long as a WAV file lasts
+//   --fps N          frame rate of the virtual clock, FRAMES_PER_SECOND by
+//                    default
+//   --audio SOURCE   what the MSGEQ7 hears: beat (the default), silence, a
+//                    .wav file (see WavAudio.h) or a file of levels to
+//                    replay (see Msgeq7.h)
+//   --seed N         random8/16 and random() are seeded with N before each
+//                    pattern, 1 by default
+//   --out FILE       write each frame's leds[] as raw RGB, for
+//                    ffmpeg -f rawvideo -pix_fmt rgb24 -s <count>x1
+//   --png DIR        write each frame as DIR/000000.png and on, the strip
+//                    as HOST_PNG_ROWS rows of pixels
+//   --bench          time each pattern function and write JSON (see
+//                    tools/bench.py)
+//   --audio-sync master|slave
+//                    run as an audio sync master or slave (AudioSync.h),
+//                    over UDP multicast on loopback, with the frames paced
+//                    to the wall clock so two instances keep time; prints
+//                    the sync counters at the end (see tools/audiosync.py)
+//   --verbose        let the sketch's Serial output through
+//
+// SPIFFS is the directory in $SPIFFS_ROOT (./data by default).
+//
+// A run gives the same frames every time: the clock is virtual and starts
+// at 0, and the seeds and the audio are the same, so tools/golden.py can
+// check that the patterns still draw what they drew.
+//
+// The sketch is the .cpp host/ino2cpp.py makes of its .ino, included here
+// (HOST_SKETCH) so its globals and patterns[] are in reach.
+// HOST_AUTOPLAY names its autoplay flag, which is turned off so a pattern
+// runs for all its frames.  --audio-sync is for a sketch with AudioSync.h.
+
+#include HOST_SKETCH
+
+#include "Msgeq7.h"
+#include "Png.h"
+#include "WavAudio.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <string>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#define HOST_PNG_ROWS 8
+
+struct HostRun {
+  int frames = 120;
+  int fps = FRAMES_PER_SECOND;
+  int pattern = -1; // the one the sketch starts with
+  uint16_t seed = 1;
+  const char* audio = "beat";
+  bool all = false;
+  bool list = false;
+  bool bench = false;
+  bool verbose = false;
+  int audioSync = 0; // AudioSyncMode, 0 for off
+  const char* out = NULL;
+  const char* png = NULL;
+};
+
+static std::vector<CRGB> hostFrame;
+static uint32_t hostShows = 0;
+
+static Msgeq7 msgeq7(MSGEQ7_STROBE_PIN, MSGEQ7_RESET_PIN);
+static std::unique_ptr<AudioSource> audioSource;
+static WavAudio* wavAudio = NULL;
+static uint32_t pngFrames = 0;
+
+// --bench puts timedPattern() in patterns[] in place of the pattern it times
+static Pattern benchPattern = NULL;
+static std::vector<uint32_t> benchNanos;
+
+// --audio-sync: the wall clock when the virtual one was at 0
+static std::chrono::steady_clock::time_point wallStart;
+
+#ifdef AUDIO_SYNC_PORT
+// the sync counters as they were at the last packet the master sent, or
+// the last frame the slave played; the slave goes on to conceal the
+// silence after the master stops, which is not a loss
+struct HostAudioSync {
+  uint32_t sent = 0;
+  uint32_t received = 0;
+  uint32_t late = 0;
+  uint32_t lost = 0;
+  uint32_t concealed = 0;
+  uint32_t beats = 0;       // detected, on the master, or played
+  uint32_t beatsBefore = 0; // the master's count in the first packet played
+  bool playing = false;
+  uint16_t played = 0;
+};
+
+static HostAudioSync hostAudioSync;
+static uint32_t hostAudioSyncBeats = 0;
+
+// after every loop()
+static void countAudioSync()
+{
+  if (audioBeat)
+    hostAudioSyncBeats++;
+
+  HostAudioSync& sync = hostAudioSync;
+  if (audioSyncMode == AudioSyncMaster) {
+    if (audioSyncSent == sync.sent)
+      return;
+  }
+  else {
+    if (!audioSyncPlaying || (sync.playing && audioSyncPlayed == sync.played))
+      return;
+    if (!sync.playing)
+      sync.beatsBefore = audioSyncPlayedBeats;
+    sync.playing = true;
+    sync.played = audioSyncPlayed;
+  }
+
+  sync.sent = audioSyncSent;
+  sync.received = audioSyncReceived;
+  sync.late = audioSyncLate;
+  sync.lost = audioSyncLost;
+  sync.concealed = audioSyncConcealed;
+  sync.beats = hostAudioSyncBeats;
+}
+
+static void printAudioSync()
+{
+  const HostAudioSync& sync = hostAudioSync;
+  if (audioSyncMode == AudioSyncMaster) {
+    printf("audio sync master: %u sent, %u beats\n", sync.sent, sync.beats);
+  }
+  else {
+    printf("audio sync slave: %u received, %u late, %u lost, %u concealed, %u beats, %u before the first packet\n",
+           sync.received, sync.late, sync.lost, sync.concealed, sync.beats + sync.beatsBefore, sync.beatsBefore);
+  }
+}
+#endif
+
+static void timedPattern()
+{
+  auto start = std::chrono::steady_clock::now();
+  benchPattern();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  benchNanos.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+static void usage(const char* name)
+{
+  fprintf(stderr, "usage: %s [--list] [--all | --pattern N] [--frames N] [--fps N] [--audio beat|silence|FILE]\n"
+                  "       [--seed N] [--out FILE] [--png DIR] [--bench] [--verbose] [--audio-sync master|slave]\n", name);
+  exit(2);
+}
+
+static bool isWav(const char* path)
+{
+  size_t length = strlen(path);
+  return length > 4 && !strcasecmp(path + length - 4, ".wav");
+}
+
+static bool parseArgs(int argc, char** argv, HostRun& run)
+{
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (!strcmp(arg, "--all")) run.all = true;
+    else if (!strcmp(arg, "--list")) run.list = true;
+    else if (!strcmp(arg, "--bench")) run.bench = true;
+    else if (!strcmp(arg, "--verbose")) run.verbose = true;
+    else if (!value) return false;
+    else if (!strcmp(arg, "--frames")) { run.frames = atoi(value); i++; }
+    else if (!strcmp(arg, "--fps")) { run.fps = atoi(value); i++; }
+    else if (!strcmp(arg, "--pattern")) { run.pattern = atoi(value); i++; }
+    else if (!strcmp(arg, "--seed")) { run.seed = atoi(value); i++; }
+    else if (!strcmp(arg, "--audio")) { run.audio = value; i++; }
+    else if (!strcmp(arg, "--out")) { run.out = value; i++; }
+    else if (!strcmp(arg, "--png")) { run.png = value; i++; }
+#ifdef AUDIO_SYNC_PORT
+    else if (!strcmp(arg, "--audio-sync") && !strcmp(value, "master")) { run.audioSync = AudioSyncMaster; i++; }
+    else if (!strcmp(arg, "--audio-sync") && !strcmp(value, "slave")) { run.audioSync = AudioSyncSlave; i++; }
+#endif
+    else return false;
+  }
+  // only a WAV file ends
+  return (run.frames > 0 || isWav(run.audio)) && run.fps > 0 && run.pattern < (int) patternCount;
+}
+
+static bool openAudio(const HostRun& run)
+{
+  if (isWav(run.audio)) {
+    wavAudio = new WavAudio(run.audio, run.fps);
+    audioSource.reset(wavAudio);
+    if (!wavAudio->ok()) {
+      fprintf(stderr, "%s: not a WAV file this can read\n", run.audio);
+      return false;
+    }
+  }
+  else if (!strcmp(run.audio, "beat")) {
+    audioSource.reset(new BeatAudio(run.fps));
+  }
+  else if (!strcmp(run.audio, "silence")) {
+    audioSource.reset(new SilentAudio());
+  }
+  else {
+    ReplayAudio* replay = new ReplayAudio(run.audio);
+    audioSource.reset(replay);
+    if (!replay->ok()) {
+      perror(run.audio);
+      return false;
+    }
+  }
+  msgeq7.attach();
+  return true;
+}
+
+static bool writePng(const HostRun& run)
+{
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%06u.png", run.png, pngFrames++);
+  if (PngWriter::write(path, (const uint8_t*) hostFrame.data(), hostFrame.size(), HOST_PNG_ROWS))
+    return true;
+  perror(path);
+  return false;
+}
+
+// Run one pattern for run.frames frames, or until the audio ends, and set
+// frames to how many that was.  Returns the frames in which it showed
+// nothing.
+static int runPattern(const HostRun& run, uint8_t index, FILE* out, int& frames)
+{
+  currentPatternIndex = index;
+  random16_set_seed(run.seed);
+  randomSeed(run.seed);
+
+  uint64_t frameMicros = 1000000 / run.fps;
+  int missed = 0;
+
+  for (frames = 0; run.frames == 0 || frames < run.frames; frames++) {
+    uint64_t next = hostMicros() + frameMicros;
+    uint32_t shows = hostShows;
+
+    uint16_t levels[MSGEQ7_BANDS];
+    if (!audioSource->next(levels)) {
+      if (run.frames == 0)
+        break;
+      memset(levels, 0, sizeof(levels)); // silence after the end
+    }
+    msgeq7.setLevels(levels);
+
+    HOST_AUTOPLAY = 0;
+    power = 1;
+    loop();
+
+    if (hostShows == shows)
+      missed++;
+    if (out)
+      fwrite(hostFrame.data(), sizeof(CRGB), hostFrame.size(), out);
+    if (run.png && !writePng(run))
+      exit(1);
+#ifdef AUDIO_SYNC_PORT
+    if (run.audioSync)
+      countAudioSync();
+#endif
+
+    // loop() may have used up some time itself, with FastLED.delay()
+    if (hostMicros() < next)
+      hostSetTime(next);
+    if (run.audioSync)
+      std::this_thread::sleep_until(wallStart + std::chrono::microseconds(hostMicros()));
+  }
+
+  return missed;
+}
+
+static void printJsonString(const char* text)
+{
+  putchar('"');
+  for (; *text; text++) {
+    if (*text == '"' || *text == '\\')
+      putchar('\\');
+    if ((uint8_t) *text >= 0x20)
+      putchar(*text);
+  }
+  putchar('"');
+}
+
+// The pattern's function, as an offset into the executable that nm shows
+// it at, so tools/bench.py can find the function's static variables.
+static uintptr_t patternOffset(Pattern pattern)
+{
+  Dl_info info;
+  if (!dladdr((void*) pattern, &info))
+    return 0;
+  return (uintptr_t) pattern - (uintptr_t) info.dli_fbase;
+}
+
+// Time the pattern function alone, not the rest of loop(), frame by frame,
+// and give the median.
+static void benchPatterns(const HostRun& run, uint8_t first, uint8_t last)
+{
+  printf("{\"frames\":%d,\"fps\":%d,\"seed\":%u,\"audio\":", run.frames, run.fps, run.seed);
+  printJsonString(run.audio);
+  printf(",\"leds\":%u,\"patterns\":[", (unsigned) hostFrame.size());
+
+  for (uint8_t i = first; i <= last; i++) {
+    benchPattern = patterns[i].pattern;
+    benchNanos.clear();
+    patterns[i].pattern = timedPattern;
+    int frames;
+    runPattern(run, i, NULL, frames);
+    patterns[i].pattern = benchPattern;
+
+    uint32_t median = 0;
+    uint64_t total = 0;
+    if (!benchNanos.empty()) {
+      for (uint32_t nanos : benchNanos)
+        total += nanos;
+      std::nth_element(benchNanos.begin(), benchNanos.begin() + benchNanos.size() / 2, benchNanos.end());
+      median = benchNanos[benchNanos.size() / 2];
+    }
+    double pixelsPerSecond = median ? hostFrame.size() * 1e9 / median : 0;
+
+    printf("%s\n{\"index\":%u,\"name\":", i == first ? "" : ",", i);
+    printJsonString(patterns[i].name.c_str());
+    printf(",\"function\":\"0x%lx\",\"calls\":%u,\"ns_per_frame\":%u,\"ns_total\":%llu,\"pixels_per_second\":%.0f}",
+           (unsigned long) patternOffset(benchPattern), (unsigned) benchNanos.size(), median,
+           (unsigned long long) total, pixelsPerSecond);
+  }
+
+  printf("\n]}\n");
+}
+
+int main(int argc, char** argv)
+{
+  HostRun run;
+  if (!parseArgs(argc, argv, run))
+    usage(argv[0]);
+
+  if (run.list) {
+    for (uint8_t i = 0; i < patternCount; i++)
+      printf("%u\t%s\n", i, patterns[i].name.c_str());
+    return 0;
+  }
+
+  Serial.quiet = !run.verbose;
+  hostSetVirtualTime(true);
+  if (!openAudio(run))
+    return 1;
+
+  // the last show() of a frame is the frame
+  hostShowHook = [](const CRGB* leds, int count, uint8_t brightness) {
+    hostFrame.assign(leds, leds + count);
+    hostShows++;
+  };
+
+  setup();
+
+#ifdef AUDIO_SYNC_PORT
+  if (run.audioSync) {
+    // open the socket now, so a slave is listening once this is printed
+    audioSyncMode = run.audioSync;
+    startAudioSync();
+    printf("audio sync %s\n", audioSyncModeNames[audioSyncMode]);
+    fflush(stdout);
+  }
+#endif
+  wallStart = std::chrono::steady_clock::now() - std::chrono::microseconds(hostMicros());
+
+  // --pattern, or all of them for --all and --bench, or the current one
+  bool every = run.pattern < 0 && (run.all || run.bench);
+  uint8_t first = run.pattern >= 0 ? run.pattern : every ? 0 : currentPatternIndex;
+  uint8_t last = every ? patternCount - 1 : first;
+
+  if (run.bench) {
+    benchPatterns(run, first, last);
+    return 0;
+  }
+
+  FILE* out = NULL;
+  if (run.out) {
+    out = fopen(run.out, "wb");
+    if (!out) {
+      perror(run.out);
+      return 1;
+    }
+  }
+
+  int failed = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  for (uint8_t i = first; i <= last; i++) {
+    int frames;
+    int missed = runPattern(run, i, out, frames);
+    printf("%u\t%s\t%d frames", i, patterns[i].name.c_str(), frames);
+    if (missed) {
+      printf(", %d without a show()", missed);
+      failed++;
+    }
+    printf("\n");
+  }
+
+  if (out)
+    fclose(out);
+
+#ifdef AUDIO_SYNC_PORT
+  if (run.audioSync)
+    printAudioSync();
+#endif
+
+  if (wavAudio) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("%.1f s of audio in %.1f s\n", wavAudio->seconds(), elapsed.count());
+  }
+
+  return failed ? 1 : 0;
+}
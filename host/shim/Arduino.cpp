@@ -0,0 +1,200 @@
+#include "Arduino.h"
+
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
+HostSerial Serial;
+EspClass ESP;
+
+std::function<void(uint8_t pin, uint8_t value)> hostDigitalWriteHook;
+std::function<int(uint8_t pin)> hostAnalogReadHook;
+
+///////////////////////////////////////////////////////////////////////
+// time
+
+static bool virtualTime = false;
+static uint64_t virtualMicros = 0;
+
+static uint64_t realMicros()
+{
+  static const auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+uint64_t hostMicros()
+{
+  return virtualTime ? virtualMicros : realMicros();
+}
+
+void hostSetVirtualTime(bool enabled)
+{
+  virtualTime = enabled;
+}
+
+void hostAdvanceTime(uint32_t us)
+{
+  virtualMicros += us;
+}
+
+void hostSetTime(uint64_t us)
+{
+  virtualMicros = us;
+}
+
+unsigned long millis()
+{
+  return (unsigned long)(uint32_t)(hostMicros() / 1000);
+}
+
+unsigned long micros()
+{
+  return (unsigned long)(uint32_t) hostMicros();
+}
+
+void delay(unsigned long ms)
+{
+  if (virtualTime) {
+    virtualMicros += (uint64_t) ms * 1000;
+  } else if (ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  }
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  // too short to be worth sleeping for on the host
+  if (virtualTime) virtualMicros += us;
+}
+
+void yield() {}
+
+///////////////////////////////////////////////////////////////////////
+// pins
+
+static uint8_t pinLevels[32];
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (pin < sizeof(pinLevels)) pinLevels[pin] = value;
+  if (hostDigitalWriteHook) hostDigitalWriteHook(pin, value);
+}
+
+int digitalRead(uint8_t pin)
+{
+  return pin < sizeof(pinLevels) ? pinLevels[pin] : LOW;
+}
+
+int analogRead(uint8_t pin)
+{
+  return hostAnalogReadHook ? hostAnalogReadHook(pin) : 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// random
+
+static uint32_t arduinoSeed = 1;
+
+long random(long howbig)
+{
+  if (howbig <= 0) return 0;
+  // xorshift32, so runs are repeatable across libc implementations
+  arduinoSeed ^= arduinoSeed << 13;
+  arduinoSeed ^= arduinoSeed >> 17;
+  arduinoSeed ^= arduinoSeed << 5;
+  return arduinoSeed % howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+  if (howsmall >= howbig) return howsmall;
+  return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed)
+{
+  if (seed != 0) arduinoSeed = seed;
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+///////////////////////////////////////////////////////////////////////
+// ESP
+
+uint32_t EspClass::getCycleCount()
+{
+  // the host clock scaled to the ESP8266's 80MHz, so budgets read the same
+  return (uint32_t)(realMicros() * (F_CPU / 1000000L));
+}
+
+uint32_t EspClass::getChipId()
+{
+  const char* env = getenv("CHIP_ID");
+  return env ? strtoul(env, NULL, 16) : 0x1920f7;
+}
+
+uint32_t EspClass::getFreeHeap()
+{
+  return 40 * 1024;
+}
+
+// Flash is emulated sector by sector, erased sectors read back as 0xFF.
+static const uint32_t flashSectorSize = 4096;
+static std::map<uint32_t, std::vector<uint8_t>> flashSectors;
+
+static std::vector<uint8_t>& flashSector(uint32_t sector)
+{
+  auto it = flashSectors.find(sector);
+  if (it == flashSectors.end()) {
+    it = flashSectors.emplace(sector, std::vector<uint8_t>(flashSectorSize, 0xFF)).first;
+  }
+  return it->second;
+}
+
+bool EspClass::flashEraseSector(uint32_t sector)
+{
+  std::vector<uint8_t>& data = flashSector(sector);
+  std::fill(data.begin(), data.end(), 0xFF);
+  return true;
+}
+
+bool EspClass::flashWrite(uint32_t offset, uint32_t* data, size_t size)
+{
+  if ((offset & 3) || (size & 3)) return false;
+  const uint8_t* src = (const uint8_t*) data;
+  for (size_t i = 0; i < size; i++) {
+    uint32_t address = offset + i;
+    // NOR flash can only clear bits
+    flashSector(address / flashSectorSize)[address % flashSectorSize] &= src[i];
+  }
+  return true;
+}
+
+bool EspClass::flashRead(uint32_t offset, uint32_t* data, size_t size)
+{
+  uint8_t* dst = (uint8_t*) data;
+  for (size_t i = 0; i < size; i++) {
+    uint32_t address = offset + i;
+    dst[i] = flashSector(address / flashSectorSize)[address % flashSectorSize];
+  }
+  return true;
+}
+
+void hexdump(const void* mem, uint32_t len, uint8_t cols)
+{
+  const uint8_t* src = (const uint8_t*) mem;
+  Serial.printf("\n[HEXDUMP] Address: %p len: 0x%X (%d)", mem, len, len);
+  for (uint32_t i = 0; i < len; i++) {
+    if (i % cols == 0) {
+      Serial.printf("\n[%p] 0x%08X: ", src + i, i);
+    }
+    Serial.printf("%02X ", src[i]);
+  }
+  Serial.printf("\n");
+}
@@ -0,0 +1,296 @@
+// Host (Linux) stand-in for the ESP8266 Arduino core.
+//
+// Only what the sketches in this repo use is provided.  Time comes from a
+// clock that is either the real monotonic clock or a virtual one driven by
+// the host runner (see hostSetVirtualTime()), and analogRead() and the
+// digital pins are routed through hooks so an emulated MSGEQ7 can sit
+// behind them.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT  0x00
+#define OUTPUT 0x01
+#define INPUT_PULLUP 0x02
+
+#define DEFAULT 0x01
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#ifndef F_CPU
+#define F_CPU 80000000L
+#endif
+
+#define PROGMEM
+#define ICACHE_RAM_ATTR
+#define ICACHE_FLASH_ATTR
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_word_near(addr) pgm_read_word(addr)
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_dword_near(addr) pgm_read_dword(addr)
+#define memcpy_P memcpy
+#define strcmp_P strcmp
+#define strlen_P strlen
+
+// NodeMCU / D1 mini pin names
+static const uint8_t A0 = 17;
+static const uint8_t D0 = 16;
+static const uint8_t D1 = 5;
+static const uint8_t D2 = 4;
+static const uint8_t D3 = 0;
+static const uint8_t D4 = 2;
+static const uint8_t D5 = 14;
+static const uint8_t D6 = 12;
+static const uint8_t D7 = 13;
+static const uint8_t D8 = 15;
+
+using std::min;
+using std::max;
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+// time
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// Switch the core clock to virtual time (for deterministic runs) and move it.
+void hostSetVirtualTime(bool enabled);
+void hostAdvanceTime(uint32_t us);
+void hostSetTime(uint64_t us);
+uint64_t hostMicros();
+
+// pins
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+inline void analogReference(uint8_t mode) {}
+
+// Hooks for emulated peripherals: called on every digitalWrite / analogRead.
+extern std::function<void(uint8_t pin, uint8_t value)> hostDigitalWriteHook;
+extern std::function<int(uint8_t pin)> hostAnalogReadHook;
+
+// Arduino random(), seeded separately from FastLED's random8/16
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+class String {
+  public:
+    String(const char* cstr = "") : s(cstr ? cstr : "") {}
+    String(const std::string& str) : s(str) {}
+    String(char c) : s(1, c) {}
+    String(unsigned char value, unsigned char base = 10) { fromUnsigned(value, base); }
+    String(int value, unsigned char base = 10) { fromSigned(value, base); }
+    String(unsigned int value, unsigned char base = 10) { fromUnsigned(value, base); }
+    String(long value, unsigned char base = 10) { fromSigned(value, base); }
+    String(unsigned long value, unsigned char base = 10) { fromUnsigned(value, base); }
+    String(float value, unsigned char decimalPlaces = 2) { fromDouble(value, decimalPlaces); }
+    String(double value, unsigned char decimalPlaces = 2) { fromDouble(value, decimalPlaces); }
+
+    unsigned int length() const { return s.length(); }
+    const char* c_str() const { return s.c_str(); }
+    bool reserve(unsigned int size) { s.reserve(size); return true; }
+    char charAt(unsigned int index) const { return index < s.length() ? s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return s[index]; }
+
+    String& operator+=(const String& rhs) { s += rhs.s; return *this; }
+    String& operator+=(const char* rhs) { s += rhs; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    String& operator+=(int value) { s += String(value).s; return *this; }
+    String& operator+=(unsigned int value) { s += String(value).s; return *this; }
+    String& operator+=(unsigned char value) { s += String(value).s; return *this; }
+    bool concat(const String& rhs) { s += rhs.s; return true; }
+
+    friend String operator+(const String& lhs, const String& rhs) { return String(lhs.s + rhs.s); }
+    friend String operator+(const String& lhs, const char* rhs) { return String(lhs.s + rhs); }
+    friend String operator+(const char* lhs, const String& rhs) { return String(lhs + rhs.s); }
+    friend String operator+(const String& lhs, char rhs) { return String(lhs.s + rhs); }
+
+    bool operator==(const String& rhs) const { return s == rhs.s; }
+    bool operator==(const char* rhs) const { return s == rhs; }
+    bool operator!=(const String& rhs) const { return s != rhs.s; }
+    bool operator!=(const char* rhs) const { return s != rhs; }
+    bool operator<(const String& rhs) const { return s < rhs.s; }
+    bool equals(const String& rhs) const { return s == rhs.s; }
+    int compareTo(const String& rhs) const { return s.compare(rhs.s); }
+
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.length(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const {
+      return s.length() >= suffix.s.length() && s.compare(s.length() - suffix.s.length(), suffix.s.length(), suffix.s) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const { size_t i = s.find(c, from); return i == std::string::npos ? -1 : (int) i; }
+    int indexOf(const String& str, unsigned int from = 0) const { size_t i = s.find(str.s, from); return i == std::string::npos ? -1 : (int) i; }
+    int lastIndexOf(char c) const { size_t i = s.rfind(c); return i == std::string::npos ? -1 : (int) i; }
+    String substring(unsigned int from) const { return from >= s.length() ? String() : String(s.substr(from)); }
+    String substring(unsigned int from, unsigned int to) const {
+      if (from > to) std::swap(from, to);
+      if (from >= s.length()) return String();
+      return String(s.substr(from, to - from));
+    }
+    void toUpperCase() { for (auto& c : s) c = toupper(c); }
+    void toLowerCase() { for (auto& c : s) c = tolower(c); }
+    void trim() {
+      size_t b = s.find_first_not_of(" \t\r\n");
+      size_t e = s.find_last_not_of(" \t\r\n");
+      s = b == std::string::npos ? "" : s.substr(b, e - b + 1);
+    }
+    void replace(const String& find, const String& replace) {
+      if (find.s.empty()) return;
+      size_t pos = 0;
+      while ((pos = s.find(find.s, pos)) != std::string::npos) {
+        s.replace(pos, find.s.length(), replace.s);
+        pos += replace.s.length();
+      }
+    }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+
+  private:
+    std::string s;
+
+    void fromUnsigned(unsigned long value, unsigned char base) {
+      char buf[33];
+      if (base == 16) snprintf(buf, sizeof(buf), "%lx", value);
+      else if (base == 8) snprintf(buf, sizeof(buf), "%lo", value);
+      else snprintf(buf, sizeof(buf), "%lu", value);
+      s = buf;
+    }
+    void fromSigned(long value, unsigned char base) {
+      if (base == 10) { s = std::to_string(value); return; }
+      fromUnsigned((unsigned long) value, base);
+    }
+    void fromDouble(double value, unsigned char decimalPlaces) {
+      char buf[64];
+      snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+      s = buf;
+    }
+};
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+      size_t n = 0;
+      while (size--) n += write(*buffer++);
+      return n;
+    }
+    size_t write(const char* str) { return write((const uint8_t*) str, strlen(str)); }
+
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write((uint8_t) c); }
+    size_t print(unsigned char n, int base = DEC) { return print(String(n, base)); }
+    size_t print(int n, int base = DEC) { return print(String(n, base)); }
+    size_t print(unsigned int n, int base = DEC) { return print(String(n, base)); }
+    size_t print(long n, int base = DEC) { return print(String(n, base)); }
+    size_t print(unsigned long n, int base = DEC) { return print(String(n, base)); }
+    size_t print(double n, int digits = 2) { return print(String(n, digits)); }
+
+    template <typename T> size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+    size_t println() { return write("\r\n"); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+      char buf[512];
+      va_list args;
+      va_start(args, format);
+      int len = vsnprintf(buf, sizeof(buf), format, args);
+      va_end(args);
+      if (len < 0) return 0;
+      return write((const uint8_t*) buf, std::min((size_t) len, sizeof(buf) - 1));
+    }
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+// Serial output goes to stderr so stdout stays free for tool output.
+// Set HostSerial::quiet to silence it (benchmarks, golden runs).
+class HostSerial : public Stream {
+  public:
+    bool quiet = false;
+
+    void begin(unsigned long) {}
+    void setDebugOutput(bool) {}
+    size_t write(uint8_t c) override { if (!quiet) fputc(c, stderr); return 1; }
+    size_t write(const uint8_t* buffer, size_t size) override {
+      if (!quiet) fwrite(buffer, 1, size, stderr);
+      return size;
+    }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    operator bool() const { return true; }
+};
+
+extern HostSerial Serial;
+
+class EspClass {
+  public:
+    uint32_t getCycleCount();
+    uint32_t getFreeHeap();
+    uint8_t getHeapFragmentation() { return 0; }
+    uint32_t getMaxFreeBlockSize() { return getFreeHeap(); }
+    uint32_t getChipId(); // CHIP_ID from the environment (hex), so host instances differ
+    uint32_t getFlashChipRealSize() { return 4 * 1024 * 1024; }
+    uint32_t getFlashChipSize() { return 4 * 1024 * 1024; }
+    uint16_t getVcc() { return 3300; }
+    uint8_t getCpuFreqMHz() { return F_CPU / 1000000L; }
+    void restart() { exit(0); }
+    void reset() { exit(0); }
+    bool flashEraseSector(uint32_t sector);
+    bool flashWrite(uint32_t offset, uint32_t* data, size_t size);
+    bool flashRead(uint32_t offset, uint32_t* data, size_t size);
+};
+
+extern EspClass ESP;
+
+void hexdump(const void* mem, uint32_t len, uint8_t cols = 16);
+
+// Provided by the sketch.
+void setup();
+void loop();
@@ -0,0 +1,84 @@
+// Host stand-in for the ESP8266 EEPROM library.  Like the real one it
+// caches one flash sector in RAM and rewrites that sector on commit(),
+// here against the emulated flash in Arduino.cpp.
+
+#pragma once
+
+#include "Arduino.h"
+#include "user_interface.h"
+
+#include <vector>
+
+// sector the ESP8266 core puts EEPROM in on a 4M flash layout
+#define EEPROM_SECTOR 0x3FB
+
+class EEPROMClass {
+  public:
+    EEPROMClass(uint32_t sector = EEPROM_SECTOR) : _sector(sector) {}
+
+    void begin(size_t size)
+    {
+      size = (size + 3) & ~3;
+      _data.assign(size, 0);
+      spi_flash_read(_sector * SPI_FLASH_SEC_SIZE, (uint32_t*) _data.data(), size);
+      _dirty = false;
+    }
+
+    uint8_t read(int address) { return address >= 0 && address < (int) _data.size() ? _data[address] : 0; }
+
+    void write(int address, uint8_t value)
+    {
+      if (address < 0 || address >= (int) _data.size()) return;
+      if (_data[address] != value) {
+        _data[address] = value;
+        _dirty = true;
+      }
+    }
+
+    bool commit()
+    {
+      if (_data.empty()) return false;
+      if (!_dirty) return true;
+      commits++;
+      if (spi_flash_erase_sector(_sector) != SPI_FLASH_RESULT_OK) return false;
+      if (spi_flash_write(_sector * SPI_FLASH_SEC_SIZE, (uint32_t*) _data.data(), _data.size()) != SPI_FLASH_RESULT_OK) return false;
+      _dirty = false;
+      return true;
+    }
+
+    bool end()
+    {
+      bool ret = commit();
+      _data.clear();
+      return ret;
+    }
+
+    uint8_t* getDataPtr() { _dirty = true; return _data.data(); }
+    const uint8_t* getConstDataPtr() const { return _data.data(); }
+    size_t length() { return _data.size(); }
+
+    template <typename T> T& get(int address, T& t)
+    {
+      if (address >= 0 && address + sizeof(T) <= _data.size()) memcpy(&t, &_data[address], sizeof(T));
+      return t;
+    }
+
+    template <typename T> const T& put(int address, const T& t)
+    {
+      if (address >= 0 && address + sizeof(T) <= _data.size() && memcmp(&_data[address], &t, sizeof(T))) {
+        memcpy(&_data[address], &t, sizeof(T));
+        _dirty = true;
+      }
+      return t;
+    }
+
+    // number of sector rewrites, for tests
+    uint32_t commits = 0;
+
+  private:
+    uint32_t _sector;
+    std::vector<uint8_t> _data;
+    bool _dirty = false;
+};
+
+extern EEPROMClass EEPROM;
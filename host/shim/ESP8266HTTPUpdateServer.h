@@ -0,0 +1,18 @@
+// Host stand-in for ESP8266HTTPUpdateServer: there is no flash to update,
+// so setup() only registers an /update route that says so.
+
+#pragma once
+
+#include "ESP8266WebServer.h"
+
+class ESP8266HTTPUpdateServer {
+  public:
+    ESP8266HTTPUpdateServer(bool serial_debug = false) { (void) serial_debug; }
+
+    void setup(ESP8266WebServer* server, const char* path = "/update")
+    {
+      server->on(path, HTTP_GET, [server]() {
+        server->send(200, "text/plain", "firmware update is not available on the host build");
+      });
+    }
+};
@@ -0,0 +1,435 @@
+#include "ESP8266WebServer.h"
+
+static const char* responseCodeToString(int code)
+{
+  switch (code) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default:  return "";
+  }
+}
+
+static String staticContentType(const String& path)
+{
+  if (path.endsWith(".htm") || path.endsWith(".html")) return "text/html";
+  if (path.endsWith(".css")) return "text/css";
+  if (path.endsWith(".js")) return "application/javascript";
+  if (path.endsWith(".json")) return "application/json";
+  if (path.endsWith(".png")) return "image/png";
+  if (path.endsWith(".gif")) return "image/gif";
+  if (path.endsWith(".jpg")) return "image/jpeg";
+  if (path.endsWith(".ico")) return "image/x-icon";
+  if (path.endsWith(".svg")) return "image/svg+xml";
+  if (path.endsWith(".ttf")) return "application/x-font-ttf";
+  if (path.endsWith(".otf")) return "application/x-font-opentype";
+  if (path.endsWith(".woff")) return "application/font-woff";
+  if (path.endsWith(".woff2")) return "application/font-woff2";
+  if (path.endsWith(".eot")) return "application/vnd.ms-fontobject";
+  if (path.endsWith(".xml")) return "text/xml";
+  if (path.endsWith(".pdf")) return "application/pdf";
+  if (path.endsWith(".zip")) return "application/zip";
+  if (path.endsWith(".gz")) return "application/x-gzip";
+  return "application/octet-stream";
+}
+
+class FunctionRequestHandler : public RequestHandler {
+  public:
+    FunctionRequestHandler(ESP8266WebServer::THandlerFunction fn, ESP8266WebServer::THandlerFunction ufn, const String& uri, HTTPMethod method)
+      : _fn(fn), _ufn(ufn), _uri(uri), _method(method) {}
+
+    bool canHandle(HTTPMethod requestMethod, String requestUri) override
+    {
+      if (_method != HTTP_ANY && _method != requestMethod) return false;
+      return requestUri == _uri;
+    }
+
+    bool canUpload(String requestUri) override { return _ufn && requestUri == _uri; }
+
+    bool handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) override
+    {
+      (void) server;
+      if (!canHandle(requestMethod, requestUri)) return false;
+      _fn();
+      return true;
+    }
+
+    void upload(ESP8266WebServer& server, String requestUri, HTTPUpload& upload) override
+    {
+      (void) server; (void) upload;
+      if (canUpload(requestUri)) _ufn();
+    }
+
+  private:
+    ESP8266WebServer::THandlerFunction _fn;
+    ESP8266WebServer::THandlerFunction _ufn;
+    String _uri;
+    HTTPMethod _method;
+};
+
+class StaticRequestHandler : public RequestHandler {
+  public:
+    StaticRequestHandler(FS& fs, const char* path, const char* uri, const char* cache_header)
+      : _fs(fs), _uri(uri), _path(path), _cache_header(cache_header ? cache_header : "")
+    {
+      _isFile = fs.exists(path);
+      _baseUriLength = _uri.length();
+    }
+
+    bool canHandle(HTTPMethod requestMethod, String requestUri) override
+    {
+      if (requestMethod != HTTP_GET) return false;
+      if ((_isFile && requestUri != _uri) || !requestUri.startsWith(_uri)) return false;
+      return true;
+    }
+
+    bool handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri) override
+    {
+      if (!canHandle(requestMethod, requestUri)) return false;
+
+      String path(_path);
+      if (!_isFile) {
+        if (requestUri.endsWith("/")) requestUri += "index.htm";
+        path += requestUri.substring(_baseUriLength);
+      }
+
+      String contentType = staticContentType(path);
+      if (!path.endsWith(".gz") && !_fs.exists(path)) {
+        String pathWithGz = path + ".gz";
+        if (_fs.exists(pathWithGz)) path += ".gz";
+      }
+
+      File f = _fs.open(path, "r");
+      if (!f) return false;
+
+      if (_cache_header.length() != 0) server.sendHeader("Cache-Control", _cache_header);
+      server.streamFile(f, contentType);
+      return true;
+    }
+
+  private:
+    FS& _fs;
+    String _uri;
+    String _path;
+    String _cache_header;
+    bool _isFile;
+    size_t _baseUriLength;
+};
+
+ESP8266WebServer::~ESP8266WebServer()
+{
+  RequestHandler* handler = _firstHandler;
+  while (handler) {
+    RequestHandler* next = handler->next();
+    delete handler;
+    handler = next;
+  }
+}
+
+void ESP8266WebServer::on(const String& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn)
+{
+  addHandler(new FunctionRequestHandler(fn, ufn, uri, method));
+}
+
+void ESP8266WebServer::addHandler(RequestHandler* handler)
+{
+  if (!_lastHandler) {
+    _firstHandler = handler;
+    _lastHandler = handler;
+  } else {
+    _lastHandler->next(handler);
+    _lastHandler = handler;
+  }
+}
+
+void ESP8266WebServer::serveStatic(const char* uri, FS& fs, const char* path, const char* cache_header)
+{
+  addHandler(new StaticRequestHandler(fs, path, uri, cache_header));
+}
+
+String ESP8266WebServer::arg(const String& name)
+{
+  for (auto& a : _currentArgs) {
+    if (a.first == name) return a.second;
+  }
+  return String();
+}
+
+String ESP8266WebServer::arg(int i)
+{
+  return i >= 0 && i < (int) _currentArgs.size() ? _currentArgs[i].second : String();
+}
+
+String ESP8266WebServer::argName(int i)
+{
+  return i >= 0 && i < (int) _currentArgs.size() ? _currentArgs[i].first : String();
+}
+
+bool ESP8266WebServer::hasArg(const String& name)
+{
+  for (auto& a : _currentArgs) {
+    if (a.first == name) return true;
+  }
+  return false;
+}
+
+String ESP8266WebServer::header(const String& name)
+{
+  auto it = _currentHeaders.find(name);
+  return it == _currentHeaders.end() ? String() : it->second;
+}
+
+String ESP8266WebServer::header(int i)
+{
+  auto it = _currentHeaders.begin();
+  for (; i > 0 && it != _currentHeaders.end(); i--) ++it;
+  return it == _currentHeaders.end() ? String() : it->second;
+}
+
+String ESP8266WebServer::headerName(int i)
+{
+  auto it = _currentHeaders.begin();
+  for (; i > 0 && it != _currentHeaders.end(); i--) ++it;
+  return it == _currentHeaders.end() ? String() : it->first;
+}
+
+bool ESP8266WebServer::hasHeader(const String& name)
+{
+  return _currentHeaders.count(name) > 0;
+}
+
+void ESP8266WebServer::sendHeader(const String& name, const String& value, bool first)
+{
+  String headerLine = name + ": " + value + "\r\n";
+  if (first) _responseHeaders = headerLine + _responseHeaders;
+  else _responseHeaders += headerLine;
+}
+
+void ESP8266WebServer::_prepareHeader(String& response, int code, const char* content_type, size_t contentLength)
+{
+  response = String("HTTP/1.1 ") + String(code) + " " + responseCodeToString(code) + "\r\n";
+
+  if (!content_type) content_type = "text/html";
+  sendHeader("Content-Type", content_type, true);
+
+  if (_contentLength == CONTENT_LENGTH_NOT_SET) {
+    sendHeader("Content-Length", String((unsigned long) contentLength));
+  } else if (_contentLength != CONTENT_LENGTH_UNKNOWN) {
+    sendHeader("Content-Length", String((unsigned long) _contentLength));
+  } else {
+    // HTTP/1.1 client: use chunked transfer encoding, like the core does
+    _chunked = true;
+    sendHeader("Accept-Ranges", "none");
+    sendHeader("Transfer-Encoding", "chunked");
+  }
+  sendHeader("Connection", "close");
+
+  response += _responseHeaders;
+  response += "\r\n";
+  _responseHeaders = "";
+}
+
+void ESP8266WebServer::send(int code, const char* content_type, const String& content)
+{
+  String header;
+  if (content.length() == 0 && _contentLength == CONTENT_LENGTH_NOT_SET) _contentLength = 0;
+  _prepareHeader(header, code, content_type, content.length());
+  _currentClient.write((const uint8_t*) header.c_str(), header.length());
+  if (content.length()) sendContent(content);
+}
+
+void ESP8266WebServer::send_P(int code, PGM_P content_type, PGM_P content)
+{
+  send(code, content_type, String(content));
+}
+
+void ESP8266WebServer::send_P(int code, PGM_P content_type, PGM_P content, size_t contentLength)
+{
+  send(code, content_type, String(std::string(content, contentLength)));
+}
+
+void ESP8266WebServer::sendContent(const String& content)
+{
+  const char* footer = "\r\n";
+  size_t len = content.length();
+  if (_chunked) {
+    char chunkSize[11];
+    snprintf(chunkSize, sizeof(chunkSize), "%zx\r\n", len);
+    _currentClient.write((const uint8_t*) chunkSize, strlen(chunkSize));
+  }
+  _currentClient.write((const uint8_t*) content.c_str(), len);
+  if (_chunked) {
+    _currentClient.write((const uint8_t*) footer, 2);
+    if (len == 0) _chunked = false;
+  }
+}
+
+void ESP8266WebServer::sendContent_P(PGM_P content)
+{
+  sendContent(String(content));
+}
+
+void ESP8266WebServer::sendContent_P(PGM_P content, size_t size)
+{
+  sendContent(String(std::string(content, size)));
+}
+
+String ESP8266WebServer::urlDecode(const String& text)
+{
+  std::string decoded;
+  std::string s = text.c_str();
+  for (size_t i = 0; i < s.length(); i++) {
+    if (s[i] == '%' && i + 2 < s.length()) {
+      decoded += (char) strtol(s.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    } else if (s[i] == '+') {
+      decoded += ' ';
+    } else {
+      decoded += s[i];
+    }
+  }
+  return String(decoded);
+}
+
+WiFiClient ESP8266WebServer::hostEnqueue(const HostRequest& request)
+{
+  Pending pending;
+  pending.request = request;
+  pending.client = WiFiClient(std::make_shared<WiFiClient::Buffer>());
+  _queue.push_back(pending);
+  return pending.client;
+}
+
+void ESP8266WebServer::handleClient()
+{
+  if (_queue.empty()) return;
+
+  Pending pending = _queue.front();
+  _queue.pop_front();
+  _handleRequest(pending);
+}
+
+void ESP8266WebServer::_handleRequest(Pending& pending)
+{
+  const HostRequest& request = pending.request;
+
+  _currentClient = pending.client;
+  _currentMethod = request.method;
+  _currentUri = request.uri;
+  _currentArgs = request.args;
+  _currentHeaders = request.headers;
+  _contentLength = CONTENT_LENGTH_NOT_SET;
+  _responseHeaders = "";
+  _chunked = false;
+
+  RequestHandler* handler = nullptr;
+  for (handler = _firstHandler; handler; handler = handler->next()) {
+    if (handler->canHandle(_currentMethod, _currentUri)) break;
+  }
+
+  if (request.hasUpload) {
+    _currentUpload.filename = request.uploadName;
+    _currentUpload.name = "data";
+    _currentUpload.type = staticContentType(request.uploadName);
+    _currentUpload.totalSize = 0;
+    _currentUpload.currentSize = 0;
+
+    auto deliver = [&](HTTPUploadStatus status) {
+      _currentUpload.status = status;
+      if (_fileUploadHandler) _fileUploadHandler();
+      if (handler && handler->canUpload(_currentUri)) handler->upload(*this, _currentUri, _currentUpload);
+    };
+
+    deliver(UPLOAD_FILE_START);
+    size_t offset = 0;
+    while (offset < request.uploadData.size()) {
+      size_t n = std::min((size_t) HTTP_UPLOAD_BUFLEN, request.uploadData.size() - offset);
+      memcpy(_currentUpload.buf, request.uploadData.data() + offset, n);
+      _currentUpload.currentSize = n;
+      deliver(UPLOAD_FILE_WRITE);
+      _currentUpload.totalSize += n;
+      offset += n;
+    }
+    _currentUpload.currentSize = 0;
+    deliver(UPLOAD_FILE_END);
+  }
+
+  bool handled = handler && handler->handle(*this, _currentMethod, _currentUri);
+  if (!handled) {
+    if (_notFoundHandler) _notFoundHandler();
+    else send(404, "text/plain", String("Not found: ") + _currentUri);
+  }
+
+  _currentClient = WiFiClient();
+}
+
+HostResponse ESP8266WebServer::hostRequest(const HostRequest& request)
+{
+  // anything already queued is served first, as it would be on the device
+  WiFiClient client = hostEnqueue(request);
+  while (!_queue.empty()) handleClient();
+  return hostParseResponse(client.buffer->data);
+}
+
+HostResponse ESP8266WebServer::hostRequest(HTTPMethod method, const String& uri,
+                                           std::vector<std::pair<String, String>> args,
+                                           std::map<String, String> headers)
+{
+  HostRequest request;
+  request.method = method;
+  request.uri = uri;
+  request.args = args;
+  request.headers = headers;
+  return hostRequest(request);
+}
+
+HostResponse hostParseResponse(const std::string& raw)
+{
+  HostResponse response;
+  response.raw = raw;
+
+  size_t headerEnd = raw.find("\r\n\r\n");
+  if (headerEnd == std::string::npos) return response;
+
+  size_t lineEnd = raw.find("\r\n");
+  sscanf(raw.c_str(), "HTTP/1.1 %d", &response.code);
+
+  size_t pos = lineEnd + 2;
+  while (pos < headerEnd) {
+    size_t next = raw.find("\r\n", pos);
+    std::string line = raw.substr(pos, next - pos);
+    size_t colon = line.find(": ");
+    if (colon != std::string::npos) {
+      response.headers[String(line.substr(0, colon))] = String(line.substr(colon + 2));
+    }
+    pos = next + 2;
+  }
+
+  std::string body = raw.substr(headerEnd + 4);
+  if (response.header("Transfer-Encoding") == "chunked") {
+    size_t p = 0;
+    while (p < body.size()) {
+      size_t eol = body.find("\r\n", p);
+      if (eol == std::string::npos) break;
+      size_t len = strtoul(body.substr(p, eol - p).c_str(), nullptr, 16);
+      if (len == 0) {
+        response.complete = true;
+        break;
+      }
+      if (eol + 2 + len > body.size()) break;
+      response.body += body.substr(eol + 2, len);
+      p = eol + 2 + len + 2;
+    }
+  } else {
+    response.body = body;
+    String length = response.header("Content-Length");
+    response.complete = length.length() == 0 || body.size() >= (size_t) length.toInt();
+  }
+  return response;
+}
@@ -0,0 +1,198 @@
+// Host stand-in for ESP8266WebServer.
+//
+// Requests are injected with hostEnqueue()/hostRequest() instead of coming
+// from a socket; handleClient() dispatches at most one queued request per
+// call, like the real server, and responses are written as raw HTTP into
+// the request's WiFiClient buffer so tests see exactly what a browser would.
+
+#pragma once
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+#include "FS.h"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+
+#define HTTP_DOWNLOAD_UNIT_SIZE 1460
+#define HTTP_UPLOAD_BUFLEN 2048
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+#define CONTENT_LENGTH_NOT_SET ((size_t) -2)
+
+struct HTTPUpload {
+  HTTPUploadStatus status;
+  String filename;
+  String name;
+  String type;
+  size_t totalSize;
+  size_t currentSize;
+  uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+class ESP8266WebServer;
+
+class RequestHandler {
+  public:
+    virtual ~RequestHandler() {}
+    virtual bool canHandle(HTTPMethod method, String uri) { (void) method; (void) uri; return false; }
+    virtual bool canUpload(String uri) { (void) uri; return false; }
+    virtual bool handle(ESP8266WebServer& server, HTTPMethod requestMethod, String requestUri)
+    {
+      (void) server; (void) requestMethod; (void) requestUri;
+      return false;
+    }
+    virtual void upload(ESP8266WebServer& server, String requestUri, HTTPUpload& upload)
+    {
+      (void) server; (void) requestUri; (void) upload;
+    }
+
+    RequestHandler* next() { return _next; }
+    void next(RequestHandler* r) { _next = r; }
+
+  private:
+    RequestHandler* _next = nullptr;
+};
+
+// A request as injected by the host runner.
+struct HostRequest {
+  HTTPMethod method = HTTP_GET;
+  String uri;
+  std::vector<std::pair<String, String>> args;
+  std::map<String, String> headers;
+  // optional file upload (POST multipart) delivered to the upload handler
+  bool hasUpload = false;
+  String uploadName;
+  std::string uploadData;
+};
+
+// A parsed response, decoded from the raw bytes on the client.
+struct HostResponse {
+  int code = 0;
+  std::map<String, String> headers;
+  std::string body;
+  std::string raw;
+  bool complete = false;
+
+  String header(const String& name) const
+  {
+    auto it = headers.find(name);
+    return it == headers.end() ? String() : it->second;
+  }
+};
+
+HostResponse hostParseResponse(const std::string& raw);
+
+class ESP8266WebServer {
+  public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    ESP8266WebServer(int port = 80) : _port(port) {}
+    ~ESP8266WebServer();
+
+    void begin() {}
+    void close() {}
+    void stop() {}
+    void handleClient();
+
+    void on(const String& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const String& uri, HTTPMethod method, THandlerFunction fn) { on(uri, method, fn, nullptr); }
+    void on(const String& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
+    void addHandler(RequestHandler* handler);
+    void serveStatic(const char* uri, FS& fs, const char* path, const char* cache_header = NULL);
+    void onNotFound(THandlerFunction fn) { _notFoundHandler = fn; }
+    void onFileUpload(THandlerFunction fn) { _fileUploadHandler = fn; }
+
+    String uri() { return _currentUri; }
+    HTTPMethod method() { return _currentMethod; }
+    WiFiClient client() { return _currentClient; }
+    HTTPUpload& upload() { return _currentUpload; }
+
+    String arg(const String& name);
+    String arg(int i);
+    String argName(int i);
+    int args() { return (int) _currentArgs.size(); }
+    bool hasArg(const String& name);
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount) { (void) headerKeys; (void) headerKeysCount; }
+    String header(const String& name);
+    String header(int i);
+    String headerName(int i);
+    int headers() { return (int) _currentHeaders.size(); }
+    bool hasHeader(const String& name);
+    String hostHeader() { return "127.0.0.1"; }
+
+    void send(int code, const char* content_type = NULL, const String& content = String(""));
+    void send(int code, char* content_type, const String& content) { send(code, (const char*) content_type, content); }
+    void send(int code, const String& content_type, const String& content) { send(code, content_type.c_str(), content); }
+    void send_P(int code, PGM_P content_type, PGM_P content);
+    void send_P(int code, PGM_P content_type, PGM_P content, size_t contentLength);
+
+    void setContentLength(size_t contentLength) { _contentLength = contentLength; }
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void sendContent(const String& content);
+    void sendContent_P(PGM_P content);
+    void sendContent_P(PGM_P content, size_t size);
+
+    static String urlDecode(const String& text);
+
+    template <typename T> size_t streamFile(T& file, const String& contentType)
+    {
+      setContentLength(file.size());
+      if (String(file.name()).endsWith(".gz") && contentType != "application/x-gzip" && contentType != "application/octet-stream") {
+        sendHeader("Content-Encoding", "gzip");
+      }
+      send(200, contentType, "");
+
+      size_t sent = 0;
+      uint8_t buffer[HTTP_DOWNLOAD_UNIT_SIZE];
+      size_t n;
+      while ((n = file.read(buffer, sizeof(buffer))) > 0) {
+        sent += _currentClient.write(buffer, n);
+      }
+      return sent;
+    }
+
+    // host: queue a request for the next handleClient() call and return
+    // the client its response will be written to
+    WiFiClient hostEnqueue(const HostRequest& request);
+    // host: queue a request, dispatch it right away and parse what was written
+    HostResponse hostRequest(const HostRequest& request);
+    HostResponse hostRequest(HTTPMethod method, const String& uri,
+                             std::vector<std::pair<String, String>> args = {},
+                             std::map<String, String> headers = {});
+    size_t hostPending() { return _queue.size(); }
+
+  protected:
+    void _prepareHeader(String& response, int code, const char* content_type, size_t contentLength);
+    bool _chunked = false;
+
+  private:
+    struct Pending {
+      HostRequest request;
+      WiFiClient client;
+    };
+
+    int _port;
+    RequestHandler* _firstHandler = nullptr;
+    RequestHandler* _lastHandler = nullptr;
+    THandlerFunction _notFoundHandler;
+    THandlerFunction _fileUploadHandler;
+
+    std::deque<Pending> _queue;
+
+    WiFiClient _currentClient;
+    HTTPMethod _currentMethod = HTTP_GET;
+    String _currentUri;
+    std::vector<std::pair<String, String>> _currentArgs;
+    std::map<String, String> _currentHeaders;
+    HTTPUpload _currentUpload;
+
+    size_t _contentLength = CONTENT_LENGTH_NOT_SET;
+    String _responseHeaders;
+
+    void _handleRequest(Pending& pending);
+};
@@ -0,0 +1,131 @@
+// Host stand-in for ESP8266WiFi.  There is no radio: WiFi reports itself
+// as connected on 127.0.0.1 so network code paths run, and WiFiClient is
+// an in-memory sink the web server shim uses to capture responses.
+
+#pragma once
+
+#include "Arduino.h"
+
+#include <memory>
+
+#define WL_MAC_ADDR_LENGTH 6
+
+typedef enum {
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum WiFiMode {
+  WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3
+} WiFiMode_t;
+
+typedef enum WiFiSleepType {
+  WIFI_NONE_SLEEP = 0, WIFI_LIGHT_SLEEP = 1, WIFI_MODEM_SLEEP = 2
+} WiFiSleepType_t;
+
+class IPAddress {
+  public:
+    IPAddress() : addr(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : addr(a | (b << 8) | (c << 16) | ((uint32_t) d << 24)) {}
+    IPAddress(uint32_t address) : addr(address) {}
+
+    operator uint32_t() const { return addr; }
+    uint8_t operator[](int index) const { return (addr >> (index * 8)) & 0xFF; }
+    bool operator==(const IPAddress& rhs) const { return addr == rhs.addr; }
+    bool operator!=(const IPAddress& rhs) const { return addr != rhs.addr; }
+    bool isSet() const { return addr != 0; }
+
+    bool fromString(const char* address)
+    {
+      unsigned a, b, c, d;
+      if (sscanf(address, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) return false;
+      *this = IPAddress(a, b, c, d);
+      return true;
+    }
+
+    String toString() const
+    {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+      return String(buf);
+    }
+
+  private:
+    uint32_t addr; // network byte order, as on the ESP8266
+};
+
+// A client whose output lands in a shared buffer.  Copies share the
+// buffer, so a handler can hold on to webServer.client() between frames.
+class WiFiClient : public Stream {
+  public:
+    struct Buffer {
+      std::string data;
+      bool connected = true;
+      size_t window = 0; // 0: unlimited, otherwise bytes the "socket" accepts
+    };
+
+    WiFiClient() {}
+    WiFiClient(std::shared_ptr<Buffer> buffer) : buffer(buffer) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) override
+    {
+      if (!buffer || !buffer->connected) return 0;
+      buffer->data.append((const char*) buf, size);
+      return size;
+    }
+    using Print::write;
+
+    // free space in the emulated TCP send window
+    size_t availableForWrite()
+    {
+      if (!buffer || !buffer->connected) return 0;
+      return buffer->window ? buffer->window : 2920;
+    }
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() {}
+    void stop() { if (buffer) buffer->connected = false; }
+    uint8_t connected() { return buffer && buffer->connected; }
+    operator bool() { return connected(); }
+    void setNoDelay(bool) {}
+    IPAddress remoteIP() { return IPAddress(127, 0, 0, 1); }
+
+    std::shared_ptr<Buffer> buffer;
+};
+
+class WiFiClass {
+  public:
+    WiFiMode_t mode() { return _mode; }
+    bool mode(WiFiMode_t m) { _mode = m; return true; }
+    bool setSleepMode(WiFiSleepType_t) { return true; }
+    bool hostname(const String&) { return true; }
+    wl_status_t begin(const char*, const char* = NULL) { return WL_CONNECTED; }
+    wl_status_t status() { return WL_CONNECTED; }
+    String SSID() { return String("host"); }
+    int32_t RSSI() { return -55; }
+    bool softAP(const char*, const char* = NULL) { return true; }
+    uint8_t* softAPmacAddress(uint8_t* mac)
+    {
+      static const uint8_t hostMac[WL_MAC_ADDR_LENGTH] = { 0x5c, 0xcf, 0x7f, 0x19, 0x20, 0xf7 };
+      memcpy(mac, hostMac, WL_MAC_ADDR_LENGTH);
+      return mac;
+    }
+    uint8_t* macAddress(uint8_t* mac) { return softAPmacAddress(mac); }
+    IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+    IPAddress softAPIP() { return IPAddress(127, 0, 0, 1); }
+    IPAddress subnetMask() { return IPAddress(255, 0, 0, 0); }
+
+  private:
+    WiFiMode_t _mode = WIFI_STA;
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,14 @@
+// Host stand-in for ESP8266mDNS: announcements are accepted and ignored.
+
+#pragma once
+
+#include "Arduino.h"
+
+class MDNSResponder {
+  public:
+    bool begin(const char* hostname) { (void) hostname; return true; }
+    void addService(const char* service, const char* proto, uint16_t port) { (void) service; (void) proto; (void) port; }
+    void update() {}
+};
+
+extern MDNSResponder MDNS;
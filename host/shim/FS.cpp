@@ -0,0 +1,152 @@
+#include "FS.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+FS SPIFFS;
+
+static String spiffsRoot;
+
+static const String& root()
+{
+  if (!spiffsRoot.length()) {
+    const char* env = getenv("SPIFFS_ROOT");
+    spiffsRoot = env ? env : "data";
+  }
+  return spiffsRoot;
+}
+
+void hostSetSpiffsRoot(const String& path)
+{
+  spiffsRoot = path;
+}
+
+String hostSpiffsPath(const String& path)
+{
+  return root() + (path.startsWith("/") ? path : "/" + path);
+}
+
+static void listFiles(const String& dir, const String& prefix, std::vector<String>& names)
+{
+  DIR* d = opendir(dir.c_str());
+  if (!d) return;
+
+  while (struct dirent* entry = readdir(d)) {
+    String name = entry->d_name;
+    if (name == "." || name == "..") continue;
+
+    String full = dir + "/" + name;
+    struct stat st;
+    if (stat(full.c_str(), &st) != 0) continue;
+
+    if (S_ISDIR(st.st_mode)) {
+      listFiles(full, prefix + name + "/", names);
+    } else {
+      names.push_back(prefix + name);
+    }
+  }
+  closedir(d);
+}
+
+static void makeParents(const String& path)
+{
+  for (int i = 1; i < (int) path.length(); i++) {
+    if (path[i] == '/') {
+      mkdir(path.substring(0, i).c_str(), 0755);
+    }
+  }
+}
+
+size_t Dir::fileSize() const
+{
+  struct stat st;
+  return stat(hostSpiffsPath(names[index]).c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+File Dir::openFile(const char* mode) const
+{
+  return SPIFFS.open(names[index], mode);
+}
+
+bool FS::begin()
+{
+  mkdir(root().c_str(), 0755);
+  return true;
+}
+
+bool FS::format()
+{
+  std::vector<String> names;
+  listFiles(root(), "/", names);
+  for (const String& name : names) remove(name);
+  return true;
+}
+
+bool FS::info(FSInfo& info)
+{
+  std::vector<String> names;
+  listFiles(root(), "/", names);
+
+  size_t used = 0;
+  for (const String& name : names) {
+    struct stat st;
+    if (stat(hostSpiffsPath(name).c_str(), &st) == 0) used += st.st_size;
+  }
+
+  info.totalBytes = 3 * 1024 * 1024;
+  info.usedBytes = used;
+  info.blockSize = 8192;
+  info.pageSize = 256;
+  info.maxOpenFiles = 5;
+  info.maxPathLength = 32;
+  return true;
+}
+
+File FS::open(const String& path, const char* mode)
+{
+  String full = hostSpiffsPath(path);
+  bool write = mode[0] != 'r' || strchr(mode, '+');
+  if (write) makeParents(full);
+
+  String fmode = String(mode);
+  if (fmode.indexOf('b') < 0) fmode += "b";
+
+  FILE* fp = fopen(full.c_str(), fmode.c_str());
+  if (!fp) return File();
+  return File(fp, path.startsWith("/") ? path : "/" + path, write);
+}
+
+bool FS::exists(const String& path)
+{
+  existsCalls++;
+  struct stat st;
+  return stat(hostSpiffsPath(path).c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+Dir FS::openDir(const String& path)
+{
+  std::vector<String> names;
+  listFiles(root(), "/", names);
+  std::sort(names.begin(), names.end());
+
+  std::vector<String> matches;
+  for (const String& name : names) {
+    if (name.startsWith(path)) matches.push_back(name);
+  }
+  return Dir(matches);
+}
+
+bool FS::remove(const String& path)
+{
+  return unlink(hostSpiffsPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const String& pathFrom, const String& pathTo)
+{
+  String to = hostSpiffsPath(pathTo);
+  makeParents(to);
+  return ::rename(hostSpiffsPath(pathFrom).c_str(), to.c_str()) == 0;
+}
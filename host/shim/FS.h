@@ -0,0 +1,119 @@
+// Host stand-in for the ESP8266 FS / SPIFFS API, backed by a directory.
+//
+// SPIFFS is flat, so file names are the full path ("/js/app.js") and
+// openDir() lists every file whose name starts with the given prefix.
+// The backing directory defaults to ./data and can be changed with
+// hostSetSpiffsRoot() or the SPIFFS_ROOT environment variable.
+
+#pragma once
+
+#include "Arduino.h"
+
+#include <memory>
+#include <vector>
+
+enum SeekMode {
+  SeekSet = 0,
+  SeekCur = 1,
+  SeekEnd = 2
+};
+
+class File : public Stream {
+  public:
+    File() {}
+    File(FILE* fp, const String& name, bool write) : fp(fp, fclose), fileName(name), writable(write) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) override { return fp && writable ? fwrite(buf, 1, size, fp.get()) : 0; }
+    using Print::write;
+
+    int available() override { return fp ? (int)(size() - position()) : 0; }
+    int read() override { uint8_t c; return read(&c, 1) == 1 ? c : -1; }
+    int peek() override
+    {
+      if (!fp) return -1;
+      int c = fgetc(fp.get());
+      if (c != EOF) ungetc(c, fp.get());
+      return c == EOF ? -1 : c;
+    }
+    size_t read(uint8_t* buf, size_t size) { return fp ? fread(buf, 1, size, fp.get()) : 0; }
+    size_t readBytes(char* buffer, size_t length) { return read((uint8_t*) buffer, length); }
+    String readString()
+    {
+      String s;
+      int c;
+      while ((c = read()) >= 0) s += (char) c;
+      return s;
+    }
+
+    bool seek(uint32_t pos, SeekMode mode = SeekSet) { return fp && fseek(fp.get(), pos, mode) == 0; }
+    size_t position() const { return fp ? ftell(fp.get()) : 0; }
+    size_t size() const
+    {
+      if (!fp) return 0;
+      long pos = ftell(fp.get());
+      fseek(fp.get(), 0, SEEK_END);
+      long end = ftell(fp.get());
+      fseek(fp.get(), pos, SEEK_SET);
+      return end;
+    }
+    void flush() { if (fp) fflush(fp.get()); }
+    void close() { fp.reset(); }
+    const char* name() const { return fileName.c_str(); }
+    operator bool() const { return (bool) fp; }
+
+  private:
+    std::shared_ptr<FILE> fp;
+    String fileName;
+    bool writable = false;
+};
+
+class Dir {
+  public:
+    Dir() {}
+    Dir(std::vector<String> names) : names(names) {}
+
+    bool next() { return ++index < (int) names.size(); }
+    String fileName() const { return names[index]; }
+    size_t fileSize() const;
+    File openFile(const char* mode) const;
+
+  private:
+    std::vector<String> names;
+    int index = -1;
+};
+
+struct FSInfo {
+  size_t totalBytes;
+  size_t usedBytes;
+  size_t blockSize;
+  size_t pageSize;
+  size_t maxOpenFiles;
+  size_t maxPathLength;
+};
+
+class FS {
+  public:
+    bool begin();
+    void end() {}
+    bool format();
+    bool info(FSInfo& info);
+
+    File open(const String& path, const char* mode);
+    File open(const char* path, const char* mode) { return open(String(path), mode); }
+    bool exists(const String& path);
+    bool exists(const char* path) { return exists(String(path)); }
+    Dir openDir(const String& path);
+    Dir openDir(const char* path) { return openDir(String(path)); }
+    bool remove(const String& path);
+    bool remove(const char* path) { return remove(String(path)); }
+    bool rename(const String& pathFrom, const String& pathTo);
+
+    // counts calls to exists(), so tests can check the request path
+    uint32_t existsCalls = 0;
+};
+
+extern FS SPIFFS;
+
+void hostSetSpiffsRoot(const String& path);
+String hostSpiffsPath(const String& path);
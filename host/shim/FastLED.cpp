@@ -0,0 +1,858 @@
+#include "FastLED.h"
+
+uint16_t rand16seed = RAND16_SEED;
+
+CFastLED FastLED;
+
+std::function<void(const CRGB* leds, int count, uint8_t brightness)> hostShowHook;
+
+///////////////////////////////////////////////////////////////////////
+// trig8 / trig16 (portable C versions)
+
+int16_t sin16_C(uint16_t theta)
+{
+  static const uint16_t base[] = { 0, 6393, 12539, 18204, 23170, 27245, 30273, 32137 };
+  static const uint8_t slope[] = { 49, 48, 44, 38, 31, 23, 14, 4 };
+
+  uint16_t offset = (theta & 0x3FFF) >> 3; // 0..2047
+  if (theta & 0x4000) offset = 2047 - offset;
+
+  uint8_t section = offset / 256; // 0..7
+  uint16_t b = base[section];
+  uint8_t m = slope[section];
+
+  uint8_t secoffset8 = (uint8_t)(offset) / 2;
+
+  uint16_t mx = m * secoffset8;
+  int16_t y = mx + b;
+
+  if (theta & 0x8000) y = -y;
+
+  return y;
+}
+
+static const uint8_t b_m16_interleave[] = { 0, 49, 49, 41, 90, 27, 117, 10 };
+
+uint8_t sin8_C(uint8_t theta)
+{
+  uint8_t offset = theta;
+  if (theta & 0x40) {
+    offset = (uint8_t) 255 - offset;
+  }
+  offset &= 0x3F; // 0..63
+
+  uint8_t secoffset = offset & 0x0F; // 0..15
+  if (theta & 0x40) secoffset++;
+
+  uint8_t section = offset >> 4; // 0..3
+  uint8_t s2 = section * 2;
+  const uint8_t* p = b_m16_interleave;
+  p += s2;
+  uint8_t b = *p;
+  p++;
+  uint8_t m16 = *p;
+
+  uint8_t mx = (m16 * secoffset) >> 4;
+
+  int8_t y = mx + b;
+  if (theta & 0x80) y = -y;
+
+  y += 128;
+
+  return y;
+}
+
+///////////////////////////////////////////////////////////////////////
+// noise (FASTLED_NOISE_FIXED)
+
+static const uint8_t p[] = {
+  151, 160, 137, 91, 90, 15,
+  131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23,
+  190, 6, 148, 247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32, 57, 177, 33,
+  88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175, 74, 165, 71, 134, 139, 48, 27, 166,
+  77, 146, 158, 231, 83, 111, 229, 122, 60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244,
+  102, 143, 54, 65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169, 200, 196,
+  135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64, 52, 217, 226, 250, 124, 123,
+  5, 202, 38, 147, 118, 126, 255, 82, 85, 212, 207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42,
+  223, 183, 170, 213, 119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9,
+  129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104, 218, 246, 97, 228,
+  251, 34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241, 81, 51, 145, 235, 249, 14, 239, 107,
+  49, 192, 214, 31, 181, 199, 106, 157, 184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254,
+  138, 236, 205, 93, 222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180, 151
+};
+
+#define P(x) p[(uint8_t)(x)]
+#define EASE8(x) (ease8InOutQuad(x))
+
+static inline int8_t selectBasedOnHashBit(uint8_t hash, uint8_t bitnumber, int8_t a, int8_t b)
+{
+  return (hash & (1 << bitnumber)) ? a : b;
+}
+
+static inline int8_t grad8(uint8_t hash, int8_t x, int8_t y, int8_t z)
+{
+  hash &= 0xF;
+
+  int8_t u, v;
+  u = selectBasedOnHashBit(hash, 3, y, x);
+  v = hash < 4 ? y : hash == 12 || hash == 14 ? x : z;
+
+  if (hash & 1) { u = -u; }
+  if (hash & 2) { v = -v; }
+
+  return avg7(u, v);
+}
+
+static inline int8_t grad8(uint8_t hash, int8_t x, int8_t y)
+{
+  int8_t u, v;
+  if (hash & 4) {
+    u = y; v = x;
+  } else {
+    u = x; v = y;
+  }
+
+  if (hash & 1) { u = -u; }
+  if (hash & 2) { v = -v; }
+
+  return avg7(u, v);
+}
+
+static inline int8_t grad8(uint8_t hash, int8_t x)
+{
+  int8_t u, v;
+  if (hash & 8) {
+    u = x; v = x;
+  } else {
+    if (hash & 4) {
+      u = 1; v = x;
+    } else {
+      u = x; v = 1;
+    }
+  }
+
+  if (hash & 1) { u = -u; }
+  if (hash & 2) { v = -v; }
+
+  return avg7(u, v);
+}
+
+int8_t inoise8_raw(uint16_t x, uint16_t y, uint16_t z)
+{
+  // Find the unit cube containing the point
+  uint8_t X = x >> 8;
+  uint8_t Y = y >> 8;
+  uint8_t Z = z >> 8;
+
+  // Hash cube corner coordinates
+  uint8_t A = P(X) + Y;
+  uint8_t AA = P(A) + Z;
+  uint8_t AB = P(A + 1) + Z;
+  uint8_t B = P(X + 1) + Y;
+  uint8_t BA = P(B) + Z;
+  uint8_t BB = P(B + 1) + Z;
+
+  // Get the relative position of the point in the cube
+  uint8_t u = x;
+  uint8_t v = y;
+  uint8_t w = z;
+
+  // Get a signed version of the above for the grad function
+  int8_t xx = ((uint8_t)(x) >> 1) & 0x7F;
+  int8_t yy = ((uint8_t)(y) >> 1) & 0x7F;
+  int8_t zz = ((uint8_t)(z) >> 1) & 0x7F;
+  uint8_t N = 0x80;
+
+  u = EASE8(u); v = EASE8(v); w = EASE8(w);
+
+  int8_t X1 = lerp7by8(grad8(P(AA), xx, yy, zz), grad8(P(BA), xx - N, yy, zz), u);
+  int8_t X2 = lerp7by8(grad8(P(AB), xx, yy - N, zz), grad8(P(BB), xx - N, yy - N, zz), u);
+  int8_t X3 = lerp7by8(grad8(P(AA + 1), xx, yy, zz - N), grad8(P(BA + 1), xx - N, yy, zz - N), u);
+  int8_t X4 = lerp7by8(grad8(P(AB + 1), xx, yy - N, zz - N), grad8(P(BB + 1), xx - N, yy - N, zz - N), u);
+
+  int8_t Y1 = lerp7by8(X1, X2, v);
+  int8_t Y2 = lerp7by8(X3, X4, v);
+
+  int8_t ans = lerp7by8(Y1, Y2, w);
+
+  return ans;
+}
+
+uint8_t inoise8(uint16_t x, uint16_t y, uint16_t z)
+{
+  int8_t n = inoise8_raw(x, y, z); // -64..+64
+  n += 64;                         //   0..128
+  uint8_t ans = qadd8(n, n);       //   0..255
+  return ans;
+}
+
+int8_t inoise8_raw(uint16_t x, uint16_t y)
+{
+  // Find the unit cube containing the point
+  uint8_t X = x >> 8;
+  uint8_t Y = y >> 8;
+
+  // Hash cube corner coordinates
+  uint8_t A = P(X) + Y;
+  uint8_t AA = P(A);
+  uint8_t AB = P(A + 1);
+  uint8_t B = P(X + 1) + Y;
+  uint8_t BA = P(B);
+  uint8_t BB = P(B + 1);
+
+  // Get the relative position of the point in the cube
+  uint8_t u = x;
+  uint8_t v = y;
+
+  // Get a signed version of the above for the grad function
+  int8_t xx = ((uint8_t)(x) >> 1) & 0x7F;
+  int8_t yy = ((uint8_t)(y) >> 1) & 0x7F;
+  uint8_t N = 0x80;
+
+  u = EASE8(u); v = EASE8(v);
+
+  int8_t X1 = lerp7by8(grad8(P(AA), xx, yy), grad8(P(BA), xx - N, yy), u);
+  int8_t X2 = lerp7by8(grad8(P(AB), xx, yy - N), grad8(P(BB), xx - N, yy - N), u);
+
+  int8_t ans = lerp7by8(X1, X2, v);
+
+  return ans;
+}
+
+uint8_t inoise8(uint16_t x, uint16_t y)
+{
+  int8_t n = inoise8_raw(x, y); // -64..+64
+  n += 64;                      //   0..128
+  uint8_t ans = qadd8(n, n);    //   0..255
+  return ans;
+}
+
+int8_t inoise8_raw(uint16_t x)
+{
+  // Find the unit cube containing the point
+  uint8_t X = x >> 8;
+
+  // Hash cube corner coordinates
+  uint8_t A = P(X);
+  uint8_t AA = P(A);
+  uint8_t B = P(X + 1);
+  uint8_t BA = P(B);
+
+  // Get the relative position of the point in the cube
+  uint8_t u = x;
+
+  // Get a signed version of the above for the grad function
+  int8_t xx = ((uint8_t)(x) >> 1) & 0x7F;
+  uint8_t N = 0x80;
+
+  u = EASE8(u);
+
+  int8_t ans = lerp7by8(grad8(P(AA), xx), grad8(P(BA), xx - N), u);
+
+  return ans;
+}
+
+uint8_t inoise8(uint16_t x)
+{
+  int8_t n = inoise8_raw(x); // -64..+64
+  n += 64;                   //   0..128
+  uint8_t ans = qadd8(n, n); //   0..255
+  return ans;
+}
+
+///////////////////////////////////////////////////////////////////////
+// hsv2rgb
+
+void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb)
+{
+  const uint8_t K255 = 255;
+  const uint8_t K171 = 171;
+  const uint8_t K170 = 170;
+  const uint8_t K85 = 85;
+
+  uint8_t hue = hsv.hue;
+  uint8_t sat = hsv.sat;
+  uint8_t val = hsv.val;
+
+  uint8_t offset = hue & 0x1F; // 0..31
+
+  // offset8 = offset * 8
+  uint8_t offset8 = offset;
+  offset8 <<= 3;
+
+  uint8_t third = scale8(offset8, (256 / 3)); // max = 85
+
+  uint8_t r, g, b;
+
+  if (!(hue & 0x80)) {
+    // 0XX
+    if (!(hue & 0x40)) {
+      // 00X
+      // section 0-1
+      if (!(hue & 0x20)) {
+        // 000
+        // case 0: // R -> O
+        r = K255 - third;
+        g = third;
+        b = 0;
+      } else {
+        // 001
+        // case 1: // O -> Y
+        r = K171;
+        g = K85 + third;
+        b = 0;
+      }
+    } else {
+      // 01X
+      // section 2-3
+      if (!(hue & 0x20)) {
+        // 010
+        // case 2: // Y -> G
+        uint8_t twothirds = scale8(offset8, ((256 * 2) / 3)); // max=170
+        r = K171 - twothirds;
+        g = K170 + third;
+        b = 0;
+      } else {
+        // 011
+        // case 3: // G -> A
+        r = 0;
+        g = K255 - third;
+        b = third;
+      }
+    }
+  } else {
+    // section 4-7
+    // 1XX
+    if (!(hue & 0x40)) {
+      // 10X
+      if (!(hue & 0x20)) {
+        // 100
+        // case 4: // A -> B
+        r = 0;
+        uint8_t twothirds = scale8(offset8, ((256 * 2) / 3)); // max=170
+        g = K171 - twothirds;
+        b = K85 + twothirds;
+      } else {
+        // 101
+        // case 5: // B -> P
+        r = third;
+        g = 0;
+        b = K255 - third;
+      }
+    } else {
+      if (!(hue & 0x20)) {
+        // 110
+        // case 6: // P -- K
+        r = K85 + third;
+        g = 0;
+        b = K171 - third;
+      } else {
+        // 111
+        // case 7: // K -> R
+        r = K170 + third;
+        g = 0;
+        b = K85 - third;
+      }
+    }
+  }
+
+  // Scale down colors if we're desaturated at all
+  // and add the brightness_floor to r, g, and b.
+  if (sat != 255) {
+    if (sat == 0) {
+      r = 255; b = 255; g = 255;
+    } else {
+      if (r) r = scale8(r, sat);
+      if (g) g = scale8(g, sat);
+      if (b) b = scale8(b, sat);
+
+      uint8_t desat = 255 - sat;
+      desat = scale8(desat, desat);
+
+      uint8_t brightness_floor = desat;
+      r += brightness_floor;
+      g += brightness_floor;
+      b += brightness_floor;
+    }
+  }
+
+  // Now scale everything down if we're at value < 255.
+  if (val != 255) {
+    val = scale8_video(val, val);
+    if (val == 0) {
+      r = 0; g = 0; b = 0;
+    } else {
+      if (r) r = scale8(r, val);
+      if (g) g = scale8(g, val);
+      if (b) b = scale8(b, val);
+    }
+  }
+
+  rgb.r = r;
+  rgb.g = g;
+  rgb.b = b;
+}
+
+void hsv2rgb_rainbow(const CHSV* phsv, CRGB* prgb, int numLeds)
+{
+  for (int i = 0; i < numLeds; i++) {
+    hsv2rgb_rainbow(phsv[i], prgb[i]);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+// colorutils
+
+void fill_solid(CRGB* leds, int numToFill, const CRGB& color)
+{
+  for (int i = 0; i < numToFill; i++) {
+    leds[i] = color;
+  }
+}
+
+void fill_solid(CHSV* targetArray, int numToFill, const CHSV& hsvColor)
+{
+  for (int i = 0; i < numToFill; i++) {
+    targetArray[i] = hsvColor;
+  }
+}
+
+void fill_rainbow(CRGB* pFirstLED, int numToFill, uint8_t initialhue, uint8_t deltahue)
+{
+  CHSV hsv;
+  hsv.hue = initialhue;
+  hsv.val = 255;
+  hsv.sat = 240;
+  for (int i = 0; i < numToFill; i++) {
+    pFirstLED[i] = hsv;
+    hsv.hue += deltahue;
+  }
+}
+
+void fill_gradient_RGB(CRGB* leds, uint16_t startpos, CRGB startcolor, uint16_t endpos, CRGB endcolor)
+{
+  // if the points are in the wrong order, straighten them
+  if (endpos < startpos) {
+    uint16_t t = endpos;
+    CRGB tc = endcolor;
+    endcolor = startcolor;
+    endpos = startpos;
+    startpos = t;
+    startcolor = tc;
+  }
+
+  saccum87 rdistance87;
+  saccum87 gdistance87;
+  saccum87 bdistance87;
+
+  rdistance87 = (endcolor.r - startcolor.r) << 7;
+  gdistance87 = (endcolor.g - startcolor.g) << 7;
+  bdistance87 = (endcolor.b - startcolor.b) << 7;
+
+  uint16_t pixeldistance = endpos - startpos;
+  int16_t divisor = pixeldistance ? pixeldistance : 1;
+
+  saccum87 rdelta87 = rdistance87 / divisor;
+  saccum87 gdelta87 = gdistance87 / divisor;
+  saccum87 bdelta87 = bdistance87 / divisor;
+
+  rdelta87 *= 2;
+  gdelta87 *= 2;
+  bdelta87 *= 2;
+
+  accum88 r88 = startcolor.r << 8;
+  accum88 g88 = startcolor.g << 8;
+  accum88 b88 = startcolor.b << 8;
+  for (uint16_t i = startpos; i <= endpos; i++) {
+    leds[i] = CRGB(r88 >> 8, g88 >> 8, b88 >> 8);
+    r88 += rdelta87;
+    g88 += gdelta87;
+    b88 += bdelta87;
+  }
+}
+
+void fill_gradient_RGB(CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB& c2)
+{
+  uint16_t last = numLeds - 1;
+  fill_gradient_RGB(leds, 0, c1, last, c2);
+}
+
+void fill_gradient_RGB(CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB& c2, const CRGB& c3)
+{
+  uint16_t half = (numLeds / 2);
+  uint16_t last = numLeds - 1;
+  fill_gradient_RGB(leds, 0, c1, half, c2);
+  fill_gradient_RGB(leds, half, c2, last, c3);
+}
+
+void fill_gradient_RGB(CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB& c2, const CRGB& c3, const CRGB& c4)
+{
+  uint16_t onethird = (numLeds / 3);
+  uint16_t twothirds = ((numLeds * 2) / 3);
+  uint16_t last = numLeds - 1;
+  fill_gradient_RGB(leds, 0, c1, onethird, c2);
+  fill_gradient_RGB(leds, onethird, c2, twothirds, c3);
+  fill_gradient_RGB(leds, twothirds, c3, last, c4);
+}
+
+void nscale8_video(CRGB* leds, uint16_t num_leds, uint8_t scale)
+{
+  for (uint16_t i = 0; i < num_leds; i++) {
+    leds[i].nscale8_video(scale);
+  }
+}
+
+void fade_video(CRGB* leds, uint16_t num_leds, uint8_t fadeBy)
+{
+  nscale8_video(leds, num_leds, 255 - fadeBy);
+}
+
+void fadeLightBy(CRGB* leds, uint16_t num_leds, uint8_t fadeBy)
+{
+  nscale8_video(leds, num_leds, 255 - fadeBy);
+}
+
+void nscale8(CRGB* leds, uint16_t num_leds, uint8_t scale)
+{
+  for (uint16_t i = 0; i < num_leds; i++) {
+    leds[i].nscale8(scale);
+  }
+}
+
+void fadeToBlackBy(CRGB* leds, uint16_t num_leds, uint8_t fadeBy)
+{
+  nscale8(leds, num_leds, 255 - fadeBy);
+}
+
+void fade_raw(CRGB* leds, uint16_t num_leds, uint8_t fadeBy)
+{
+  nscale8(leds, num_leds, 255 - fadeBy);
+}
+
+void blur1d(CRGB* leds, uint16_t numLeds, fract8 blur_amount)
+{
+  uint8_t keep = 255 - blur_amount;
+  uint8_t seep = blur_amount >> 1;
+  CRGB carryover = CRGB::Black;
+  for (uint16_t i = 0; i < numLeds; i++) {
+    CRGB cur = leds[i];
+    CRGB part = cur;
+    part.nscale8(seep);
+    cur.nscale8(keep);
+    cur += carryover;
+    if (i) leds[i - 1] += part;
+    leds[i] = cur;
+    carryover = part;
+  }
+}
+
+CRGB& nblend(CRGB& existing, const CRGB& overlay, fract8 amountOfOverlay)
+{
+  if (amountOfOverlay == 0) {
+    return existing;
+  }
+
+  if (amountOfOverlay == 255) {
+    existing = overlay;
+    return existing;
+  }
+
+  fract8 amountOfKeep = 255 - amountOfOverlay;
+
+  existing.red = scale8_LEAVING_R1_DIRTY(existing.red, amountOfKeep) + scale8_LEAVING_R1_DIRTY(overlay.red, amountOfOverlay);
+  existing.green = scale8_LEAVING_R1_DIRTY(existing.green, amountOfKeep) + scale8_LEAVING_R1_DIRTY(overlay.green, amountOfOverlay);
+  existing.blue = scale8_LEAVING_R1_DIRTY(existing.blue, amountOfKeep) + scale8_LEAVING_R1_DIRTY(overlay.blue, amountOfOverlay);
+
+  cleanup_R1();
+
+  return existing;
+}
+
+void nblend(CRGB* existing, CRGB* overlay, uint16_t count, fract8 amountOfOverlay)
+{
+  for (uint16_t i = count; i; i--) {
+    nblend(*existing, *overlay, amountOfOverlay);
+    existing++;
+    overlay++;
+  }
+}
+
+CRGB blend(const CRGB& p1, const CRGB& p2, fract8 amountOfP2)
+{
+  CRGB nu(p1);
+  nblend(nu, p2, amountOfP2);
+  return nu;
+}
+
+CRGB* blend(const CRGB* src1, const CRGB* src2, CRGB* dest, uint16_t count, fract8 amountOfsrc2)
+{
+  for (uint16_t i = 0; i < count; i++) {
+    dest[i] = blend(src1[i], src2[i], amountOfsrc2);
+  }
+  return dest;
+}
+
+void fill_palette(CRGB* L, uint16_t N, uint8_t startIndex, uint8_t incIndex,
+                  const CRGBPalette16& pal, uint8_t brightness, TBlendType blendType)
+{
+  uint8_t colorIndex = startIndex;
+  for (uint16_t i = 0; i < N; i++) {
+    L[i] = ColorFromPalette(pal, colorIndex, brightness, blendType);
+    colorIndex += incIndex;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+// palettes
+
+CRGB ColorFromPalette(const CRGBPalette16& pal, uint8_t index, uint8_t brightness, TBlendType blendType)
+{
+  uint8_t hi4 = index >> 4;
+  uint8_t lo4 = index & 0x0F;
+
+  // const CRGB* entry = &(pal[0]) + hi4;
+  // since hi4 is always 0..15, hi4 * sizeof(CRGB) can be a single-byte value,
+  // instead of the two byte 'int' that avr-gcc defaults to.
+  // So, we multiply hi4 X sizeof(CRGB), giving hi4XsizeofCRGB;
+  const CRGB* entry = &(pal[0]) + hi4;
+
+  uint8_t red1 = entry->red;
+  uint8_t green1 = entry->green;
+  uint8_t blue1 = entry->blue;
+
+  uint8_t blend = lo4 && (blendType != NOBLEND);
+
+  if (blend) {
+    if (hi4 == 15) {
+      entry = &(pal[0]);
+    } else {
+      entry++;
+    }
+
+    uint8_t f2 = lo4 << 4;
+    uint8_t f1 = 255 - f2;
+
+    // rgb1.nscale8(f1);
+    uint8_t red2 = entry->red;
+    red1 = scale8_LEAVING_R1_DIRTY(red1, f1);
+    red2 = scale8_LEAVING_R1_DIRTY(red2, f2);
+    red1 += red2;
+
+    uint8_t green2 = entry->green;
+    green1 = scale8_LEAVING_R1_DIRTY(green1, f1);
+    green2 = scale8_LEAVING_R1_DIRTY(green2, f2);
+    green1 += green2;
+
+    uint8_t blue2 = entry->blue;
+    blue1 = scale8_LEAVING_R1_DIRTY(blue1, f1);
+    blue2 = scale8_LEAVING_R1_DIRTY(blue2, f2);
+    blue1 += blue2;
+
+    cleanup_R1();
+  }
+
+  if (brightness != 255) {
+    if (brightness) {
+      brightness++; // adjust for rounding
+      // Now, since brightness is nonzero, we don't need the full scale8_video logic;
+      // we can just to scale8 and then add one (unless scale8 fixed) to all nonzero inputs.
+      if (red1) {
+        red1 = scale8_LEAVING_R1_DIRTY(red1, brightness);
+      }
+      if (green1) {
+        green1 = scale8_LEAVING_R1_DIRTY(green1, brightness);
+      }
+      if (blue1) {
+        blue1 = scale8_LEAVING_R1_DIRTY(blue1, brightness);
+      }
+      cleanup_R1();
+    } else {
+      red1 = 0;
+      green1 = 0;
+      blue1 = 0;
+    }
+  }
+
+  return CRGB(red1, green1, blue1);
+}
+
+CRGBPalette16& CRGBPalette16::operator=(TProgmemRGBGradientPalette_bytes progpal)
+{
+  // entries are { index, r, g, b }, terminated by index 255
+  const uint8_t* progent = progpal;
+
+  // Count entries
+  uint16_t count = 0;
+  do {
+    count++;
+  } while (progent[(count - 1) * 4] != 255);
+
+  int8_t lastSlotUsed = -1;
+
+  CRGB rgbstart(progent[1], progent[2], progent[3]);
+
+  int indexstart = 0;
+  uint8_t istart8 = 0;
+  uint8_t iend8 = 0;
+  while (indexstart < 255) {
+    progent += 4;
+    int indexend = progent[0];
+    CRGB rgbend(progent[1], progent[2], progent[3]);
+    istart8 = indexstart / 16;
+    iend8 = indexend / 16;
+    if (count < 16) {
+      if ((istart8 <= lastSlotUsed) && (lastSlotUsed < 15)) {
+        istart8 = lastSlotUsed + 1;
+        if (iend8 < istart8) {
+          iend8 = istart8;
+        }
+      }
+      lastSlotUsed = iend8;
+    }
+    fill_gradient_RGB(&(entries[0]), istart8, rgbstart, iend8, rgbend);
+    indexstart = indexend;
+    rgbstart = rgbend;
+  }
+  return *this;
+}
+
+void nblendPaletteTowardPalette(CRGBPalette16& current, CRGBPalette16& target, uint8_t maxChanges)
+{
+  uint8_t* p1;
+  uint8_t* p2;
+  uint8_t changes = 0;
+
+  p1 = (uint8_t*) current.entries;
+  p2 = (uint8_t*) target.entries;
+
+  const uint8_t totalChannels = sizeof(CRGBPalette16);
+  for (uint8_t i = 0; i < totalChannels; i++) {
+    // if the values are equal, no changes are needed
+    if (p1[i] == p2[i]) { continue; }
+
+    // if the current value is less than the target, increase it by one
+    if (p1[i] < p2[i]) { p1[i]++; changes++; }
+
+    // if the current value is greater than the target,
+    // increase it by one (or two if it's still greater).
+    if (p1[i] > p2[i]) {
+      p1[i]--; changes++;
+      if (p1[i] > p2[i]) { p1[i]--; }
+    }
+
+    // if we've hit the maximum number of changes, exit
+    if (changes >= maxChanges) { break; }
+  }
+}
+
+extern const TProgmemRGBPalette16 CloudColors_p FL_PROGMEM =
+{
+  CRGB::Blue, CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue,
+  CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue,
+  CRGB::Blue, CRGB::DarkBlue, CRGB::SkyBlue, CRGB::SkyBlue,
+  CRGB::LightBlue, CRGB::White, CRGB::LightBlue, CRGB::SkyBlue
+};
+
+extern const TProgmemRGBPalette16 LavaColors_p FL_PROGMEM =
+{
+  CRGB::Black, CRGB::Maroon, CRGB::Black, CRGB::Maroon,
+  CRGB::DarkRed, CRGB::Maroon, CRGB::DarkRed,
+  CRGB::DarkRed, CRGB::DarkRed, CRGB::Red, CRGB::Orange,
+  CRGB::White, CRGB::Orange, CRGB::Red, CRGB::DarkRed
+};
+
+extern const TProgmemRGBPalette16 OceanColors_p FL_PROGMEM =
+{
+  CRGB::MidnightBlue, CRGB::DarkBlue, CRGB::MidnightBlue, CRGB::Navy,
+  CRGB::DarkBlue, CRGB::MediumBlue, CRGB::SeaGreen, CRGB::Teal,
+  CRGB::CadetBlue, CRGB::Blue, CRGB::DarkCyan, CRGB::CornflowerBlue,
+  CRGB::Aquamarine, CRGB::SeaGreen, CRGB::Aqua, CRGB::LightSkyBlue
+};
+
+extern const TProgmemRGBPalette16 ForestColors_p FL_PROGMEM =
+{
+  CRGB::DarkGreen, CRGB::DarkGreen, CRGB::DarkOliveGreen, CRGB::DarkGreen,
+  CRGB::Green, CRGB::ForestGreen, CRGB::OliveDrab, CRGB::Green,
+  CRGB::SeaGreen, CRGB::MediumAquamarine, CRGB::LimeGreen, CRGB::YellowGreen,
+  CRGB::LightGreen, CRGB::LawnGreen, CRGB::MediumAquamarine, CRGB::ForestGreen
+};
+
+extern const TProgmemRGBPalette16 RainbowColors_p FL_PROGMEM =
+{
+  0xFF0000, 0xD52A00, 0xAB5500, 0xAB7F00,
+  0xABAB00, 0x56D500, 0x00FF00, 0x00D52A,
+  0x00AB55, 0x0056AA, 0x0000FF, 0x2A00D5,
+  0x5500AB, 0x7F0081, 0xAB0055, 0xD5002B
+};
+
+extern const TProgmemRGBPalette16 RainbowStripeColors_p FL_PROGMEM =
+{
+  0xFF0000, 0x000000, 0xAB5500, 0x000000,
+  0xABAB00, 0x000000, 0x00FF00, 0x000000,
+  0x00AB55, 0x000000, 0x0000FF, 0x000000,
+  0x5500AB, 0x000000, 0xAB0055, 0x000000
+};
+
+extern const TProgmemRGBPalette16 PartyColors_p FL_PROGMEM =
+{
+  0x5500AB, 0x84007C, 0xB5004B, 0xE5001B,
+  0xE81700, 0xB84700, 0xAB7700, 0xABAB00,
+  0xAB5500, 0xDD2200, 0xF2000E, 0xC2003E,
+  0x8F0071, 0x5F00A1, 0x2F00D0, 0x0007F9
+};
+
+extern const TProgmemRGBPalette16 HeatColors_p FL_PROGMEM =
+{
+  0x000000,
+  0x330000, 0x660000, 0x990000, 0xCC0000, 0xFF0000,
+  0xFF3300, 0xFF6600, 0xFF9900, 0xFFCC00, 0xFFFF00,
+  0xFFFF33, 0xFFFF66, 0xFFFF99, 0xFFFFCC, 0xFFFFFF
+};
+
+///////////////////////////////////////////////////////////////////////
+// controller
+
+void CFastLED::show(uint8_t scale)
+{
+  static uint32_t lastFrame = 0;
+  static uint16_t frames = 0;
+
+  if (hostShowHook && m_controller.leds) {
+    hostShowHook(m_controller.leds, m_controller.count, scale);
+  }
+
+  frames++;
+  uint32_t now = millis();
+  if (now - lastFrame >= 1000) {
+    m_nFPS = frames;
+    frames = 0;
+    lastFrame = now;
+  }
+}
+
+void CFastLED::clear(bool writeData)
+{
+  clearData();
+  if (writeData) show();
+}
+
+void CFastLED::clearData()
+{
+  if (m_controller.leds) {
+    memset(m_controller.leds, 0, sizeof(CRGB) * m_controller.count);
+  }
+}
+
+void CFastLED::showColor(const CRGB& color, uint8_t scale)
+{
+  if (m_controller.leds) {
+    fill_solid(m_controller.leds, m_controller.count, color);
+  }
+  show(scale);
+}
+
+void CFastLED::delay(unsigned long ms)
+{
+  show();
+  ::delay(ms);
+}
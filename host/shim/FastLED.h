@@ -0,0 +1,1153 @@
+// Host (Linux) stand-in for the parts of FastLED 3.1 the sketches use.
+//
+// The math follows FastLED's portable C code paths (lib8tion with
+// FASTLED_SCALE8_FIXED, hsv2rgb_rainbow, ColorFromPalette, the Perlin noise
+// tables with FASTLED_NOISE_FIXED), so patterns rendered on the host match
+// the device bit for bit as long as they are fed the same inputs.
+//
+// FastLED.show() does not drive any pins: it hands the registered LED array
+// to hostShowHook so the runner can capture frames.
+
+#pragma once
+
+#include "Arduino.h"
+
+#define FASTLED_VERSION 3001000
+#define FASTLED_NAMESPACE_BEGIN
+#define FASTLED_NAMESPACE_END
+#define FASTLED_USING_NAMESPACE
+#define FL_PROGMEM
+#define LIB8STATIC static inline
+#define LIB8STATIC_ALWAYS_INLINE static inline
+
+#ifdef USE_GET_MILLISECOND_TIMER
+uint32_t get_millisecond_timer();
+#define GET_MILLIS get_millisecond_timer
+#else
+#define GET_MILLIS millis
+#endif
+
+typedef uint8_t fract8;
+typedef uint16_t fract16;
+typedef int8_t sfract7;
+typedef int16_t sfract15;
+typedef uint16_t accum88;
+typedef int16_t saccum78;
+typedef uint32_t accum1616;
+typedef int32_t saccum1516;
+typedef uint16_t accum124;
+typedef int32_t saccum114;
+typedef int16_t saccum87;
+
+///////////////////////////////////////////////////////////////////////
+// lib8tion
+
+LIB8STATIC uint8_t qadd8(uint8_t i, uint8_t j) { unsigned t = i + j; return t > 255 ? 255 : t; }
+LIB8STATIC int8_t qadd7(int8_t i, int8_t j) { int t = i + j; return t > 127 ? 127 : t; }
+LIB8STATIC uint8_t qsub8(uint8_t i, uint8_t j) { int t = i - j; return t < 0 ? 0 : t; }
+LIB8STATIC uint8_t add8(uint8_t i, uint8_t j) { return i + j; }
+LIB8STATIC uint16_t add8to16(uint8_t i, uint16_t j) { return i + j; }
+LIB8STATIC uint8_t sub8(uint8_t i, uint8_t j) { return i - j; }
+LIB8STATIC uint8_t avg8(uint8_t i, uint8_t j) { return (i + j) >> 1; }
+LIB8STATIC uint16_t avg16(uint16_t i, uint16_t j) { return (uint32_t)((uint32_t)(i) + (uint32_t)(j)) >> 1; }
+LIB8STATIC int8_t avg7(int8_t i, int8_t j) { return ((i >> 1) + (j >> 1)) + (i & 0x1); }
+LIB8STATIC int16_t avg15(int16_t i, int16_t j) { return ((int32_t)((int32_t)(i) >> 1) + (int32_t)((int32_t)(j) >> 1)) + (i & 0x1); }
+LIB8STATIC int8_t abs8(int8_t i) { return i < 0 ? -i : i; }
+
+LIB8STATIC uint8_t addmod8(uint8_t a, uint8_t b, uint8_t m)
+{
+  a += b;
+  while (a >= m) a -= m;
+  return a;
+}
+
+LIB8STATIC uint8_t submod8(uint8_t a, uint8_t b, uint8_t m)
+{
+  a -= b;
+  while (a >= m) a -= m;
+  return a;
+}
+
+LIB8STATIC uint8_t mul8(uint8_t i, uint8_t j) { return ((int) i * (int)(j)) & 0xFF; }
+LIB8STATIC uint8_t qmul8(uint8_t i, uint8_t j) { int p = ((int) i * (int)(j)); return p > 255 ? 255 : p; }
+
+LIB8STATIC uint8_t scale8(uint8_t i, fract8 scale) { return (((uint16_t) i) * (1 + (uint16_t)(scale))) >> 8; }
+LIB8STATIC uint8_t scale8_LEAVING_R1_DIRTY(uint8_t i, fract8 scale) { return scale8(i, scale); }
+LIB8STATIC uint8_t scale8_video(uint8_t i, fract8 scale) { return (((int) i * (int) scale) >> 8) + ((i && scale) ? 1 : 0); }
+LIB8STATIC uint8_t scale8_video_LEAVING_R1_DIRTY(uint8_t i, fract8 scale) { return scale8_video(i, scale); }
+LIB8STATIC void cleanup_R1() {}
+
+LIB8STATIC void nscale8x3(uint8_t& r, uint8_t& g, uint8_t& b, fract8 scale)
+{
+  uint16_t scale_fixed = scale + 1;
+  r = (((uint16_t) r) * scale_fixed) >> 8;
+  g = (((uint16_t) g) * scale_fixed) >> 8;
+  b = (((uint16_t) b) * scale_fixed) >> 8;
+}
+
+LIB8STATIC void nscale8x3_video(uint8_t& r, uint8_t& g, uint8_t& b, fract8 scale)
+{
+  uint8_t nonzeroscale = (scale != 0) ? 1 : 0;
+  r = (r == 0) ? 0 : (((int) r * (int)(scale)) >> 8) + nonzeroscale;
+  g = (g == 0) ? 0 : (((int) g * (int)(scale)) >> 8) + nonzeroscale;
+  b = (b == 0) ? 0 : (((int) b * (int)(scale)) >> 8) + nonzeroscale;
+}
+
+LIB8STATIC uint16_t scale16by8(uint16_t i, fract8 scale) { return (i * (1 + ((uint16_t) scale))) >> 8; }
+LIB8STATIC uint16_t scale16(uint16_t i, fract16 scale) { return ((uint32_t)(i) * (1 + (uint32_t)(scale))) / 65536; }
+
+LIB8STATIC uint8_t dim8_raw(uint8_t x) { return scale8(x, x); }
+LIB8STATIC uint8_t dim8_video(uint8_t x) { return scale8_video(x, x); }
+LIB8STATIC uint8_t dim8_lin(uint8_t x)
+{
+  if (x & 0x80) {
+    x = scale8(x, x);
+  } else {
+    x += 1;
+    x /= 2;
+  }
+  return x;
+}
+LIB8STATIC uint8_t brighten8_raw(uint8_t x) { uint8_t ix = 255 - x; return 255 - scale8(ix, ix); }
+LIB8STATIC uint8_t brighten8_video(uint8_t x) { uint8_t ix = 255 - x; return 255 - scale8_video(ix, ix); }
+
+LIB8STATIC uint8_t lerp8by8(uint8_t a, uint8_t b, fract8 frac)
+{
+  uint8_t result;
+  if (b > a) {
+    uint8_t delta = b - a;
+    uint8_t scaled = scale8(delta, frac);
+    result = a + scaled;
+  } else {
+    uint8_t delta = a - b;
+    uint8_t scaled = scale8(delta, frac);
+    result = a - scaled;
+  }
+  return result;
+}
+
+LIB8STATIC uint16_t lerp16by16(uint16_t a, uint16_t b, fract16 frac)
+{
+  uint16_t result;
+  if (b > a) {
+    uint16_t delta = b - a;
+    uint16_t scaled = scale16(delta, frac);
+    result = a + scaled;
+  } else {
+    uint16_t delta = a - b;
+    uint16_t scaled = scale16(delta, frac);
+    result = a - scaled;
+  }
+  return result;
+}
+
+LIB8STATIC uint16_t lerp16by8(uint16_t a, uint16_t b, fract8 frac)
+{
+  uint16_t result;
+  if (b > a) {
+    uint16_t delta = b - a;
+    uint16_t scaled = scale16by8(delta, frac);
+    result = a + scaled;
+  } else {
+    uint16_t delta = a - b;
+    uint16_t scaled = scale16by8(delta, frac);
+    result = a - scaled;
+  }
+  return result;
+}
+
+LIB8STATIC int8_t lerp7by8(int8_t a, int8_t b, fract8 frac)
+{
+  int8_t result;
+  if (b > a) {
+    uint8_t delta = b - a;
+    uint8_t scaled = scale8(delta, frac);
+    result = a + scaled;
+  } else {
+    uint8_t delta = a - b;
+    uint8_t scaled = scale8(delta, frac);
+    result = a - scaled;
+  }
+  return result;
+}
+
+LIB8STATIC uint8_t map8(uint8_t in, uint8_t rangeStart, uint8_t rangeEnd)
+{
+  uint8_t rangeWidth = rangeEnd - rangeStart;
+  uint8_t out = scale8(in, rangeWidth);
+  out += rangeStart;
+  return out;
+}
+
+LIB8STATIC uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB)
+{
+  uint16_t partial;
+  uint8_t result;
+  uint8_t amountOfA = 255 - amountOfB;
+
+  partial = (a * amountOfA);
+  partial += a;
+  partial += (b * amountOfB);
+  partial += b;
+  result = partial >> 8;
+
+  return result;
+}
+
+LIB8STATIC uint8_t ease8InOutQuad(uint8_t i)
+{
+  uint8_t j = i;
+  if (j & 0x80) {
+    j = 255 - j;
+  }
+  uint8_t jj = scale8(j, j);
+  uint8_t jj2 = jj << 1;
+  if (i & 0x80) {
+    jj2 = 255 - jj2;
+  }
+  return jj2;
+}
+
+LIB8STATIC uint8_t ease8InOutCubic(fract8 i)
+{
+  uint8_t ii = scale8_LEAVING_R1_DIRTY(i, i);
+  uint8_t iii = scale8_LEAVING_R1_DIRTY(ii, i);
+
+  uint16_t r1 = (3 * (uint16_t)(ii)) - (2 * (uint16_t)(iii));
+
+  uint8_t result = r1;
+  if (r1 & 0x100) {
+    result = 255;
+  }
+  return result;
+}
+
+LIB8STATIC uint8_t ease8InOutApprox(fract8 i)
+{
+  if (i < 64) {
+    i /= 2;
+  } else if (i > (255 - 64)) {
+    i = 255 - i;
+    i /= 2;
+    i = 255 - i;
+  } else {
+    i -= 64;
+    i += (i / 2);
+    i += 32;
+  }
+  return i;
+}
+
+LIB8STATIC uint16_t ease16InOutQuad(uint16_t i)
+{
+  uint16_t j = i;
+  if (j & 0x8000) {
+    j = 65535 - j;
+  }
+  uint16_t jj = scale16(j, j);
+  uint16_t jj2 = jj << 1;
+  if (i & 0x8000) {
+    jj2 = 65535 - jj2;
+  }
+  return jj2;
+}
+
+LIB8STATIC uint8_t triwave8(uint8_t in)
+{
+  if (in & 0x80) {
+    in = 255 - in;
+  }
+  uint8_t out = in << 1;
+  return out;
+}
+
+LIB8STATIC uint8_t quadwave8(uint8_t in) { return ease8InOutQuad(triwave8(in)); }
+LIB8STATIC uint8_t cubicwave8(uint8_t in) { return ease8InOutCubic(triwave8(in)); }
+LIB8STATIC uint8_t squarewave8(uint8_t in, uint8_t pulsewidth = 128) { return in < pulsewidth || (pulsewidth == 255) ? 255 : 0; }
+
+LIB8STATIC uint8_t sqrt16(uint16_t x)
+{
+  if (x <= 1) {
+    return x;
+  }
+
+  uint8_t low = 1; // lower bound
+  uint8_t hi, mid;
+
+  if (x > 7904) {
+    hi = 255;
+  } else {
+    hi = (x >> 5) + 8; // initial estimate for upper bound
+  }
+
+  do {
+    mid = (low + hi) >> 1;
+    if ((uint16_t)(mid * mid) > x) {
+      hi = mid - 1;
+    } else {
+      if (mid == 255) {
+        return 255;
+      }
+      low = mid + 1;
+    }
+  } while (hi >= low);
+
+  return low - 1;
+}
+
+// trig
+
+int16_t sin16_C(uint16_t theta);
+uint8_t sin8_C(uint8_t theta);
+
+LIB8STATIC int16_t sin16(uint16_t theta) { return sin16_C(theta); }
+LIB8STATIC int16_t cos16(uint16_t theta) { return sin16(theta + 16384); }
+LIB8STATIC uint8_t sin8(uint8_t theta) { return sin8_C(theta); }
+LIB8STATIC uint8_t cos8(uint8_t theta) { return sin8(theta + 64); }
+
+// random
+
+#define FASTLED_RAND16_2053  ((uint16_t)(2053))
+#define FASTLED_RAND16_13849 ((uint16_t)(13849))
+#define RAND16_SEED  1337
+
+extern uint16_t rand16seed;
+
+LIB8STATIC uint8_t random8()
+{
+  rand16seed = (rand16seed * FASTLED_RAND16_2053) + FASTLED_RAND16_13849;
+  // return the sum of the high and low bytes, for better
+  //  mixing and non-sequential correlation
+  return (uint8_t)(((uint8_t)(rand16seed & 0xFF)) + ((uint8_t)(rand16seed >> 8)));
+}
+
+LIB8STATIC uint16_t random16()
+{
+  rand16seed = (rand16seed * FASTLED_RAND16_2053) + FASTLED_RAND16_13849;
+  return rand16seed;
+}
+
+LIB8STATIC uint8_t random8(uint8_t lim)
+{
+  uint8_t r = random8();
+  r = (r * lim) >> 8;
+  return r;
+}
+
+LIB8STATIC uint8_t random8(uint8_t min, uint8_t lim)
+{
+  uint8_t delta = lim - min;
+  uint8_t r = random8(delta) + min;
+  return r;
+}
+
+LIB8STATIC uint16_t random16(uint16_t lim)
+{
+  uint16_t r = random16();
+  uint32_t p = (uint32_t) lim * (uint32_t) r;
+  r = p >> 16;
+  return r;
+}
+
+LIB8STATIC uint16_t random16(uint16_t min, uint16_t lim)
+{
+  uint16_t delta = lim - min;
+  uint16_t r = random16(delta) + min;
+  return r;
+}
+
+LIB8STATIC void random16_set_seed(uint16_t seed) { rand16seed = seed; }
+LIB8STATIC uint16_t random16_get_seed() { return rand16seed; }
+LIB8STATIC void random16_add_entropy(uint16_t entropy) { rand16seed += entropy; }
+
+// beats
+
+LIB8STATIC uint16_t beat88(accum88 beats_per_minute_88, uint32_t timebase = 0)
+{
+  return (((GET_MILLIS()) - timebase) * beats_per_minute_88 * 280) >> 16;
+}
+
+LIB8STATIC uint16_t beat16(accum88 beats_per_minute, uint32_t timebase = 0)
+{
+  // Convert simple 8-bit BPM's to full Q8.8 accum88's if needed
+  if (beats_per_minute < 256) beats_per_minute <<= 8;
+  return beat88(beats_per_minute, timebase);
+}
+
+LIB8STATIC uint8_t beat8(accum88 beats_per_minute, uint32_t timebase = 0)
+{
+  return beat16(beats_per_minute, timebase) >> 8;
+}
+
+LIB8STATIC uint16_t beatsin88(accum88 beats_per_minute_88, uint16_t lowest = 0, uint16_t highest = 65535,
+                              uint32_t timebase = 0, uint16_t phase_offset = 0)
+{
+  uint16_t beat = beat88(beats_per_minute_88, timebase);
+  uint16_t beatsin = (sin16(beat + phase_offset) + 32768);
+  uint16_t rangewidth = highest - lowest;
+  uint16_t scaledbeat = scale16(beatsin, rangewidth);
+  uint16_t result = lowest + scaledbeat;
+  return result;
+}
+
+LIB8STATIC uint16_t beatsin16(accum88 beats_per_minute, uint16_t lowest = 0, uint16_t highest = 65535,
+                              uint32_t timebase = 0, uint16_t phase_offset = 0)
+{
+  uint16_t beat = beat16(beats_per_minute, timebase);
+  uint16_t beatsin = (sin16(beat + phase_offset) + 32768);
+  uint16_t rangewidth = highest - lowest;
+  uint16_t scaledbeat = scale16(beatsin, rangewidth);
+  uint16_t result = lowest + scaledbeat;
+  return result;
+}
+
+LIB8STATIC uint8_t beatsin8(accum88 beats_per_minute, uint8_t lowest = 0, uint8_t highest = 255,
+                            uint32_t timebase = 0, uint8_t phase_offset = 0)
+{
+  uint8_t beat = beat8(beats_per_minute, timebase);
+  uint8_t beatsin = sin8(beat + phase_offset);
+  uint8_t rangewidth = highest - lowest;
+  uint8_t scaledbeat = scale8(beatsin, rangewidth);
+  uint8_t result = lowest + scaledbeat;
+  return result;
+}
+
+LIB8STATIC uint16_t seconds16() { return GET_MILLIS() / 1000; }
+LIB8STATIC uint16_t minutes16() { return GET_MILLIS() / 60000; }
+
+// noise
+
+uint8_t inoise8(uint16_t x, uint16_t y, uint16_t z);
+uint8_t inoise8(uint16_t x, uint16_t y);
+uint8_t inoise8(uint16_t x);
+int8_t inoise8_raw(uint16_t x, uint16_t y, uint16_t z);
+int8_t inoise8_raw(uint16_t x, uint16_t y);
+int8_t inoise8_raw(uint16_t x);
+
+///////////////////////////////////////////////////////////////////////
+// pixel types
+
+struct CRGB;
+
+struct CHSV {
+  union {
+    struct {
+      union { uint8_t hue; uint8_t h; };
+      union { uint8_t saturation; uint8_t sat; uint8_t s; };
+      union { uint8_t value; uint8_t val; uint8_t v; };
+    };
+    uint8_t raw[3];
+  };
+
+  inline CHSV() {}
+  inline CHSV(uint8_t ih, uint8_t is, uint8_t iv) : h(ih), s(is), v(iv) {}
+  inline uint8_t& operator[](uint8_t x) { return raw[x]; }
+  inline const uint8_t& operator[](uint8_t x) const { return raw[x]; }
+};
+
+typedef enum {
+  HUE_RED = 0,
+  HUE_ORANGE = 32,
+  HUE_YELLOW = 64,
+  HUE_GREEN = 96,
+  HUE_AQUA = 128,
+  HUE_BLUE = 160,
+  HUE_PURPLE = 192,
+  HUE_PINK = 224
+} HSVHue;
+
+void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb);
+void hsv2rgb_rainbow(const CHSV* phsv, CRGB* prgb, int numLeds);
+CHSV rgb2hsv_approximate(const CRGB& rgb);
+
+struct CRGB {
+  union {
+    struct {
+      union { uint8_t r; uint8_t red; };
+      union { uint8_t g; uint8_t green; };
+      union { uint8_t b; uint8_t blue; };
+    };
+    uint8_t raw[3];
+  };
+
+  inline uint8_t& operator[](uint8_t x) { return raw[x]; }
+  inline const uint8_t& operator[](uint8_t x) const { return raw[x]; }
+
+  inline CRGB() {}
+  inline CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+  inline CRGB(uint32_t colorcode) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b((colorcode >> 0) & 0xFF) {}
+  inline CRGB(const CHSV& rhs) { hsv2rgb_rainbow(rhs, *this); }
+
+  inline CRGB& operator=(const CHSV& rhs) { hsv2rgb_rainbow(rhs, *this); return *this; }
+  inline CRGB& operator=(const uint32_t colorcode)
+  {
+    r = (colorcode >> 16) & 0xFF;
+    g = (colorcode >> 8) & 0xFF;
+    b = (colorcode >> 0) & 0xFF;
+    return *this;
+  }
+
+  inline CRGB& setRGB(uint8_t nr, uint8_t ng, uint8_t nb) { r = nr; g = ng; b = nb; return *this; }
+  inline CRGB& setHSV(uint8_t hue, uint8_t sat, uint8_t val) { hsv2rgb_rainbow(CHSV(hue, sat, val), *this); return *this; }
+  inline CRGB& setHue(uint8_t hue) { hsv2rgb_rainbow(CHSV(hue, 255, 255), *this); return *this; }
+  inline CRGB& setColorCode(uint32_t colorcode) { return *this = colorcode; }
+
+  inline CRGB& operator+=(const CRGB& rhs)
+  {
+    r = qadd8(r, rhs.r);
+    g = qadd8(g, rhs.g);
+    b = qadd8(b, rhs.b);
+    return *this;
+  }
+
+  inline CRGB& addToRGB(uint8_t d)
+  {
+    r = qadd8(r, d);
+    g = qadd8(g, d);
+    b = qadd8(b, d);
+    return *this;
+  }
+
+  inline CRGB& operator-=(const CRGB& rhs)
+  {
+    r = qsub8(r, rhs.r);
+    g = qsub8(g, rhs.g);
+    b = qsub8(b, rhs.b);
+    return *this;
+  }
+
+  inline CRGB& subtractFromRGB(uint8_t d)
+  {
+    r = qsub8(r, d);
+    g = qsub8(g, d);
+    b = qsub8(b, d);
+    return *this;
+  }
+
+  inline CRGB& operator--() { subtractFromRGB(1); return *this; }
+  inline CRGB operator--(int) { CRGB retval(*this); --(*this); return retval; }
+  inline CRGB& operator++() { addToRGB(1); return *this; }
+  inline CRGB operator++(int) { CRGB retval(*this); ++(*this); return retval; }
+
+  inline CRGB& operator/=(uint8_t d) { r /= d; g /= d; b /= d; return *this; }
+  inline CRGB& operator>>=(uint8_t d) { r >>= d; g >>= d; b >>= d; return *this; }
+
+  inline CRGB& operator*=(uint8_t d)
+  {
+    r = qmul8(r, d);
+    g = qmul8(g, d);
+    b = qmul8(b, d);
+    return *this;
+  }
+
+  inline CRGB& nscale8_video(uint8_t scaledown) { nscale8x3_video(r, g, b, scaledown); return *this; }
+  inline CRGB& operator%=(uint8_t scaledown) { nscale8x3_video(r, g, b, scaledown); return *this; }
+  inline CRGB& fadeLightBy(uint8_t fadefactor) { nscale8x3_video(r, g, b, 255 - fadefactor); return *this; }
+  inline CRGB& nscale8(uint8_t scaledown) { nscale8x3(r, g, b, scaledown); return *this; }
+
+  inline CRGB& nscale8(const CRGB& scaledown)
+  {
+    r = ::scale8(r, scaledown.r);
+    g = ::scale8(g, scaledown.g);
+    b = ::scale8(b, scaledown.b);
+    return *this;
+  }
+
+  inline CRGB scale8(const CRGB& scaledown) const
+  {
+    CRGB out;
+    out.r = ::scale8(r, scaledown.r);
+    out.g = ::scale8(g, scaledown.g);
+    out.b = ::scale8(b, scaledown.b);
+    return out;
+  }
+
+  inline CRGB& fadeToBlackBy(uint8_t fadefactor) { nscale8x3(r, g, b, 255 - fadefactor); return *this; }
+
+  inline CRGB& operator|=(const CRGB& rhs)
+  {
+    if (rhs.r > r) r = rhs.r;
+    if (rhs.g > g) g = rhs.g;
+    if (rhs.b > b) b = rhs.b;
+    return *this;
+  }
+
+  inline CRGB& operator&=(const CRGB& rhs)
+  {
+    if (rhs.r < r) r = rhs.r;
+    if (rhs.g < g) g = rhs.g;
+    if (rhs.b < b) b = rhs.b;
+    return *this;
+  }
+
+  inline explicit operator bool() const { return r || g || b; }
+
+  inline CRGB operator-() const
+  {
+    CRGB retval;
+    retval.r = 255 - r;
+    retval.g = 255 - g;
+    retval.b = 255 - b;
+    return retval;
+  }
+
+  inline uint8_t getLuma() const
+  {
+    uint8_t luma = ::scale8(r, 54) + ::scale8(g, 183) + ::scale8(b, 18);
+    return luma;
+  }
+
+  inline uint8_t getAverageLight() const
+  {
+    const uint8_t eightysix = 86;
+    uint8_t avg = ::scale8(r, eightysix) + ::scale8(g, eightysix) + ::scale8(b, eightysix);
+    return avg;
+  }
+
+  inline void maximizeBrightness(uint8_t limit = 255)
+  {
+    uint8_t max = red;
+    if (green > max) max = green;
+    if (blue > max) max = blue;
+    if (max == 0) return;
+    uint16_t factor = ((uint16_t)(limit) * 256) / max;
+    red = (red * factor) / 256;
+    green = (green * factor) / 256;
+    blue = (blue * factor) / 256;
+  }
+
+  typedef enum {
+    AliceBlue = 0xF0F8FF,
+    Amethyst = 0x9966CC,
+    AntiqueWhite = 0xFAEBD7,
+    Aqua = 0x00FFFF,
+    Aquamarine = 0x7FFFD4,
+    Azure = 0xF0FFFF,
+    Beige = 0xF5F5DC,
+    Bisque = 0xFFE4C4,
+    Black = 0x000000,
+    BlanchedAlmond = 0xFFEBCD,
+    Blue = 0x0000FF,
+    BlueViolet = 0x8A2BE2,
+    Brown = 0xA52A2A,
+    BurlyWood = 0xDEB887,
+    CadetBlue = 0x5F9EA0,
+    Chartreuse = 0x7FFF00,
+    Chocolate = 0xD2691E,
+    Coral = 0xFF7F50,
+    CornflowerBlue = 0x6495ED,
+    Cornsilk = 0xFFF8DC,
+    Crimson = 0xDC143C,
+    Cyan = 0x00FFFF,
+    DarkBlue = 0x00008B,
+    DarkCyan = 0x008B8B,
+    DarkGoldenrod = 0xB8860B,
+    DarkGray = 0xA9A9A9,
+    DarkGrey = 0xA9A9A9,
+    DarkGreen = 0x006400,
+    DarkKhaki = 0xBDB76B,
+    DarkMagenta = 0x8B008B,
+    DarkOliveGreen = 0x556B2F,
+    DarkOrange = 0xFF8C00,
+    DarkOrchid = 0x9932CC,
+    DarkRed = 0x8B0000,
+    DarkSalmon = 0xE9967A,
+    DarkSeaGreen = 0x8FBC8F,
+    DarkSlateBlue = 0x483D8B,
+    DarkSlateGray = 0x2F4F4F,
+    DarkSlateGrey = 0x2F4F4F,
+    DarkTurquoise = 0x00CED1,
+    DarkViolet = 0x9400D3,
+    DeepPink = 0xFF1493,
+    DeepSkyBlue = 0x00BFFF,
+    DimGray = 0x696969,
+    DimGrey = 0x696969,
+    DodgerBlue = 0x1E90FF,
+    FireBrick = 0xB22222,
+    FloralWhite = 0xFFFAF0,
+    ForestGreen = 0x228B22,
+    Fuchsia = 0xFF00FF,
+    Gainsboro = 0xDCDCDC,
+    GhostWhite = 0xF8F8FF,
+    Gold = 0xFFD700,
+    Goldenrod = 0xDAA520,
+    Gray = 0x808080,
+    Grey = 0x808080,
+    Green = 0x008000,
+    GreenYellow = 0xADFF2F,
+    Honeydew = 0xF0FFF0,
+    HotPink = 0xFF69B4,
+    IndianRed = 0xCD5C5C,
+    Indigo = 0x4B0082,
+    Ivory = 0xFFFFF0,
+    Khaki = 0xF0E68C,
+    Lavender = 0xE6E6FA,
+    LavenderBlush = 0xFFF0F5,
+    LawnGreen = 0x7CFC00,
+    LemonChiffon = 0xFFFACD,
+    LightBlue = 0xADD8E6,
+    LightCoral = 0xF08080,
+    LightCyan = 0xE0FFFF,
+    LightGoldenrodYellow = 0xFAFAD2,
+    LightGreen = 0x90EE90,
+    LightGrey = 0xD3D3D3,
+    LightPink = 0xFFB6C1,
+    LightSalmon = 0xFFA07A,
+    LightSeaGreen = 0x20B2AA,
+    LightSkyBlue = 0x87CEFA,
+    LightSlateGray = 0x778899,
+    LightSlateGrey = 0x778899,
+    LightSteelBlue = 0xB0C4DE,
+    LightYellow = 0xFFFFE0,
+    Lime = 0x00FF00,
+    LimeGreen = 0x32CD32,
+    Linen = 0xFAF0E6,
+    Magenta = 0xFF00FF,
+    Maroon = 0x800000,
+    MediumAquamarine = 0x66CDAA,
+    MediumBlue = 0x0000CD,
+    MediumOrchid = 0xBA55D3,
+    MediumPurple = 0x9370DB,
+    MediumSeaGreen = 0x3CB371,
+    MediumSlateBlue = 0x7B68EE,
+    MediumSpringGreen = 0x00FA9A,
+    MediumTurquoise = 0x48D1CC,
+    MediumVioletRed = 0xC71585,
+    MidnightBlue = 0x191970,
+    MintCream = 0xF5FFFA,
+    MistyRose = 0xFFE4E1,
+    Moccasin = 0xFFE4B5,
+    NavajoWhite = 0xFFDEAD,
+    Navy = 0x000080,
+    OldLace = 0xFDF5E6,
+    Olive = 0x808000,
+    OliveDrab = 0x6B8E23,
+    Orange = 0xFFA500,
+    OrangeRed = 0xFF4500,
+    Orchid = 0xDA70D6,
+    PaleGoldenrod = 0xEEE8AA,
+    PaleGreen = 0x98FB98,
+    PaleTurquoise = 0xAFEEEE,
+    PaleVioletRed = 0xDB7093,
+    PapayaWhip = 0xFFEFD5,
+    PeachPuff = 0xFFDAB9,
+    Peru = 0xCD853F,
+    Pink = 0xFFC0CB,
+    Plaid = 0xCC5533,
+    Plum = 0xDDA0DD,
+    PowderBlue = 0xB0E0E6,
+    Purple = 0x800080,
+    Red = 0xFF0000,
+    RosyBrown = 0xBC8F8F,
+    RoyalBlue = 0x4169E1,
+    SaddleBrown = 0x8B4513,
+    Salmon = 0xFA8072,
+    SandyBrown = 0xF4A460,
+    SeaGreen = 0x2E8B57,
+    Seashell = 0xFFF5EE,
+    Sienna = 0xA0522D,
+    Silver = 0xC0C0C0,
+    SkyBlue = 0x87CEEB,
+    SlateBlue = 0x6A5ACD,
+    SlateGray = 0x708090,
+    SlateGrey = 0x708090,
+    Snow = 0xFFFAFA,
+    SpringGreen = 0x00FF7F,
+    SteelBlue = 0x4682B4,
+    Tan = 0xD2B48C,
+    Teal = 0x008080,
+    Thistle = 0xD8BFD8,
+    Tomato = 0xFF6347,
+    Turquoise = 0x40E0D0,
+    Violet = 0xEE82EE,
+    Wheat = 0xF5DEB3,
+    White = 0xFFFFFF,
+    WhiteSmoke = 0xF5F5F5,
+    Yellow = 0xFFFF00,
+    YellowGreen = 0x9ACD32,
+
+    // LED RGB color that roughly approximates
+    // the color of incandescent fairy lights,
+    // assuming that you're using FastLED
+    // color correction on your LEDs (recommended).
+    FairyLight = 0xFFE42D,
+    // If you are using no color correction, use this
+    FairyLightNCC = 0xFF9D2A
+  } HTMLColorCode;
+
+  inline CRGB(HTMLColorCode colorcode) : CRGB((uint32_t) colorcode) {}
+  inline CRGB& operator=(HTMLColorCode colorcode) { return *this = (uint32_t) colorcode; }
+};
+
+inline bool operator==(const CRGB& lhs, const CRGB& rhs) { return (lhs.r == rhs.r) && (lhs.g == rhs.g) && (lhs.b == rhs.b); }
+inline bool operator!=(const CRGB& lhs, const CRGB& rhs) { return !(lhs == rhs); }
+
+inline CRGB operator+(const CRGB& p1, const CRGB& p2) { return CRGB(qadd8(p1.r, p2.r), qadd8(p1.g, p2.g), qadd8(p1.b, p2.b)); }
+inline CRGB operator-(const CRGB& p1, const CRGB& p2) { return CRGB(qsub8(p1.r, p2.r), qsub8(p1.g, p2.g), qsub8(p1.b, p2.b)); }
+inline CRGB operator*(const CRGB& p1, uint8_t d) { return CRGB(qmul8(p1.r, d), qmul8(p1.g, d), qmul8(p1.b, d)); }
+inline CRGB operator/(const CRGB& p1, uint8_t d) { return CRGB(p1.r / d, p1.g / d, p1.b / d); }
+inline CRGB operator%(const CRGB& p1, uint8_t d) { CRGB retval(p1); retval.nscale8_video(d); return retval; }
+
+enum EOrder { RGB = 0012, RBG = 0021, GRB = 0102, GBR = 0120, BRG = 0201, BGR = 0210 };
+
+typedef enum {
+  TypicalSMD5050 = 0xFFB0F0,
+  TypicalLEDStrip = 0xFFB0F0,
+  Typical8mmPixel = 0xFFE08C,
+  TypicalPixelString = 0xFFE08C,
+  UncorrectedColor = 0xFFFFFF
+} LEDColorCorrection;
+
+typedef enum {
+  Candle = 0xFF9329,
+  Tungsten40W = 0xFFC58F,
+  Tungsten100W = 0xFFD6AA,
+  Halogen = 0xFFF1E0,
+  CarbonArc = 0xFFFAF4,
+  HighNoonSun = 0xFFFFFB,
+  DirectSunlight = 0xFFFFFF,
+  OvercastSky = 0xC9E2FF,
+  ClearBlueSky = 0x409CFF,
+  UncorrectedTemperature = 0xFFFFFF
+} ColorTemperature;
+
+///////////////////////////////////////////////////////////////////////
+// palettes
+
+typedef uint32_t TProgmemRGBPalette16[16];
+typedef uint8_t TProgmemRGBGradientPalette_byte;
+typedef const TProgmemRGBGradientPalette_byte* TProgmemRGBGradientPalette_bytes;
+typedef TProgmemRGBGradientPalette_bytes TProgmemRGBGradientPalettePtr;
+
+#define DEFINE_GRADIENT_PALETTE(X) \
+  extern const TProgmemRGBGradientPalette_byte X[] FL_PROGMEM =
+
+#define DECLARE_GRADIENT_PALETTE(X) \
+  extern const TProgmemRGBGradientPalette_byte X[] FL_PROGMEM
+
+typedef enum { NOBLEND = 0, LINEARBLEND = 1 } TBlendType;
+
+typedef enum { FORWARD_HUES = 0, BACKWARD_HUES = 1, SHORTEST_HUES = 2, LONGEST_HUES = 3 } TGradientDirectionCode;
+
+void fill_gradient_RGB(CRGB* leds, uint16_t startpos, CRGB startcolor, uint16_t endpos, CRGB endcolor);
+void fill_gradient_RGB(CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB& c2);
+void fill_gradient_RGB(CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB& c2, const CRGB& c3);
+void fill_gradient_RGB(CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB& c2, const CRGB& c3, const CRGB& c4);
+
+class CRGBPalette16 {
+  public:
+    CRGB entries[16];
+
+    CRGBPalette16() { memset(entries, 0, sizeof(entries)); }
+    CRGBPalette16(const CRGB& c00, const CRGB& c01, const CRGB& c02, const CRGB& c03,
+                  const CRGB& c04, const CRGB& c05, const CRGB& c06, const CRGB& c07,
+                  const CRGB& c08, const CRGB& c09, const CRGB& c10, const CRGB& c11,
+                  const CRGB& c12, const CRGB& c13, const CRGB& c14, const CRGB& c15)
+    {
+      entries[0] = c00; entries[1] = c01; entries[2] = c02; entries[3] = c03;
+      entries[4] = c04; entries[5] = c05; entries[6] = c06; entries[7] = c07;
+      entries[8] = c08; entries[9] = c09; entries[10] = c10; entries[11] = c11;
+      entries[12] = c12; entries[13] = c13; entries[14] = c14; entries[15] = c15;
+    }
+
+    CRGBPalette16(const CRGBPalette16& rhs) { memmove(entries, rhs.entries, sizeof(entries)); }
+    CRGBPalette16& operator=(const CRGBPalette16& rhs) { memmove(entries, rhs.entries, sizeof(entries)); return *this; }
+
+    CRGBPalette16(const TProgmemRGBPalette16& rhs)
+    {
+      for (uint8_t i = 0; i < 16; i++) entries[i] = rhs[i];
+    }
+    CRGBPalette16& operator=(const TProgmemRGBPalette16& rhs)
+    {
+      for (uint8_t i = 0; i < 16; i++) entries[i] = rhs[i];
+      return *this;
+    }
+
+    CRGBPalette16(const CRGB& c1) { fill_solid(c1); }
+    CRGBPalette16(CRGB::HTMLColorCode c1) { fill_solid(CRGB(c1)); }
+    CRGBPalette16(const CRGB& c1, const CRGB& c2) { fill_gradient_RGB(&(entries[0]), 16, c1, c2); }
+    CRGBPalette16(const CRGB& c1, const CRGB& c2, const CRGB& c3) { fill_gradient_RGB(&(entries[0]), 16, c1, c2, c3); }
+    CRGBPalette16(const CRGB& c1, const CRGB& c2, const CRGB& c3, const CRGB& c4) { fill_gradient_RGB(&(entries[0]), 16, c1, c2, c3, c4); }
+
+    CRGBPalette16(TProgmemRGBGradientPalette_bytes progpal) { *this = progpal; }
+    CRGBPalette16& operator=(TProgmemRGBGradientPalette_bytes progpal);
+
+    bool operator==(const CRGBPalette16& rhs) const { return memcmp(entries, rhs.entries, sizeof(entries)) == 0; }
+    bool operator!=(const CRGBPalette16& rhs) const { return !(*this == rhs); }
+
+    inline CRGB& operator[](uint8_t x) { return entries[x]; }
+    inline const CRGB& operator[](uint8_t x) const { return entries[x]; }
+
+    operator CRGB*() { return &(entries[0]); }
+
+  private:
+    void fill_solid(const CRGB& c) { for (uint8_t i = 0; i < 16; i++) entries[i] = c; }
+};
+
+CRGB ColorFromPalette(const CRGBPalette16& pal, uint8_t index, uint8_t brightness = 255, TBlendType blendType = LINEARBLEND);
+
+void nblendPaletteTowardPalette(CRGBPalette16& currentPalette, CRGBPalette16& targetPalette, uint8_t maxChanges = 24);
+
+extern const TProgmemRGBPalette16 CloudColors_p;
+extern const TProgmemRGBPalette16 LavaColors_p;
+extern const TProgmemRGBPalette16 OceanColors_p;
+extern const TProgmemRGBPalette16 ForestColors_p;
+extern const TProgmemRGBPalette16 RainbowColors_p;
+extern const TProgmemRGBPalette16 RainbowStripeColors_p;
+#define RainbowStripesColors_p RainbowStripeColors_p
+extern const TProgmemRGBPalette16 PartyColors_p;
+extern const TProgmemRGBPalette16 HeatColors_p;
+
+///////////////////////////////////////////////////////////////////////
+// colorutils
+
+void fill_solid(CRGB* leds, int numToFill, const CRGB& color);
+void fill_solid(CHSV* targetArray, int numToFill, const CHSV& hsvColor);
+void fill_rainbow(CRGB* pFirstLED, int numToFill, uint8_t initialhue, uint8_t deltahue = 5);
+void fill_palette(CRGB* L, uint16_t N, uint8_t startIndex, uint8_t incIndex,
+                  const CRGBPalette16& pal, uint8_t brightness = 255, TBlendType blendType = LINEARBLEND);
+
+template <typename T>
+void fill_gradient(T* targetArray, uint16_t startpos, CHSV startcolor, uint16_t endpos, CHSV endcolor,
+                   TGradientDirectionCode directionCode = SHORTEST_HUES)
+{
+  // if the points are in the wrong order, straighten them
+  if (endpos < startpos) {
+    uint16_t t = endpos;
+    CHSV tc = endcolor;
+    endcolor = startcolor;
+    endpos = startpos;
+    startpos = t;
+    startcolor = tc;
+  }
+
+  // If we're fading toward black (val=0) or white (sat=0),
+  // then set the endhue to the starthue.
+  // This lets us ramp smoothly to black or white, regardless
+  // of what 'hue' was set in the endcolor (since it doesn't matter)
+  if (endcolor.value == 0 || endcolor.saturation == 0) {
+    endcolor.hue = startcolor.hue;
+  }
+
+  // Similarly, if we're fading in from black (val=0) or white (sat=0)
+  // then set the starthue to the endhue.
+  if (startcolor.value == 0 || startcolor.saturation == 0) {
+    startcolor.hue = endcolor.hue;
+  }
+
+  saccum87 huedistance87;
+  saccum87 satdistance87;
+  saccum87 valdistance87;
+
+  satdistance87 = (endcolor.sat - startcolor.sat) << 7;
+  valdistance87 = (endcolor.val - startcolor.val) << 7;
+
+  uint8_t huedelta8 = endcolor.hue - startcolor.hue;
+
+  if (directionCode == SHORTEST_HUES) {
+    directionCode = FORWARD_HUES;
+    if (huedelta8 > 127) {
+      directionCode = BACKWARD_HUES;
+    }
+  }
+
+  if (directionCode == LONGEST_HUES) {
+    directionCode = FORWARD_HUES;
+    if (huedelta8 < 128) {
+      directionCode = BACKWARD_HUES;
+    }
+  }
+
+  if (directionCode == FORWARD_HUES) {
+    huedistance87 = huedelta8 << 7;
+  } else /* directionCode == BACKWARD_HUES */ {
+    huedistance87 = (uint8_t)(256 - huedelta8) << 7;
+    huedistance87 = -huedistance87;
+  }
+
+  uint16_t pixeldistance = endpos - startpos;
+  int16_t divisor = pixeldistance ? pixeldistance : 1;
+
+  saccum87 huedelta87 = huedistance87 / divisor;
+  saccum87 satdelta87 = satdistance87 / divisor;
+  saccum87 valdelta87 = valdistance87 / divisor;
+
+  huedelta87 *= 2;
+  satdelta87 *= 2;
+  valdelta87 *= 2;
+
+  accum88 hue88 = startcolor.hue << 8;
+  accum88 sat88 = startcolor.sat << 8;
+  accum88 val88 = startcolor.val << 8;
+  for (uint16_t i = startpos; i <= endpos; i++) {
+    targetArray[i] = CHSV(hue88 >> 8, sat88 >> 8, val88 >> 8);
+    hue88 += huedelta87;
+    sat88 += satdelta87;
+    val88 += valdelta87;
+  }
+}
+
+void fadeToBlackBy(CRGB* leds, uint16_t num_leds, uint8_t fadeBy);
+void fade_raw(CRGB* leds, uint16_t num_leds, uint8_t fadeBy);
+void fadeLightBy(CRGB* leds, uint16_t num_leds, uint8_t fadeBy);
+void fade_video(CRGB* leds, uint16_t num_leds, uint8_t fadeBy);
+void nscale8(CRGB* leds, uint16_t num_leds, uint8_t scale);
+void nscale8_video(CRGB* leds, uint16_t num_leds, uint8_t scale);
+void blur1d(CRGB* leds, uint16_t numLeds, fract8 blur_amount);
+
+CRGB& nblend(CRGB& existing, const CRGB& overlay, fract8 amountOfOverlay);
+void nblend(CRGB* existing, CRGB* overlay, uint16_t count, fract8 amountOfOverlay);
+CRGB blend(const CRGB& p1, const CRGB& p2, fract8 amountOfP2);
+CRGB* blend(const CRGB* src1, const CRGB* src2, CRGB* dest, uint16_t count, fract8 amountOfsrc2);
+
+///////////////////////////////////////////////////////////////////////
+// timers
+
+class CEveryNMillis {
+  public:
+    uint32_t mPrevTrigger;
+    uint32_t mPeriod;
+
+    CEveryNMillis() { reset(); mPeriod = 1; }
+    CEveryNMillis(uint32_t period) { reset(); setPeriod(period); }
+    void setPeriod(uint32_t period) { mPeriod = period; }
+    uint32_t getTime() { return (uint32_t)(GET_MILLIS()); }
+    uint32_t getPeriod() { return mPeriod; }
+    uint32_t getElapsed() { return getTime() - mPrevTrigger; }
+    uint32_t getRemaining() { return mPeriod - getElapsed(); }
+    uint32_t getLastTriggerTime() { return mPrevTrigger; }
+    bool ready()
+    {
+      bool isReady = (getElapsed() >= mPeriod);
+      if (isReady) {
+        reset();
+      }
+      return isReady;
+    }
+    void reset() { mPrevTrigger = getTime(); }
+    void trigger() { mPrevTrigger = getTime() - mPeriod; }
+
+    operator bool() { return ready(); }
+};
+
+class CEveryNSeconds {
+  public:
+    uint16_t mPrevTrigger;
+    uint16_t mPeriod;
+
+    CEveryNSeconds() { reset(); mPeriod = 1; }
+    CEveryNSeconds(uint16_t period) { reset(); setPeriod(period); }
+    void setPeriod(uint16_t period) { mPeriod = period; }
+    uint16_t getTime() { return (uint16_t)(GET_MILLIS() / 1000); }
+    uint16_t getPeriod() { return mPeriod; }
+    uint16_t getElapsed() { return getTime() - mPrevTrigger; }
+    uint16_t getRemaining() { return mPeriod - getElapsed(); }
+    uint16_t getLastTriggerTime() { return mPrevTrigger; }
+    bool ready()
+    {
+      bool isReady = (getElapsed() >= mPeriod);
+      if (isReady) {
+        reset();
+      }
+      return isReady;
+    }
+    void reset() { mPrevTrigger = getTime(); }
+    void trigger() { mPrevTrigger = getTime() - mPeriod; }
+
+    operator bool() { return ready(); }
+};
+
+#define CONCAT_HELPER(x, y) x##y
+#define CONCAT_MACRO(x, y) CONCAT_HELPER(x, y)
+
+#define EVERY_N_MILLIS(N) EVERY_N_MILLIS_I(CONCAT_MACRO(PER, __COUNTER__), N)
+#define EVERY_N_MILLIS_I(NAME, N) static CEveryNMillis NAME(N); if (NAME)
+#define EVERY_N_SECONDS(N) EVERY_N_SECONDS_I(CONCAT_MACRO(PER, __COUNTER__), N)
+#define EVERY_N_SECONDS_I(NAME, N) static CEveryNSeconds NAME(N); if (NAME)
+#define EVERY_N_MILLISECONDS EVERY_N_MILLIS
+#define EVERY_N_MILLISECONDS_I EVERY_N_MILLIS_I
+
+///////////////////////////////////////////////////////////////////////
+// controller
+
+// chipsets: only used as template arguments
+struct WS2812B {};
+struct WS2812 {};
+struct WS2811 {};
+struct NEOPIXEL {};
+struct APA102 {};
+struct SK6812 {};
+
+class CLEDController {
+  public:
+    CRGB* leds = nullptr;
+    int count = 0;
+
+    CLEDController& setCorrection(CRGB) { return *this; }
+    CLEDController& setCorrection(LEDColorCorrection) { return *this; }
+    CLEDController& setDither(uint8_t) { return *this; }
+    CRGB* leds_() { return leds; }
+    int size() { return count; }
+};
+
+// Called from FastLED.show() with the registered array and the global
+// brightness.  Frames are captured raw: brightness is applied by the
+// controller, not written back into leds[].
+extern std::function<void(const CRGB* leds, int count, uint8_t brightness)> hostShowHook;
+
+class CFastLED {
+  public:
+    template <typename CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER = RGB>
+    CLEDController& addLeds(CRGB* data, int nLedsOrOffset, int nLedsIfOffset = 0)
+    {
+      return addController(data, nLedsOrOffset, nLedsIfOffset);
+    }
+
+    template <typename CHIPSET, uint8_t DATA_PIN, uint8_t CLOCK_PIN, EOrder RGB_ORDER>
+    CLEDController& addLeds(CRGB* data, int nLedsOrOffset, int nLedsIfOffset = 0)
+    {
+      return addController(data, nLedsOrOffset, nLedsIfOffset);
+    }
+
+    void setBrightness(uint8_t scale) { m_Scale = scale; }
+    uint8_t getBrightness() { return m_Scale; }
+    void setMaxPowerInVoltsAndMilliamps(uint8_t, uint32_t) {}
+    void setMaxPowerInMilliWatts(uint32_t) {}
+    void setCorrection(const CRGB&) {}
+    void setCorrection(LEDColorCorrection) {}
+    void setTemperature(const CRGB&) {}
+    void setTemperature(ColorTemperature) {}
+    void setDither(uint8_t) {}
+    void setMaxRefreshRate(uint16_t, bool = false) {}
+
+    void show() { show(m_Scale); }
+    void show(uint8_t scale);
+    void clear(bool writeData = false);
+    void clearData();
+    void showColor(const CRGB& color, uint8_t scale);
+    void showColor(const CRGB& color) { showColor(color, m_Scale); }
+    void delay(unsigned long ms);
+
+    int size() { return m_controller.count; }
+    CRGB* leds() { return m_controller.leds; }
+    int count() { return 1; }
+    CLEDController& operator[](int) { return m_controller; }
+
+    uint16_t getFPS() { return m_nFPS; }
+
+  private:
+    CLEDController& addController(CRGB* data, int nLedsOrOffset, int nLedsIfOffset)
+    {
+      int nOffset = (nLedsIfOffset > 0) ? nLedsOrOffset : 0;
+      int nLeds = (nLedsIfOffset > 0) ? nLedsIfOffset : nLedsOrOffset;
+      m_controller.leds = data + nOffset;
+      m_controller.count = nLeds;
+      return m_controller;
+    }
+
+    CLEDController m_controller;
+    uint8_t m_Scale = 255;
+    uint16_t m_nFPS = 0;
+};
+
+extern CFastLED FastLED;
@@ -0,0 +1,71 @@
+// Definitions of the library singletons the sketches expect, and the
+// small Time library stand-in.
+
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "ESP8266WiFi.h"
+#include "ESP8266mDNS.h"
+#include "TimeLib.h"
+
+EEPROMClass EEPROM;
+WiFiClass WiFi;
+MDNSResponder MDNS;
+
+static time_t timeBase = 0;
+static unsigned long timeBaseMillis = 0;
+static bool timeIsSet = false;
+static time_t (*syncProvider)() = nullptr;
+
+time_t now()
+{
+  if (!timeIsSet && syncProvider) {
+    time_t t = syncProvider();
+    if (t) setTime(t);
+  }
+  return timeBase + (millis() - timeBaseMillis) / 1000;
+}
+
+void setTime(time_t t)
+{
+  timeBase = t;
+  timeBaseMillis = millis();
+  timeIsSet = true;
+}
+
+void setTime(int hr, int min, int sec, int dy, int mnth, int yr)
+{
+  struct tm tm = {};
+  tm.tm_hour = hr;
+  tm.tm_min = min;
+  tm.tm_sec = sec;
+  tm.tm_mday = dy;
+  tm.tm_mon = mnth - 1;
+  tm.tm_year = (yr < 100 ? yr + 2000 : yr) - 1900;
+  setTime(timegm(&tm));
+}
+
+timeStatus_t timeStatus() { return timeIsSet ? timeSet : timeNotSet; }
+void setSyncProvider(time_t (*getTimeFunction)()) { syncProvider = getTimeFunction; now(); }
+void setSyncInterval(time_t) {}
+
+static struct tm breakTime(time_t t)
+{
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  return tm;
+}
+
+int hour(time_t t) { return breakTime(t).tm_hour; }
+int minute(time_t t) { return breakTime(t).tm_min; }
+int second(time_t t) { return breakTime(t).tm_sec; }
+int day(time_t t) { return breakTime(t).tm_mday; }
+int weekday(time_t t) { return breakTime(t).tm_wday + 1; }
+int month(time_t t) { return breakTime(t).tm_mon + 1; }
+int year(time_t t) { return breakTime(t).tm_year + 1900; }
+int hour() { return hour(now()); }
+int minute() { return minute(now()); }
+int second() { return second(now()); }
+int day() { return day(now()); }
+int weekday() { return weekday(now()); }
+int month() { return month(now()); }
+int year() { return year(now()); }
@@ -0,0 +1,33 @@
+// Host stand-in for IRremoteESP8266: a receiver that never decodes anything
+// unless the runner injects a code with hostInject().
+
+#pragma once
+
+#include "Arduino.h"
+
+class decode_results {
+  public:
+    int decode_type = 0;
+    unsigned long value = 0;
+    int bits = 0;
+};
+
+class IRrecv {
+  public:
+    IRrecv(int recvpin) { (void) recvpin; }
+
+    void enableIRIn() {}
+    void resume() { pending = 0; }
+    int decode(decode_results* results)
+    {
+      if (!pending) return 0;
+      results->value = pending;
+      results->bits = 32;
+      return 1;
+    }
+
+    void hostInject(unsigned long code) { pending = code; }
+
+  private:
+    unsigned long pending = 0;
+};
@@ -0,0 +1,24 @@
+// Host stand-in for the Time library, following the virtual clock.
+
+#pragma once
+
+#include "Arduino.h"
+
+#include <time.h>
+
+typedef enum { timeNotSet, timeNeedsSync, timeSet } timeStatus_t;
+
+time_t now();
+void setTime(time_t t);
+void setTime(int hr, int min, int sec, int day, int month, int yr);
+timeStatus_t timeStatus();
+void setSyncProvider(time_t (*getTimeFunction)());
+void setSyncInterval(time_t interval);
+
+int hour(); int hour(time_t t);
+int minute(); int minute(time_t t);
+int second(); int second(time_t t);
+int day(); int day(time_t t);
+int weekday(); int weekday(time_t t);
+int month(); int month(time_t t);
+int year(); int year(time_t t);
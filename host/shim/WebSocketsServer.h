@@ -0,0 +1,198 @@
+// Host stand-in for the arduinoWebSockets server.
+//
+// Clients are simulated: hostConnect()/hostDisconnect()/hostSendTXT()/
+// hostSendBIN() queue events that the next loop() delivers to the sketch's
+// event handler, and every frame the sketch sends is recorded per client.
+
+#pragma once
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#include <deque>
+#include <vector>
+
+#define WEBSOCKETS_SERVER_CLIENT_MAX 5
+
+typedef enum {
+  WStype_ERROR,
+  WStype_DISCONNECTED,
+  WStype_CONNECTED,
+  WStype_TEXT,
+  WStype_BIN,
+  WStype_FRAGMENT_TEXT_START,
+  WStype_FRAGMENT_BIN_START,
+  WStype_FRAGMENT,
+  WStype_FRAGMENT_FIN,
+  WStype_PING,
+  WStype_PONG,
+} WStype_t;
+
+class WebSocketsServer {
+  public:
+    typedef std::function<void(uint8_t num, WStype_t type, uint8_t* payload, size_t length)> WebSocketServerEvent;
+
+    struct Frame {
+      bool binary;
+      std::string data;
+    };
+
+    WebSocketsServer(uint16_t port, String origin = "", String protocol = "arduino") : _port(port)
+    {
+      (void) origin; (void) protocol;
+    }
+
+    void begin() {}
+    void close() {}
+    void onEvent(WebSocketServerEvent cbEvent) { _cbEvent = cbEvent; }
+
+    void loop()
+    {
+      // deliver what was queued before this call; handlers may queue more
+      size_t pending = _events.size();
+      while (pending-- && !_events.empty()) {
+        Event event = _events.front();
+        _events.pop_front();
+        if (event.type == WStype_CONNECTED) _clients[event.num].connected = true;
+        if (_cbEvent) _cbEvent(event.num, event.type, (uint8_t*) &event.payload[0], event.payload.size() - 1);
+        if (event.type == WStype_DISCONNECTED) _clients[event.num] = Client();
+      }
+    }
+
+    bool sendTXT(uint8_t num, uint8_t* payload, size_t length = 0, bool headerToPayload = false)
+    {
+      (void) headerToPayload;
+      if (length == 0) length = strlen((const char*) payload);
+      return send(num, false, (const char*) payload, length);
+    }
+    bool sendTXT(uint8_t num, const uint8_t* payload, size_t length = 0) { return sendTXT(num, (uint8_t*) payload, length); }
+    bool sendTXT(uint8_t num, char* payload, size_t length = 0, bool headerToPayload = false) { return sendTXT(num, (uint8_t*) payload, length, headerToPayload); }
+    bool sendTXT(uint8_t num, const char* payload, size_t length = 0) { return sendTXT(num, (uint8_t*) payload, length); }
+    bool sendTXT(uint8_t num, const String& payload) { return send(num, false, payload.c_str(), payload.length()); }
+
+    bool broadcastTXT(uint8_t* payload, size_t length = 0, bool headerToPayload = false)
+    {
+      (void) headerToPayload;
+      if (length == 0) length = strlen((const char*) payload);
+      return broadcast(false, (const char*) payload, length);
+    }
+    bool broadcastTXT(const uint8_t* payload, size_t length = 0) { return broadcastTXT((uint8_t*) payload, length); }
+    bool broadcastTXT(char* payload, size_t length = 0, bool headerToPayload = false) { return broadcastTXT((uint8_t*) payload, length, headerToPayload); }
+    bool broadcastTXT(const char* payload, size_t length = 0) { return broadcastTXT((uint8_t*) payload, length); }
+    bool broadcastTXT(const String& payload) { return broadcast(false, payload.c_str(), payload.length()); }
+
+    bool sendBIN(uint8_t num, uint8_t* payload, size_t length, bool headerToPayload = false)
+    {
+      (void) headerToPayload;
+      return send(num, true, (const char*) payload, length);
+    }
+    bool sendBIN(uint8_t num, const uint8_t* payload, size_t length) { return sendBIN(num, (uint8_t*) payload, length); }
+
+    bool broadcastBIN(uint8_t* payload, size_t length, bool headerToPayload = false)
+    {
+      (void) headerToPayload;
+      return broadcast(true, (const char*) payload, length);
+    }
+    bool broadcastBIN(const uint8_t* payload, size_t length) { return broadcastBIN((uint8_t*) payload, length); }
+
+    bool sendPing(uint8_t num, const String& = "") { return num < WEBSOCKETS_SERVER_CLIENT_MAX && _clients[num].connected; }
+    bool broadcastPing(const String& = "") { return connectedClients() > 0; }
+
+    void disconnect()
+    {
+      for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) disconnect(i);
+    }
+    void disconnect(uint8_t num)
+    {
+      if (num < WEBSOCKETS_SERVER_CLIENT_MAX && _clients[num].connected) {
+        _clients[num].connected = false;
+        queue(num, WStype_DISCONNECTED, "", 0);
+      }
+    }
+
+    IPAddress remoteIP(uint8_t num) { return num < WEBSOCKETS_SERVER_CLIENT_MAX && _clients[num].connected ? IPAddress(127, 0, 0, 1) : IPAddress(); }
+
+    int connectedClients(bool ping = false)
+    {
+      (void) ping;
+      int count = 0;
+      for (auto& client : _clients) count += client.connected;
+      return count;
+    }
+
+    // host: open a client, delivered as WStype_CONNECTED on the next loop()
+    int hostConnect()
+    {
+      for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+        if (!_clients[i].reserved) {
+          _clients[i] = Client();
+          _clients[i].reserved = true;
+          queue(i, WStype_CONNECTED, "/", 1);
+          return i;
+        }
+      }
+      return -1;
+    }
+    void hostDisconnect(uint8_t num)
+    {
+      if (num < WEBSOCKETS_SERVER_CLIENT_MAX && _clients[num].reserved) queue(num, WStype_DISCONNECTED, "", 0);
+    }
+    void hostSendTXT(uint8_t num, const String& text) { queue(num, WStype_TEXT, text.c_str(), text.length()); }
+    void hostSendBIN(uint8_t num, const uint8_t* data, size_t length) { queue(num, WStype_BIN, (const char*) data, length); }
+
+    // host: frames sent to a client since the last call
+    std::vector<Frame> hostTake(uint8_t num)
+    {
+      std::vector<Frame> frames;
+      if (num < WEBSOCKETS_SERVER_CLIENT_MAX) frames.swap(_clients[num].frames);
+      return frames;
+    }
+    // host: total bytes sent to a client
+    size_t hostBytesSent(uint8_t num) { return num < WEBSOCKETS_SERVER_CLIENT_MAX ? _clients[num].bytesSent : 0; }
+
+  private:
+    struct Client {
+      bool reserved = false;
+      bool connected = false;
+      std::vector<Frame> frames;
+      size_t bytesSent = 0;
+    };
+
+    struct Event {
+      uint8_t num;
+      WStype_t type;
+      std::string payload; // always NUL terminated, like the library's buffers
+    };
+
+    uint16_t _port;
+    WebSocketServerEvent _cbEvent;
+    Client _clients[WEBSOCKETS_SERVER_CLIENT_MAX];
+    std::deque<Event> _events;
+
+    void queue(uint8_t num, WStype_t type, const char* payload, size_t length)
+    {
+      Event event;
+      event.num = num;
+      event.type = type;
+      event.payload.assign(payload, length);
+      event.payload.push_back('\0');
+      _events.push_back(event);
+    }
+
+    bool send(uint8_t num, bool binary, const char* payload, size_t length)
+    {
+      if (num >= WEBSOCKETS_SERVER_CLIENT_MAX || !_clients[num].connected) return false;
+      _clients[num].frames.push_back(Frame { binary, std::string(payload, length) });
+      _clients[num].bytesSent += length;
+      return true;
+    }
+
+    bool broadcast(bool binary, const char* payload, size_t length)
+    {
+      bool ret = true;
+      for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+        if (_clients[i].connected) ret &= send(i, binary, payload, length);
+      }
+      return ret;
+    }
+};
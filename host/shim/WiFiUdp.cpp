@@ -0,0 +1,158 @@
+#include "WiFiUdp.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+bool WiFiUDP::open()
+{
+  if (fd >= 0) return true;
+
+  fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) return false;
+
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+  setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one));
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return true;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port)
+{
+  stop();
+  if (!open()) return 0;
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+    stop();
+    return 0;
+  }
+
+  socklen_t len = sizeof(addr);
+  getsockname(fd, (struct sockaddr*) &addr, &len);
+  _localPort = ntohs(addr.sin_port);
+  return 1;
+}
+
+uint8_t WiFiUDP::beginMulticast(IPAddress interfaceAddr, IPAddress multicast, uint16_t port)
+{
+  if (!begin(port)) return 0;
+
+  struct ip_mreq mreq = {};
+  mreq.imr_multiaddr.s_addr = (uint32_t) multicast;
+  mreq.imr_interface.s_addr = interfaceAddr.isSet() ? (uint32_t) interfaceAddr : htonl(INADDR_ANY);
+  if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+    // no multicast route (e.g. a sandbox with only loopback): try loopback explicitly
+    mreq.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+    setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
+  }
+  return 1;
+}
+
+void WiFiUDP::stop()
+{
+  if (fd >= 0) close(fd);
+  fd = -1;
+  _localPort = 0;
+  rx.clear();
+  rxPos = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+  if (!open()) return 0;
+  tx.clear();
+  txIP = ip;
+  txPort = port;
+  txMulticast = false;
+  return 1;
+}
+
+int WiFiUDP::beginPacket(const char* host, uint16_t port)
+{
+  IPAddress ip;
+  if (!ip.fromString(host)) return 0;
+  return beginPacket(ip, port);
+}
+
+int WiFiUDP::beginPacketMulticast(IPAddress multicastAddress, uint16_t port, IPAddress interfaceAddress, int ttl)
+{
+  if (!beginPacket(multicastAddress, port)) return 0;
+
+  unsigned char t = ttl;
+  unsigned char loop = 1;
+  setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &t, sizeof(t));
+  setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+  if (interfaceAddress.isSet()) {
+    struct in_addr iface;
+    iface.s_addr = (uint32_t) interfaceAddress;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+  }
+  txMulticast = true;
+  return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t* buffer, size_t size)
+{
+  tx.insert(tx.end(), buffer, buffer + size);
+  return size;
+}
+
+int WiFiUDP::endPacket()
+{
+  if (fd < 0) return 0;
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = (uint32_t) txIP;
+  addr.sin_port = htons(txPort);
+  ssize_t sent = sendto(fd, tx.data(), tx.size(), 0, (struct sockaddr*) &addr, sizeof(addr));
+
+  if (sent < 0 && txMulticast) {
+    // no multicast route: fall back to the loopback interface
+    struct in_addr iface;
+    iface.s_addr = htonl(INADDR_LOOPBACK);
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+    sent = sendto(fd, tx.data(), tx.size(), 0, (struct sockaddr*) &addr, sizeof(addr));
+  }
+
+  tx.clear();
+  return sent >= 0 ? 1 : 0;
+}
+
+int WiFiUDP::parsePacket()
+{
+  if (fd < 0 || _localPort == 0) return 0;
+
+  uint8_t buffer[2048];
+  struct sockaddr_in addr = {};
+  socklen_t len = sizeof(addr);
+  ssize_t n = recvfrom(fd, buffer, sizeof(buffer), 0, (struct sockaddr*) &addr, &len);
+  if (n <= 0) {
+    rx.clear();
+    rxPos = 0;
+    return 0;
+  }
+
+  rx.assign(buffer, buffer + n);
+  rxPos = 0;
+  _remoteIP = IPAddress((uint32_t) addr.sin_addr.s_addr);
+  _remotePort = ntohs(addr.sin_port);
+  _destinationIP = IPAddress(127, 0, 0, 1);
+  return (int) n;
+}
+
+int WiFiUDP::read(unsigned char* buffer, size_t len)
+{
+  size_t n = std::min(len, rx.size() - rxPos);
+  memcpy(buffer, rx.data() + rxPos, n);
+  rxPos += n;
+  return (int) n;
+}
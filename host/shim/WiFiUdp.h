@@ -0,0 +1,58 @@
+// Host stand-in for WiFiUDP on top of non-blocking BSD sockets, so two
+// host instances can talk to each other (and to real devices) over UDP,
+// including multicast on the loopback interface.
+
+#pragma once
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#include <vector>
+
+class WiFiUDP : public Stream {
+  public:
+    WiFiUDP() {}
+    ~WiFiUDP() { stop(); }
+    WiFiUDP(const WiFiUDP&) = delete;
+    WiFiUDP& operator=(const WiFiUDP&) = delete;
+
+    uint8_t begin(uint16_t port);
+    uint8_t beginMulticast(IPAddress interfaceAddr, IPAddress multicast, uint16_t port);
+    void stop();
+
+    int beginPacket(IPAddress ip, uint16_t port);
+    int beginPacket(const char* host, uint16_t port);
+    int beginPacketMulticast(IPAddress multicastAddress, uint16_t port, IPAddress interfaceAddress, int ttl = 1);
+    int endPacket();
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    int parsePacket();
+    int available() override { return (int)(rx.size() - rxPos); }
+    int read() override { return rxPos < rx.size() ? rx[rxPos++] : -1; }
+    int read(unsigned char* buffer, size_t len);
+    int read(char* buffer, size_t len) { return read((unsigned char*) buffer, len); }
+    int peek() override { return rxPos < rx.size() ? rx[rxPos] : -1; }
+    void flush() { rxPos = rx.size(); }
+
+    IPAddress remoteIP() { return _remoteIP; }
+    uint16_t remotePort() { return _remotePort; }
+    IPAddress destinationIP() { return _destinationIP; }
+    uint16_t localPort() { return _localPort; }
+
+  private:
+    int fd = -1;
+    uint16_t _localPort = 0;
+    std::vector<uint8_t> rx;
+    size_t rxPos = 0;
+    std::vector<uint8_t> tx;
+    IPAddress txIP;
+    uint16_t txPort = 0;
+    bool txMulticast = false;
+    IPAddress _remoteIP;
+    uint16_t _remotePort = 0;
+    IPAddress _destinationIP;
+
+    bool open();
+};
@@ -0,0 +1,41 @@
+// Host stand-in for the ESP8266 NONOS SDK's user_interface.h / spi_flash.h.
+
+#pragma once
+
+// sketches include this inside extern "C" { }
+extern "C++" {
+
+#include "Arduino.h"
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+typedef enum {
+  SPI_FLASH_RESULT_OK,
+  SPI_FLASH_RESULT_ERR,
+  SPI_FLASH_RESULT_TIMEOUT
+} SpiFlashOpResult;
+
+inline uint32_t system_get_free_heap_size() { return ESP.getFreeHeap(); }
+inline uint8_t system_get_boot_version() { return 31; }
+inline uint8_t system_get_cpu_freq() { return F_CPU / 1000000L; }
+inline const char* system_get_sdk_version() { return "host"; }
+inline uint32_t system_get_chip_id() { return ESP.getChipId(); }
+inline uint32_t system_get_time() { return micros(); }
+inline uint32_t spi_flash_get_id() { return 0x1640ef; }
+
+inline SpiFlashOpResult spi_flash_erase_sector(uint16_t sec)
+{
+  return ESP.flashEraseSector(sec) ? SPI_FLASH_RESULT_OK : SPI_FLASH_RESULT_ERR;
+}
+
+inline SpiFlashOpResult spi_flash_write(uint32_t des_addr, uint32_t* src_addr, uint32_t size)
+{
+  return ESP.flashWrite(des_addr, src_addr, size) ? SPI_FLASH_RESULT_OK : SPI_FLASH_RESULT_ERR;
+}
+
+inline SpiFlashOpResult spi_flash_read(uint32_t src_addr, uint32_t* des_addr, uint32_t size)
+{
+  return ESP.flashRead(src_addr, des_addr, size) ? SPI_FLASH_RESULT_OK : SPI_FLASH_RESULT_ERR;
+}
+
+}
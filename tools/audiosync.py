@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""Audio sync over loopback: a master and a slave host instance.
+
+Needs the host build (see CMakeLists.txt) of a sketch with AudioSync.h.
+Starts the sketch as a slave, and once it is listening, again as a master
+for FRAMES frames; the slave runs a second longer, to play out all the
+master sent.  Both pace their frames to the wall clock, so this takes
+about that long.
+
+  audiosync.py build-host/esp8266-fastled-audio data
+  audiosync.py build-host/esp8266-fastled-audio data --frames 600
+
+Each prints its sync counters at the end (see host/runner.cpp).  On
+loopback nothing should go missing: the slave must have received every
+packet the master sent, with none late, lost or concealed, and heard as
+many beats as the master detected.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+MASTER = re.compile(r'audio sync master: (\d+) sent, (\d+) beats')
+SLAVE = re.compile(r'audio sync slave: (\d+) received, (\d+) late, (\d+) lost, (\d+) concealed, (\d+) beats')
+
+
+def counters(pattern, output, name):
+    match = pattern.search(output)
+    if not match:
+        sys.exit(f'{name}: no sync counters in its output:\n{output}')
+    return [int(value) for value in match.groups()]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('sketch', help='host build of the sketch')
+    parser.add_argument('data', help="the sketch's SPIFFS directory")
+    parser.add_argument('--frames', type=int, default=360, help="the master's frames")
+    parser.add_argument('--fps', type=int, default=120)
+    args = parser.parse_args()
+
+    env = dict(os.environ, SPIFFS_ROOT=args.data)
+    common = ['--fps', str(args.fps)]
+    seconds = args.frames / args.fps
+
+    slave = subprocess.Popen([args.sketch, '--audio-sync', 'slave', '--frames', str(args.frames + args.fps)] + common,
+                             stdout=subprocess.PIPE, text=True, env=env)
+    try:
+        # the slave says so once its socket is open
+        ready = slave.stdout.readline()
+        if not ready.startswith('audio sync'):
+            sys.exit(f'slave: {ready!r}')
+
+        master = subprocess.run([args.sketch, '--audio-sync', 'master', '--frames', str(args.frames)] + common,
+                                capture_output=True, text=True, env=env, timeout=seconds + 30)
+        if master.returncode:
+            sys.exit(f'master exited with {master.returncode}:\n{master.stdout}{master.stderr}')
+
+        output = slave.communicate(timeout=seconds + 30)[0]
+        if slave.returncode:
+            sys.exit(f'slave exited with {slave.returncode}:\n{output}')
+    finally:
+        if slave.poll() is None:
+            slave.kill()
+
+    sent, master_beats = counters(MASTER, master.stdout, 'master')
+    received, late, lost, concealed, slave_beats = counters(SLAVE, output, 'slave')
+
+    print(f'master: {sent} sent, {master_beats} beats')
+    print(f'slave:  {received} received, {late} late, {lost} lost, {concealed} concealed, {slave_beats} beats')
+
+    failures = []
+    if sent == 0:
+        failures.append('the master sent nothing')
+    if master_beats == 0:
+        failures.append('the master detected no beats')
+    if received != sent:
+        failures.append(f'the slave received {received} of {sent} packets')
+    if late or lost or concealed:
+        failures.append(f'{late} late, {lost} lost and {concealed} concealed on loopback')
+    if slave_beats != master_beats:
+        failures.append(f'the slave heard {slave_beats} beats of {master_beats}')
+
+    for failure in failures:
+        print(failure, file=sys.stderr)
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
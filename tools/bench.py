@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""Benchmark every pattern of the sketches on the host, and compare runs.
+
+Needs the host build (see CMakeLists.txt).  Each sketch runs every entry of
+its patterns[] for the same number of frames, with the same seed and the
+same made up beat (or a recording, --audio), and the pattern function
+alone is timed, frame by frame.
+
+  bench.py run build-host/esp8266-fastled-audio data \\
+               build-host/bloomv3audio bloomv3audio/data -o bench.json
+  bench.py compare baseline.json bench.json --threshold 10
+
+run takes pairs of a sketch's host executable and its data directory, and
+writes, per sketch and pattern:
+
+  ns_per_frame       median time of one call of the pattern function
+  pixels_per_second  LEDs drawn per second at that rate
+  static_ram_bytes   the size of the function's static variables, from nm;
+                     globals it shares with other patterns aren't counted,
+                     and pointers are host sized
+
+compare prints the patterns that got more than --threshold percent slower
+than in the baseline, and exits with 1 if there are any, for CI.
+
+The timings are for the machine they ran on; only compare runs from the
+same one.  /bench on the device gives cycles per frame (see Bench.h).
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+
+
+def static_variables(binary):
+    """{function offset: bytes of its static variables}, from nm"""
+    out = subprocess.run(['nm', '-C', '-S', '--defined-only', binary],
+                         check=True, capture_output=True, text=True).stdout
+    functions = {}
+    statics = {}
+    for line in out.splitlines():
+        m = re.match(r'^([0-9a-f]+) ([0-9a-f]+) ([a-zA-Z]) (.*)$', line)
+        if not m:
+            continue
+        address, size, kind, name = int(m.group(1), 16), int(m.group(2), 16), m.group(3), m.group(4)
+        if kind in 'tT':
+            functions[address] = name
+        elif kind in 'bBdDrR' and '::' in name and not name.startswith('guard variable'):
+            owner = name.split('::')[0]
+            statics[owner] = statics.get(owner, 0) + size
+    return {address: statics.get(name, 0) for address, name in functions.items()}
+
+
+def run(args):
+    if len(args.sketches) % 2:
+        sys.exit('run: give each sketch with its data directory')
+
+    results = {}
+    for binary, data in zip(args.sketches[::2], args.sketches[1::2]):
+        name = os.path.basename(binary)
+        command = [binary, '--bench', '--frames', str(args.frames), '--seed', str(args.seed), '--audio', args.audio]
+        env = dict(os.environ, SPIFFS_ROOT=data)
+        result = json.loads(subprocess.run(command, check=True, capture_output=True, text=True, env=env).stdout)
+        print('%s: %d patterns x %d frames, %d LEDs' % (name, len(result['patterns']), args.frames, result['leds']))
+
+        statics = static_variables(binary)
+        for pattern in result['patterns']:
+            pattern['static_ram_bytes'] = statics.get(int(pattern.pop('function'), 16), 0)
+            print('  %3d %-32s %10d ns/frame %12d pixels/s %6d bytes' % (
+                pattern['index'], pattern['name'], pattern['ns_per_frame'], pattern['pixels_per_second'],
+                pattern['static_ram_bytes']))
+        results[name] = result
+
+    with open(args.output, 'w') as f:
+        json.dump({'sketches': results}, f, indent=1)
+        f.write('\n')
+    print('%s written' % args.output)
+
+
+def compare(args):
+    with open(args.baseline) as f:
+        baseline = json.load(f)['sketches']
+    with open(args.current) as f:
+        current = json.load(f)['sketches']
+
+    slower = 0
+    for sketch, result in current.items():
+        # some patterns are in the list twice
+        before = {(p['index'], p['name']): p for p in baseline.get(sketch, {}).get('patterns', [])}
+        for pattern in result['patterns']:
+            old = before.get((pattern['index'], pattern['name']))
+            if not old or not old['ns_per_frame']:
+                continue
+            change = 100.0 * (pattern['ns_per_frame'] - old['ns_per_frame']) / old['ns_per_frame']
+            if change > args.threshold:
+                slower += 1
+                print('%s: %s %d -> %d ns/frame, %+.1f%%' % (
+                    sketch, pattern['name'], old['ns_per_frame'], pattern['ns_per_frame'], change))
+
+    if slower:
+        print('%d patterns more than %g%% slower' % (slower, args.threshold))
+        sys.exit(1)
+    print('no pattern more than %g%% slower' % args.threshold)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    p = commands.add_parser('run')
+    p.add_argument('sketches', nargs='+', metavar='SKETCH DATA')
+    p.add_argument('-o', '--output', default='bench.json')
+    p.add_argument('--frames', type=int, default=1000)
+    p.add_argument('--seed', type=int, default=1)
+    p.add_argument('--audio', default='beat')
+    p.set_defaults(func=run)
+
+    p = commands.add_parser('compare')
+    p.add_argument('baseline')
+    p.add_argument('current')
+    p.add_argument('--threshold', type=float, default=10, help='percent')
+    p.set_defaults(func=compare)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
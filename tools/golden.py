@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""Golden frames: check that the patterns still draw what they drew.
+
+Needs the host build (see CMakeLists.txt).  Host runs are deterministic:
+the clock is virtual and starts at 0, random8/16 and random() are seeded,
+and the MSGEQ7 hears the same made up beat every time.  Each pattern is run
+in a process of its own, so it doesn't start from what the one before it
+left behind.
+
+  golden.py record build-host/bloomv3audio bloomv3audio/data host/golden
+  golden.py check build-host/bloomv3audio bloomv3audio/data host/golden
+  golden.py record ... /tmp/before --frames-too     keep the frames as well
+  golden.py check ... /tmp/before --tolerance 2     allow off by 2
+
+record writes STORE/<sketch>.json: a FNV-1a hash of every frame of every
+pattern.  With --frames-too the frames themselves are kept too, gzipped, in
+STORE/<sketch>/<index>.rgb.gz.
+
+check runs the patterns again and compares.  A pattern whose hashes all
+match is the same bit for bit.  When they don't, and the frames were kept,
+it reports the largest difference of any one channel of any LED, and the
+pattern passes if that is within --tolerance; without the frames it can
+only say which frame was the first to differ.  Patterns that are new since
+the store was recorded are listed and not checked.
+
+host/golden has the hashes for all the sketches, checked by ctest.  After
+changing what a pattern draws on purpose, record them again.  Some
+patterns use float, so other CPUs or compilers may round differently.
+"""
+
+import argparse
+import gzip
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def patterns(binary):
+    """[(index, name)]"""
+    out = subprocess.run([binary, '--list'], check=True, capture_output=True, text=True).stdout
+    return [(int(index), name) for index, name in (line.split('\t', 1) for line in out.splitlines())]
+
+
+def keys(entries):
+    """(name, n) for each (index, name): the nth pattern with that name, as
+    some are in the list twice and the indexes move when one is added"""
+    seen = {}
+    result = []
+    for index, name in entries:
+        seen[name] = seen.get(name, 0) + 1
+        result.append((name, seen[name]))
+    return result
+
+
+def render(args, index):
+    """the frames of one pattern, as a list of bytes"""
+    with tempfile.TemporaryDirectory() as directory:
+        out = os.path.join(directory, 'frames.rgb')
+        subprocess.run([args.sketch, '--pattern', str(index), '--frames', str(args.frames), '--fps', str(args.fps),
+                        '--seed', str(args.seed), '--audio', args.audio, '--out', out],
+                       check=True, capture_output=True, env=dict(os.environ, SPIFFS_ROOT=args.data))
+        with open(out, 'rb') as f:
+            data = f.read()
+    size = len(data) // args.frames
+    return [data[i * size:(i + 1) * size] for i in range(args.frames)]
+
+
+def store_path(args):
+    return os.path.join(args.store, os.path.basename(args.sketch) + '.json')
+
+
+def frames_path(args, index):
+    return os.path.join(args.store, os.path.basename(args.sketch), '%d.rgb.gz' % index)
+
+
+def record(args):
+    entries = patterns(args.sketch)
+    os.makedirs(args.store, exist_ok=True)
+    if args.frames_too:
+        os.makedirs(os.path.dirname(frames_path(args, 0)), exist_ok=True)
+
+    lines = []
+    for index, name in entries:
+        frames = render(args, index)
+        hashes = ['%08x' % fnv1a(frame) for frame in frames]
+        lines.append(json.dumps({'index': index, 'name': name, 'hashes': hashes}))
+        if args.frames_too:
+            with gzip.open(frames_path(args, index), 'wb', 9) as f:
+                f.write(b''.join(frames))
+
+    with open(store_path(args), 'w') as f:
+        header = {'frames': args.frames, 'fps': args.fps, 'seed': args.seed, 'audio': args.audio}
+        # one pattern a line, for diffs
+        f.write(json.dumps(header)[:-1] + ', "patterns": [\n' + ',\n'.join(lines) + '\n]}\n')
+    print('%s: %d patterns x %d frames' % (store_path(args), len(entries), args.frames))
+
+
+def compare(frames, golden):
+    """(largest difference of one channel, pixels that differ)"""
+    worst = 0
+    pixels = 0
+    for frame, old in zip(frames, golden):
+        for i in range(0, min(len(frame), len(old)), 3):
+            difference = max(abs(frame[i + c] - old[i + c]) for c in range(3))
+            if difference:
+                worst = max(worst, difference)
+                pixels += 1
+    return worst, pixels
+
+
+def check(args):
+    with open(store_path(args)) as f:
+        store = json.load(f)
+    args.frames, args.fps, args.seed, args.audio = store['frames'], store['fps'], store['seed'], store['audio']
+    golden = dict(zip(keys((p['index'], p['name']) for p in store['patterns']), store['patterns']))
+
+    entries = patterns(args.sketch)
+    failed = 0
+    for (index, name), key in zip(entries, keys(entries)):
+        old = golden.pop(key, None)
+        if not old:
+            print('  %3d %-32s new, not checked' % (index, name))
+            continue
+
+        frames = render(args, index)
+        hashes = ['%08x' % fnv1a(frame) for frame in frames]
+        if hashes == old['hashes']:
+            continue
+
+        first = next(i for i, (a, b) in enumerate(zip(hashes, old['hashes'])) if a != b)
+        path = frames_path(args, old['index'])
+        if not os.path.exists(path):
+            print('  %3d %-32s differs from frame %d' % (index, name, first))
+            failed += 1
+            continue
+
+        with gzip.open(path, 'rb') as f:
+            data = f.read()
+        size = len(data) // args.frames
+        worst, pixels = compare(frames, [data[i * size:(i + 1) * size] for i in range(args.frames)])
+        ok = worst <= args.tolerance
+        print('  %3d %-32s differs from frame %d: %d pixels, at most %d per channel%s' % (
+            index, name, first, pixels, worst, '' if ok else ', more than %d' % args.tolerance))
+        if not ok:
+            failed += 1
+
+    for name, n in golden:
+        print('  %s (%d) is gone' % (name, n))
+
+    print('%s: %d patterns, %d differ' % (os.path.basename(args.sketch), len(entries), failed))
+    if failed:
+        sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    p = commands.add_parser('record')
+    p.add_argument('sketch')
+    p.add_argument('data')
+    p.add_argument('store')
+    p.add_argument('--frames', type=int, default=60)
+    p.add_argument('--fps', type=int, default=30)
+    p.add_argument('--seed', type=int, default=1)
+    p.add_argument('--audio', default='beat')
+    p.add_argument('--frames-too', action='store_true')
+    p.set_defaults(func=record)
+
+    p = commands.add_parser('check')
+    p.add_argument('sketch')
+    p.add_argument('data')
+    p.add_argument('store')
+    p.add_argument('--tolerance', type=int, default=0, help='per channel')
+    p.set_defaults(func=check)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Pack the web app in a data directory into one /assets.bin for SPIFFS.
+
+The UI is about ten files, and the web server handles one client at a
+time, so loading it file by file over the AP takes seconds.  This gzips
+every web file (unless that doesn't make it smaller) and packs them into
+one bundle; the firmware (Assets.h) reads its directory at startup and
+serves each file from its offset in the bundle, already gzipped.
+
+  mkbundle.py                      data/ -> build/assets.bin
+  mkbundle.py bloomv3audio/data -o bloomv3audio/build/assets.bin
+  mkbundle.py --inline             also put the local CSS and JS that the
+                                   .htm pages load into the pages
+
+Format, little endian:
+
+  'AST1'  count (16 bits)  entry size (16 bits)
+  count entries:
+    path (32 bytes, NUL padded)  offset (32 bits)  size (32 bits)
+    FNV-1a hash of the payload (32 bits)  flags (8 bits, 1 = gzip)  3 bytes 0
+  payloads
+
+Files that aren't web assets (layout.bin and the like) are left out, as
+the firmware opens them by name; copy them next to the bundle.  Files
+already in SPIFFS under the same path win over the bundle, so one file
+can still be replaced with the /edit page.
+"""
+
+import argparse
+import gzip
+import os
+import re
+import struct
+
+MAGIC = b'AST1'
+ENTRY = struct.Struct('<32sIIIB3x')
+FLAG_GZIP = 0x01
+PATH_SIZE = 32  # SPIFFS_OBJ_NAME_LEN, NUL included
+WEB_TYPES = ('.htm', '.html', '.css', '.js', '.json', '.png', '.gif', '.jpg', '.ico', '.svg', '.xml',
+             '.eot', '.ttf', '.woff', '.woff2')
+
+
+def fnv1a(data):
+    """the hash Assets.h uses for ETags"""
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def inline(root, path, text):
+    """replace <link rel="stylesheet"> and <script src> of local files with their contents"""
+    base = os.path.dirname(path)
+
+    def local(ref):
+        if re.match(r'^([a-z]+:)?//', ref):
+            return None
+        full = os.path.join(root, ref.lstrip('/')) if ref.startswith('/') else os.path.join(base, ref)
+        return full if os.path.isfile(full) else None
+
+    def style(m):
+        full = local(m.group(1))
+        if not full:
+            return m.group(0)
+        with open(full, encoding='utf-8') as f:
+            css = f.read()
+        print('  %s: inlined %s' % (os.path.relpath(path, root), m.group(1)))
+        return '<style>\n%s\n</style>' % css
+
+    def script(m):
+        full = local(m.group(1))
+        if not full:
+            return m.group(0)
+        with open(full, encoding='utf-8') as f:
+            js = f.read()
+        if '</script' in js:
+            return m.group(0)
+        print('  %s: inlined %s' % (os.path.relpath(path, root), m.group(1)))
+        return '<script>\n%s\n</script>' % js
+
+    # only tags that aren't inside an HTML comment
+    parts = re.split(r'(<!--.*?-->)', text, flags=re.S)
+    for i in range(0, len(parts), 2):
+        parts[i] = re.sub(r'<link rel="stylesheet" href="([^"]+)">', style, parts[i])
+        parts[i] = re.sub(r'<script src="([^"]+)"></script>', script, parts[i])
+    return ''.join(parts)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('data', nargs='?', default='data')
+    parser.add_argument('-o', '--output', default='build/assets.bin')
+    parser.add_argument('--inline', action='store_true')
+    args = parser.parse_args()
+
+    files = []
+    for directory, _, names in os.walk(args.data):
+        for name in sorted(names):
+            full = os.path.join(directory, name)
+            path = '/' + os.path.relpath(full, args.data).replace(os.sep, '/')
+            if not name.endswith(WEB_TYPES):
+                print('  %s: not a web file, left out' % path)
+                continue
+            if len(path) >= PATH_SIZE:
+                print('  %s: name too long for SPIFFS, left out' % path)
+                continue
+            files.append((path, full))
+    files.sort()
+
+    payloads = []
+    for path, full in files:
+        with open(full, 'rb') as f:
+            data = f.read()
+        if args.inline and path.endswith(('.htm', '.html')):
+            data = inline(args.data, full, data.decode('utf-8')).encode('utf-8')
+        # mtime 0, so the same files give the same bundle and ETags
+        packed = gzip.compress(data, 9, mtime=0)
+        if len(packed) < len(data):
+            payloads.append((path, len(data), packed, FLAG_GZIP))
+        else:
+            payloads.append((path, len(data), data, 0))  # fonts and images already are
+
+    offset = len(MAGIC) + 4 + ENTRY.size * len(payloads)
+    directory = bytearray()
+    for path, _, payload, flags in payloads:
+        directory += ENTRY.pack(path.encode(), offset, len(payload), fnv1a(payload), flags)
+        offset += len(payload)
+
+    os.makedirs(os.path.dirname(args.output) or '.', exist_ok=True)
+    with open(args.output, 'wb') as f:
+        f.write(MAGIC + struct.pack('<HH', len(payloads), ENTRY.size))
+        f.write(directory)
+        for _, _, payload, _ in payloads:
+            f.write(payload)
+
+    original = sum(size for _, size, _, _ in payloads)
+    print('%s: %d files, %d bytes (%d before gzip)' % (args.output, len(payloads), offset, original))
+
+
+if __name__ == '__main__':
+    main()
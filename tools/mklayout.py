@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Make a /layout.bin for the sketches' SPIFFS data directory.
+
+The format is described at the top of Layout.h.  Angle and radius are
+worked out here from the full-precision coordinates, so the firmware only
+has to load them.
+
+  mklayout.py grid 38 8 [--serpentine]   a matrix wired row by row
+  mklayout.py strip 144                  a straight strip, centre at the middle
+  mklayout.py bloom                      the 30 LED bloom from bloomv3audio/Map.h
+  mklayout.py csv points.csv             one "x,y[,z[,group]]" line per LED,
+                                         in wiring order, any units
+
+The output goes to data/layout.bin unless -o is given.  Upload it with the
+/edit page or bloomv3audio/uploadfile.sh and reboot.
+"""
+
+import argparse
+import math
+import struct
+
+MAGIC = b'LAY1'
+
+BLOOM_ANGLES = [0, 51, 102, 154, 205, 26, 77, 128, 179, 230, 13, 38, 64, 90, 115,
+                141, 166, 192, 218, 243, 0, 51, 102, 154, 205, 26, 77, 128, 179, 230]
+
+
+def polar(points):
+    """angle (0-255) and radius (0-255) of each (x, y) about the bounding box centre"""
+    xs = [p[0] for p in points]
+    ys = [p[1] for p in points]
+    cx = (min(xs) + max(xs)) / 2.0
+    cy = (min(ys) + max(ys)) / 2.0
+    distances = [math.hypot(x - cx, y - cy) for x, y in points]
+    far = max(distances)
+    angles = [int(math.floor(math.atan2(y - cy, x - cx) * 128 / math.pi + 0.5)) & 0xFF for x, y in points]
+    radii = [int(math.floor(d * 255 / far + 0.5)) if far > 0 else 0 for d in distances]
+    return angles, radii
+
+
+def scale(values):
+    """map values onto 0-255"""
+    low, high = min(values), max(values)
+    if high == low:
+        return [0 for _ in values]
+    return [int(math.floor((v - low) * 255 / (high - low) + 0.5)) for v in values]
+
+
+def grid(width, height, serpentine):
+    leds = [None] * (width * height)
+    for y in range(height):
+        for x in range(width):
+            i = y * width + ((width - 1 - x) if serpentine and y & 1 else x)
+            leds[i] = (x, y, 0, y)
+    return width, height, leds, [(x, y) for x, y, _, _ in leds]
+
+
+def strip(count):
+    xs = scale(range(count))
+    leds = [(x, 0, 0, 0) for x in xs]
+    return 0, 0, leds, [(i, 0) for i in range(count)]
+
+
+def bloom():
+    # the tables from bloomv3audio/Map.h
+    levels = [0] * 5 + [1] * 5 + [2] * 10 + [3] * 5 + [4] * 5
+    z = [0] * 5 + [64] * 5 + [128] * 10 + [192] * 5 + [255] * 5
+    angles = BLOOM_ANGLES
+    # icosidodecahedron rings, relative to the widest
+    ring = [134, 217, 255, 217, 134]
+    points = [(math.cos(a * math.pi / 128) * ring[l] / 2, math.sin(a * math.pi / 128) * ring[l] / 2)
+              for a, l in zip(angles, levels)]
+    leds = [(int(128 + px), int(128 + py), zz, l) for (px, py), zz, l in zip(points, z, levels)]
+    return 0, 0, leds, points
+
+
+def csv(path):
+    rows = []
+    with open(path) as f:
+        for line in f:
+            line = line.split('#')[0].strip()
+            if line:
+                rows.append([float(v) for v in line.split(',')])
+    xs = scale([r[0] for r in rows])
+    ys = scale([r[1] for r in rows])
+    zs = scale([r[2] if len(r) > 2 else 0 for r in rows])
+    groups = [int(r[3]) if len(r) > 3 else 0 for r in rows]
+    return 0, 0, list(zip(xs, ys, zs, groups)), [(r[0], r[1]) for r in rows]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('-o', '--output', default='data/layout.bin')
+    sub = parser.add_subparsers(dest='kind', required=True)
+    p = sub.add_parser('grid')
+    p.add_argument('width', type=int)
+    p.add_argument('height', type=int)
+    p.add_argument('--serpentine', action='store_true')
+    p = sub.add_parser('strip')
+    p.add_argument('count', type=int)
+    sub.add_parser('bloom')
+    p = sub.add_parser('csv')
+    p.add_argument('path')
+    args = parser.parse_args()
+
+    if args.kind == 'grid':
+        width, height, leds, points = grid(args.width, args.height, args.serpentine)
+    elif args.kind == 'strip':
+        width, height, leds, points = strip(args.count)
+    elif args.kind == 'bloom':
+        width, height, leds, points = bloom()
+    else:
+        width, height, leds, points = csv(args.path)
+
+    angles, radii = polar(points)
+    if args.kind == 'bloom':
+        # keep Map.h's exact angles, as the firmware's built-in layout does
+        angles = BLOOM_ANGLES
+
+    with open(args.output, 'wb') as f:
+        f.write(MAGIC + struct.pack('<HBB4x', len(leds), width, height))
+        for (x, y, z, group), angle, radius in zip(leds, angles, radii):
+            f.write(struct.pack('6B', x, y, z, angle, radius, group))
+
+    print('%s: %d LEDs' % (args.output, len(leds)))
+
+
+if __name__ == '__main__':
+    main()
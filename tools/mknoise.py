@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""Make a /noise.bin for the main sketch's SPIFFS data directory.
+
+The format is described at the top of NoiseVariants.h.  Each line of the
+input replaces one of the noise patterns:
+
+  # pattern         palette  speedX    speedY  speedZ  scale  scaleBand  hueReduce  flags
+  fireAudioNoise    heat     band0     0       band6   50     0          60         loop
+  lavaNoise         lava     40        0       band6>>2 50    0          0          -
+
+A speed or scaleBand is a number from 0 to 127, or bandN, the level of band
+N (0-6), or bandN>>S, the level shifted right by S.  flags is "loop" to
+rotate the palette over time, or "-".  Up to 8 patterns; the others keep the
+values built into the firmware.
+
+  mknoise.py noise.txt                 writes data/noise.bin
+  mknoise.py noise.txt -o /tmp/n.bin
+
+Upload it with the /edit page and reboot.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = b'NSE1'
+MAX_VARIANTS = 8
+
+# NoiseVariantId, in order
+VARIANTS = [
+    'rainbowAudioNoise', 'rainbowStripeAudioNoise', 'partyAudioNoise', 'forestAudioNoise', 'cloudAudioNoise',
+    'fireAudioNoise', 'lavaAudioNoise', 'oceanAudioNoise', 'blackAndWhiteAudioNoise', 'blackAndBlueAudioNoise',
+    'rainbowNoise', 'rainbowStripeNoise', 'partyNoise', 'forestNoise', 'cloudNoise',
+    'fireNoise', 'lavaNoise', 'oceanNoise', 'blackAndWhiteNoise', 'blackAndBlueNoise',
+]
+
+# NoisePalette, in order
+PALETTES = ['rainbow', 'rainbowstripe', 'party', 'forest', 'cloud', 'heat', 'lava', 'ocean',
+            'blackandwhite', 'blackandblue']
+
+COLOR_LOOP = 0x01
+
+
+def amount(text):
+    match = re.fullmatch(r'band([0-6])(?:>>([0-7]))?', text)
+    if match:
+        return 0x80 | (int(match.group(2) or 0) << 4) | int(match.group(1))
+    value = int(text)
+    if not 0 <= value <= 127:
+        raise ValueError('%s is not 0 to 127 or a band' % text)
+    return value
+
+
+def byte(text):
+    value = int(text)
+    if not 0 <= value <= 255:
+        raise ValueError('%s is not 0 to 255' % text)
+    return value
+
+
+def parse(path):
+    records = []
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            fields = line.split('#')[0].split()
+            if not fields:
+                continue
+            try:
+                if len(fields) != 9:
+                    raise ValueError('expected 9 fields, not %d' % len(fields))
+                name, palette, x, y, z, scale, scale_band, hue_reduce, flags = fields
+                if name not in VARIANTS:
+                    raise ValueError('no noise pattern called %s' % name)
+                if palette.lower() not in PALETTES:
+                    raise ValueError('no palette called %s; there are %s' % (palette, ', '.join(PALETTES)))
+                if flags not in ('loop', '-'):
+                    raise ValueError('flags is "loop" or "-"')
+                records.append(struct.pack('9B', VARIANTS.index(name), PALETTES.index(palette.lower()),
+                                           amount(x), amount(y), amount(z), byte(scale), amount(scale_band),
+                                           byte(hue_reduce), COLOR_LOOP if flags == 'loop' else 0))
+            except ValueError as e:
+                sys.exit('%s:%d: %s' % (path, number, e))
+    if len(records) > MAX_VARIANTS:
+        sys.exit('%s: %d patterns, the firmware keeps %d' % (path, len(records), MAX_VARIANTS))
+    return records
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('input')
+    parser.add_argument('-o', '--output', default='data/noise.bin')
+    args = parser.parse_args()
+
+    records = parse(args.input)
+    with open(args.output, 'wb') as f:
+        f.write(MAGIC + struct.pack('<B3x', len(records)))
+        for record in records:
+            f.write(record)
+
+    print('%s: %d noise patterns' % (args.output, len(records)))
+
+
+if __name__ == '__main__':
+    main()
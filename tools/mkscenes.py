@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""Make a /scenes.bin, the autoplay playlist, for the main sketch's SPIFFS.
+
+The format is described at the top of Scenes.h.  The input has a scene a
+line: the pattern, by its index, its function or its name as in the web
+app, then any of
+
+  palette=N        index in palettes[], or its name
+  brightness=N     share of the brightness setting, 0-255 (255)
+  duration=N       seconds, 0 for the autoplay duration field (0)
+  weight=N         for a weighted playlist, 0-255 (1)
+  on=drop,silence  end the scene early when the music drops or stops
+  <param>=N        one of the pattern's params, by its name in
+                   PatternParams.h less "Param": bandOffset=5, noiseZoom=60
+
+and a "mode ordered" or "mode weighted" line for the whole playlist:
+
+  mode weighted
+  "Spectrum Waves"   duration=30 weight=3 on=drop
+  fireAudioNoise     palette=Heat brightness=200 noiseZoom=60
+  audioFire2D        on=drop,silence
+
+Pattern, palette and param names are read from the sketch, so the indexes
+match the firmware they were read from.
+
+  mkscenes.py party.txt                 writes data/scenes.bin
+  mkscenes.py party.txt -o /tmp/s.bin
+
+Upload it with the /edit page and reboot; GET /scenes shows what loaded.
+"""
+
+import argparse
+import os
+import re
+import shlex
+import struct
+import sys
+
+MAGIC = b'SCN1'
+MAX_SCENES = 32
+KEEP = 255
+MODES = ['ordered', 'weighted']
+ADVANCE = {'drop': 0x01, 'silence': 0x02}
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+
+
+def table(source, start):
+    """the text between start and the next '};', comments removed"""
+    begin = source.index(start)
+    body = source[begin:source.index('};', begin)]
+    return re.sub(r'//[^\n]*', '', body)
+
+
+def read_sketch(path):
+    with open(path, encoding='latin-1') as f:
+        source = f.read()
+    patterns = re.findall(r'\{\s*(\w+)\s*,\s*"([^"]*)"\s*\}', table(source, 'PatternAndNameList patterns'))
+    palettes = re.findall(r'"([^"]*)"', table(source, 'paletteNames[paletteCount]'))
+    return patterns, palettes
+
+
+def read_params(path):
+    with open(path) as f:
+        source = f.read()
+    return [name[:-len('Param')] for name in re.findall(r'\b(\w+Param)\b', table(source, 'enum ParamId'))]
+
+
+def lookup(value, names, what):
+    if value.isdigit() and int(value) < len(names):
+        return int(value)
+    lowered = [n.lower() for n in names]
+    if value.lower() in lowered:
+        return lowered.index(value.lower())
+    raise ValueError('no %s %s' % (what, value))
+
+
+def parse(path, patterns, palettes, params):
+    mode = 0
+    scenes = []
+    functions = [f for f, _ in patterns]
+    names = [n for _, n in patterns]
+
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            fields = shlex.split(line, comments=True)
+            if not fields:
+                continue
+            try:
+                if fields[0] == 'mode':
+                    mode = lookup(fields[1], MODES, 'mode')
+                    continue
+
+                try:
+                    pattern = lookup(fields[0], functions, 'pattern')
+                except ValueError:
+                    pattern = lookup(fields[0], names, 'pattern')
+
+                palette, brightness, duration, weight, flags, param, value = KEEP, 255, 0, 1, 0, KEEP, 0
+                for option in fields[1:]:
+                    key, _, text = option.partition('=')
+                    if key == 'palette':
+                        palette = lookup(text, palettes, 'palette')
+                    elif key == 'on':
+                        for event in text.split(','):
+                            if event not in ADVANCE:
+                                raise ValueError('on is drop, silence or both')
+                            flags |= ADVANCE[event]
+                    elif key in ('brightness', 'duration', 'weight'):
+                        number_value = int(text)
+                        if not 0 <= number_value <= 255:
+                            raise ValueError('%s is 0 to 255' % key)
+                        if key == 'brightness':
+                            brightness = number_value
+                        elif key == 'duration':
+                            duration = number_value
+                        else:
+                            weight = number_value
+                    else:
+                        param = lookup(key, params, 'option or param')
+                        value = int(text)
+                        if not 0 <= value <= 255:
+                            raise ValueError('%s is 0 to 255' % key)
+
+                scenes.append(struct.pack('8B', pattern, palette, brightness, duration, weight, flags, param, value))
+            except (ValueError, IndexError) as e:
+                sys.exit('%s:%d: %s' % (path, number, e))
+
+    if len(scenes) > MAX_SCENES:
+        sys.exit('%s: %d scenes, the firmware keeps %d' % (path, len(scenes), MAX_SCENES))
+    return mode, scenes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('input')
+    parser.add_argument('-o', '--output', default='data/scenes.bin')
+    parser.add_argument('--sketch', default=os.path.join(ROOT, 'esp8266-fastled-audioD1.ino'))
+    parser.add_argument('--params', default=os.path.join(ROOT, 'PatternParams.h'))
+    args = parser.parse_args()
+
+    patterns, palettes = read_sketch(args.sketch)
+    mode, scenes = parse(args.input, patterns, palettes, read_params(args.params))
+
+    with open(args.output, 'wb') as f:
+        f.write(MAGIC + struct.pack('<BB2x', len(scenes), mode))
+        for scene in scenes:
+            f.write(scene)
+
+    print('%s: %d scenes, %s' % (args.output, len(scenes), MODES[mode]))
+
+
+if __name__ == '__main__':
+    main()